@@ -0,0 +1,75 @@
+#include <csignal>
+#include <iostream>
+#include <string>
+
+#include <memory>
+
+#include "engine/market_data_publisher.h"
+#include "engine/order_gateway.h"
+#include "io/reader.h"
+
+using namespace UBIEngine;
+
+namespace {
+OrderGateway* running_gateway = nullptr;
+
+void onSignal(int) {
+    if (running_gateway != nullptr) running_gateway->stop();
+}
+}  // namespace
+
+// 接收策略进程的实时订单（协议见 io/order_entry.h），按回放的规则撮合并回报。
+// 加上 --md 时，盘口变化以 UDP 行情发布（协议见 io/market_data.h）。
+// Usage: order_gateway <dataset_dir> [port] [--spin=<polls>] [--md=<ip>:<port>]
+//                      [--md-recovery=<port>]
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <dataset_dir> [port] [--spin=<polls>]"
+                  << " [--md=<ip>:<port>] [--md-recovery=<port>]" << std::endl;
+        return 1;
+    }
+    std::string dataset_dir = argv[1];
+    OrderGatewayOptions options;
+    options.port = 9090;
+    MarketDataOptions md_options;
+    bool publish = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--spin=", 0) == 0) {
+            options.spin = static_cast<uint32_t>(std::stoul(arg.substr(7)));
+        } else if (arg.rfind("--md=", 0) == 0) {
+            std::string address = arg.substr(5);
+            auto colon = address.rfind(':');
+            md_options.host = address.substr(0, colon);
+            md_options.port = static_cast<uint16_t>(std::stoi(address.substr(colon + 1)));
+            publish = true;
+        } else if (arg.rfind("--md-recovery=", 0) == 0) {
+            md_options.recovery_port = static_cast<uint16_t>(std::stoi(arg.substr(14)));
+        } else {
+            options.port = static_cast<uint16_t>(std::stoi(arg));
+        }
+    }
+    try {
+        auto prev_trade_infos = IO::read_prev_trade_info(dataset_dir + "/prev_trade_info");
+        std::unique_ptr<MarketDataPublisher> publisher;
+        if (publish) {
+            publisher = std::make_unique<MarketDataPublisher>(prev_trade_infos, md_options);
+            options.book_listener = publisher.get();
+            std::cout << "Publishing market data to " << md_options.host << ":" << md_options.port
+                      << ", recovery on port " << publisher->recoveryPort() << std::endl;
+        }
+        OrderGateway gateway(prev_trade_infos, options);
+        running_gateway = &gateway;
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        std::cout << "Serving " << prev_trade_infos.size() << " symbols on port "
+                  << gateway.port() << "..." << std::endl;
+        gateway.run();
+        running_gateway = nullptr;
+        std::cout << "Matched " << gateway.requests() << " requests." << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
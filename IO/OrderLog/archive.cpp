@@ -0,0 +1,69 @@
+// Converts a binary order_log file into the columnar archive of include/io/archive.h and checks
+// that the archive decodes to the events the replay derives from the raw rows.
+// Build: make order_log_archive
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "io/archive.h"
+
+using namespace UBIEngine;
+
+namespace {
+bool sameEvent(const IO::order_log& row, const char* instrument_id, const IO::order_event& event) {
+    return event.timestamp == row.timestamp && event.type == row.type &&
+           event.direction == (row.direction == 1 ? 1 : -1) && event.volume == row.volume &&
+           event.price_off_ticks == IO::priceOffTicks(row) &&
+           std::strncmp(instrument_id, row.instrument_id, 8) == 0;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 3 && argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <order_log> <archive> [block_records]" << std::endl;
+        return 1;
+    }
+    uint32_t block_records = argc == 4 ? std::stoul(argv[3]) : 1 << 16;
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t archive_bytes = IO::convertOrderLog(argv[1], argv[2], block_records);
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    IO::RecordFile<IO::order_log> rows(argv[1]);
+    IO::OrderArchive archive(argv[2]);
+    std::vector<IO::order_event> events;
+    size_t r = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < archive.blockCount(); ++b) {
+        events.resize(archive.block(b).count);
+        archive.decodeBlock(b, events.data());
+        for (const auto& event : events) {
+            if (r >= rows.size() ||
+                !sameEvent(rows[r], archive.instrumentId(event.instrument), event)) {
+                std::cerr << "Mismatch at row " << r << std::endl;
+                return 1;
+            }
+            ++r;
+        }
+    }
+    double decode_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (r != rows.size()) {
+        std::cerr << "Row count mismatch: " << r << " != " << rows.size() << std::endl;
+        return 1;
+    }
+
+    uint64_t raw_bytes = rows.size() * sizeof(IO::order_log);
+    std::printf("rows=%zu instruments=%zu blocks=%zu\n", rows.size(), archive.dictionarySize(),
+                archive.blockCount());
+    std::printf("raw=%lu bytes archive=%lu bytes ratio=%.1fx (%.2f bytes/row)\n", raw_bytes,
+                archive_bytes, archive_bytes ? static_cast<double>(raw_bytes) / archive_bytes : 0,
+                rows.empty() ? 0 : static_cast<double>(archive_bytes) / rows.size());
+    std::printf("convert=%.3fs decode=%.3fs (%.0f rows/s), verified\n", seconds, decode_seconds,
+                decode_seconds > 0 ? rows.size() / decode_seconds : 0);
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Prints the order_log and alpha records of one instrument of a date, found through the
+// per-symbol index instead of a scan of the whole files.
+// Build: make order_log_symbol
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "io/reader.h"
+#include "io/symbol_index.h"
+
+using namespace UBIEngine;
+
+int main(int argc, char* argv[]) {
+    if (argc != 3 && argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <dataset_dir> <instrument_id> [count]" << std::endl;
+        return 1;
+    }
+    std::string dataset_dir = argv[1];
+    long limit = argc == 4 ? std::stol(argv[3]) : 100;
+
+    IO::RecordFile<IO::prev_trade_info> prev_trade_infos(dataset_dir + "/prev_trade_info");
+    IO::RecordFile<IO::order_log> order_logs(dataset_dir + "/order_log");
+    IO::RecordFile<IO::alpha> alphas(dataset_dir + "/alpha");
+
+    auto start = std::chrono::steady_clock::now();
+    IO::SymbolTable symbols(prev_trade_infos);
+    IO::SymbolIndex order_index(order_logs, symbols);
+    IO::SymbolIndex alpha_index(alphas, symbols);
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t symbol_id = symbols.symbolId(argv[2]);
+    if (symbol_id == symbols.unknown()) {
+        std::cerr << argv[2] << " is not in prev_trade_info, showing unknown instruments"
+                  << std::endl;
+    }
+    std::printf("Indexed %zu orders and %zu alphas of %u symbols in %.3fs\n", order_logs.size(),
+                alphas.size(), symbols.size(), seconds);
+
+    for (const auto& prev_info : prev_trade_infos) {
+        if (symbols.symbolId(prev_info.instrument_id) != symbol_id) continue;
+        std::printf("[%u] %.8s prev_close_price=%.2f prev_position=%d\n", symbol_id,
+                    prev_info.instrument_id, prev_info.prev_close_price, prev_info.prev_position);
+        break;
+    }
+    std::printf("%u orders:\n", order_index.count(symbol_id));
+    long shown = 0;
+    for (auto it = order_index.begin(symbol_id); it != order_index.end(symbol_id); ++it) {
+        if (shown++ >= limit) break;
+        const auto& o = order_logs[*it];
+        std::printf("  #%u %.8s timestamp=%ld type=%d direction=%d volume=%d price_off=%.2f\n",
+                    *it, o.instrument_id, o.timestamp, o.type, o.direction, o.volume, o.price_off);
+    }
+    std::printf("%u alphas:\n", alpha_index.count(symbol_id));
+    shown = 0;
+    for (auto it = alpha_index.begin(symbol_id); it != alpha_index.end(symbol_id); ++it) {
+        if (shown++ >= limit) break;
+        const auto& a = alphas[*it];
+        std::printf("  #%u %.8s timestamp=%ld target_volume=%d\n", *it, a.instrument_id,
+                    a.timestamp, a.target_volume);
+    }
+    return 0;
+}
@@ -1,210 +1,65 @@
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
 #include <iostream>
-#include <fstream>
+#include <string>
 #include <vector>
-#include <future>
-#include <pthread.h>
 
-namespace IO {
-struct twap_order {
-    char instrument_id[8];
-    long timestamp;
-    int direction;
-    int volume;
-    double price;
-} __attribute__((packed));
-
-struct pnl_and_pos {
-    char instrument_id[8];
-	int position;
-	double pnl;
-} __attribute__((packed));
-}
-
-template<typename T>
-bool writeToFile(const std::vector<T>& data, const std::string& filename) {
-    std::ofstream outFile(filename, std::ios::binary);
-    
-    if (!outFile.is_open()) {
-        std::cerr << "Error: Couldn't open the file: " << filename << std::endl;
-        return false;
+#include "io/result_server.h"
+#include "io/shm_transport.h"
+
+using namespace UBIEngine;
+
+// 同机的 engine 通过共享内存环交付结果，帧在共享内存中原地写盘，不经过 socket 和拷贝。
+void receiveShm(const std::string& name, size_t capacity, const std::string& output_dir) {
+    IO::ShmResultReceiver receiver(name, capacity);
+    std::cout << "Waiting for frames in shared memory " << name << "..." << std::endl;
+    IO::ShmFrameView frame;
+    IO::WriteOptions options;
+    while (receiver.receive(frame)) {
+        std::string session = IO::sessionName(frame.header);
+        std::string twap_path = output_dir + "/twap_order/" + session;
+        std::string pnl_path = output_dir + "/pnl_and_pos/" + session;
+        IO::writeFiles({{twap_path, reinterpret_cast<const char*>(frame.ans),
+                         frame.header.twap_count * sizeof(IO::twap_order)},
+                        {pnl_path, reinterpret_cast<const char*>(frame.pnls),
+                         frame.header.pnl_count * sizeof(IO::pnl_and_pos)}},
+                       options);
+        receiver.release(frame);
+        std::cout << "Finish writing to: " << twap_path << std::endl;
     }
-
-    outFile.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
-    outFile.close();
-    return true;
-}
-
-
-template<typename T>
-std::future<bool> asyncWriteToFile(const std::vector<T>& data, const std::string& filename) {
-    return std::async(std::launch::async, [data, filename]() -> bool {
-        std::ofstream outFile(filename, std::ios::binary);
-        
-        if (!outFile.is_open()) {
-            std::cerr << "Error: Couldn't open the file: " << filename << std::endl;
-            return false;
-        }
-
-        outFile.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
-        outFile.close();
-        std::cout << "Done writing to: " << filename << std::endl;
-        return true;
-    });
 }
 
-
-class GlobalReceiver {
-private:
-    int server_sockfd;
-    int client_sockfd;
-    struct sockaddr_in serv_addr;
-    struct sockaddr_in client_addr;
-
-public:
-    GlobalReceiver(int port) {
-        server_sockfd = socket(AF_INET, SOCK_STREAM, 0);
-        if (server_sockfd == -1) {
-            throw std::runtime_error("创建 socket 失败！");
-        }
-
-        serv_addr.sin_family = AF_INET;
-        serv_addr.sin_port = htons(port);
-        serv_addr.sin_addr.s_addr = INADDR_ANY;
-
-        if (bind(server_sockfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1) {
-            close(server_sockfd);
-            throw std::runtime_error("Bind failed!");
-        }
-
-        listen(server_sockfd, 5);
-    }
-
-    ~GlobalReceiver() {
-        close(client_sockfd);
-        close(server_sockfd);
-    }
-
-    void waitForConnection() {
-        while (true) {  // Infinite loop to keep accepting connections
-            std::cout << "Waiting for connection..." << std::endl;
-            socklen_t client_len = sizeof(client_addr);
-            client_sockfd = accept(server_sockfd, (struct sockaddr*)&client_addr, &client_len);
-            if (client_sockfd == -1) {
-                std::cerr << "Accept failed!" << std::endl;
-                continue;  // Go back to waiting for the next connection
-            }
-            std::cout << "Connected to a client!" << std::endl;
-
-            try {
-                // Call a function or loop here to handle this particular client's requests
-                handleClient();
-            } catch (const std::exception& e) {
-                std::cerr << "Error handling client: " << e.what() << std::endl;
-            }
-
-            close(client_sockfd);  // Close this client's socket and wait for another
+// 接收多个 engine 进程发来的结果帧（见 io/protocol.h），epoll 单线程收包，线程池写文件。
+// Usage: result_receiver [output_dir] [port] [--shm=<name>] [--shm-size=<MiB>]
+// A --shm ring takes exactly one engine_main --shm=<name>.
+int main(int argc, char* argv[]) {
+    IO::ResultServerOptions options;
+    options.port = 8081;
+    std::string output_dir = "/home/team5/output";
+    std::string shm_name;
+    size_t shm_size = size_t(256) << 20;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--shm=", 0) == 0) {
+            shm_name = arg.substr(6);
+        } else if (arg.rfind("--shm-size=", 0) == 0) {
+            shm_size = std::stoul(arg.substr(11)) << 20;
+        } else {
+            positional.push_back(arg);
         }
     }
-
-    void handleClient() {
-        while (true) { // Loop to continuously receive data from this client
-            // Receive filename
-            int year, month, day, x, y;
-            
-            ssize_t bytesRead = read(client_sockfd, &year, sizeof(year));
-            if (bytesRead != sizeof(year)) {
-                break;  // Connection error or client might have closed the connection
-            }
-            
-            bytesRead = read(client_sockfd, &month, sizeof(month));
-            if (bytesRead != sizeof(month)) {
-                break;
-            }
-            
-            bytesRead = read(client_sockfd, &day, sizeof(day));
-            if (bytesRead != sizeof(day)) {
-                break;
-            }
-            
-            bytesRead = read(client_sockfd, &x, sizeof(x));
-            if (bytesRead != sizeof(x)) {
-                break;
-            }
-            
-            bytesRead = read(client_sockfd, &y, sizeof(y));
-            if (bytesRead != sizeof(y)) {
-                break;
-            }
-
-            char filename[64];  // large enough buffer to store the filename
-            snprintf(filename, sizeof(filename), "%04d%02d%02d_%d_%d", year, month, day, x, y);
-            std::cout << "Year: " << year << std::endl;
-            std::cout << "Month: " << month << std::endl;
-            std::cout << "Day: " << day << std::endl;
-            std::cout << "X: " << x << std::endl;
-            std::cout << "Y: " << y << std::endl;
-
-            char filename_true[64];
-            sprintf(filename_true, "%04d%02d%02d_%d_%d", year, month, day, x, y);
-
-            std::cout << "Received filename: " << filename_true << std::endl;
-
-            // Receive pnls and ans as usual
-            std::vector<IO::pnl_and_pos> pnls;
-            std::vector<IO::twap_order> ans;
-            receiveData<IO::pnl_and_pos>(pnls);
-            receiveData<IO::twap_order>(ans);
-
-            std::cout << "Finished receiving data!" << std::endl;
-
-            std::string filename_str = std::string(filename_true);
-            std::string filename_twap = "/home/team5/output/twap_order/" + filename_str;
-            std::string filename_pnl = "/home/team5/output/pnl_and_pos/" + filename_str;
-            writeToFile<IO::twap_order>(ans, filename_twap);
-            writeToFile<IO::pnl_and_pos>(pnls, filename_pnl);
-            // auto twapFuture = asyncWriteToFile<IO::twap_order>(ans, filename_twap);
-            // auto pnlFuture = asyncWriteToFile<IO::pnl_and_pos>(pnls, filename_pnl);
-
-            
-            // Here you can process the received data and filename as needed.
-        }
-    }
-
-    template <typename T>
-    void receiveData(std::vector<T> &dataVec) {
-        T dataItem;
-        ssize_t bytesReceived = read(client_sockfd, &dataItem, sizeof(T));
-        while (bytesReceived == sizeof(T)) {  // Loop to receive all data of type T
-            dataVec.push_back(dataItem);
-            bytesReceived = read(client_sockfd, &dataItem, sizeof(T));
-        }
-    }
-    // template <typename T>
-    // void receiveData(std::vector<T> &dataVec) {
-    //     constexpr size_t BUFFER_SIZE = 1024;  // Or other suitable size depending on your needs
-    //     char buffer[BUFFER_SIZE];
-    //     ssize_t bytesReceived;
-
-    //     while ((bytesReceived = read(client_sockfd, buffer, BUFFER_SIZE)) > 0) {
-    //         size_t itemsReceived = bytesReceived / sizeof(T);
-    //         for (size_t i = 0; i < itemsReceived; ++i) {
-    //             T* dataPtr = reinterpret_cast<T*>(&buffer[i * sizeof(T)]);
-    //             dataVec.push_back(*dataPtr);
-    //         }
-    //     }
-    // }
-};
-
-int main() {
+    if (positional.size() > 0) output_dir = positional[0];
+    if (positional.size() > 1) options.port = static_cast<uint16_t>(std::stoi(positional[1]));
     try {
-        GlobalReceiver receiver(8081);
-        receiver.waitForConnection();
+        if (!shm_name.empty()) {
+            receiveShm(shm_name, shm_size, output_dir);
+            return 0;
+        }
+        IO::ResultServer server(IO::ResultServer::fileHandler(output_dir, true), options);
+        std::cout << "Waiting for connections on port " << server.port() << "..." << std::endl;
+        server.run();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
+        return 1;
     }
 
     return 0;
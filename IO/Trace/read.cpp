@@ -0,0 +1,45 @@
+// Decodes a trace file written by the engine when built with -DENABLE_TRACE=ON.
+// Build: g++ -std=c++17 -I../../include read.cpp -o read
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "utils/trace.h"
+
+using UBIEngine::Utils::TraceKind;
+using UBIEngine::Utils::TraceRecord;
+
+const char* kind_name(TraceKind kind) {
+    switch (kind) {
+        case TraceKind::HistoryOrder: return "history order";
+        case TraceKind::TwapOrder: return "twap order";
+        case TraceKind::RejectedOrder: return "rejected order";
+        default: return "unknown";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2 && argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <path_to_trace> [symbol_id]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        std::cerr << "Error opening file!" << std::endl;
+        return 1;
+    }
+    long symbol_filter = argc == 3 ? std::stol(argv[2]) : -1;
+
+    TraceRecord r;
+    while (file.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+        if (symbol_filter != -1 && r.symbol_id != symbol_filter) continue;
+        std::printf(
+            "[%u] %s: timestamp=%ld, direction=%d, order_type=%d, volume=%u, price=%.6lf, "
+            "base_price=%.6lf, up_limit=%.6lf, down_limit=%.6lf\n",
+            r.symbol_id, kind_name(r.kind), static_cast<long>(r.timestamp), r.direction,
+            r.order_type, r.volume, r.price / 100.0, r.base_price / 100.0, r.up_limit / 100.0,
+            r.down_limit / 100.0);
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine/order_gateway.h"
+#include "io/synthetic.h"
+#include "utils/latency_histogram.h"
+
+using namespace UBIEngine;
+
+namespace {
+void report(const char* name, const Utils::LatencyHistogram& latencies, uint64_t max) {
+    std::printf("%-12s p50 %8.2f us  p99 %8.2f us  p99.9 %8.2f us  max %8.2f us\n", name,
+                latencies.percentile(0.5) / 1e3, latencies.percentile(0.99) / 1e3,
+                latencies.percentile(0.999) / 1e3, max / 1e3);
+}
+}  // namespace
+
+// 一问一答地发送订单，测量 gateway 的往返延迟：ack 到达和执行回报到达的时间。
+// Without --connect an in-process gateway serves synthetic symbols on loopback.
+int main(int argc, char* argv[]) {
+    uint64_t orders = 100000;
+    uint32_t symbol_count = 100;
+    std::string host = "127.0.0.1";
+    uint16_t port = 0;
+    OrderGatewayOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--orders=", 0) == 0) {
+            orders = std::stoull(arg.substr(9));
+        } else if (arg.rfind("--symbols=", 0) == 0) {
+            symbol_count = static_cast<uint32_t>(std::stoul(arg.substr(10)));
+        } else if (arg.rfind("--spin=", 0) == 0) {
+            options.spin = static_cast<uint32_t>(std::stoul(arg.substr(7)));
+        } else if (arg.rfind("--connect=", 0) == 0) {
+            std::string address = arg.substr(10);
+            auto colon = address.rfind(':');
+            host = address.substr(0, colon);
+            port = static_cast<uint16_t>(std::stoi(address.substr(colon + 1)));
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--orders=N] [--symbols=N] [--spin=N] [--connect=<ip>:<port>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<IO::prev_trade_info> prev_infos(symbol_count);
+    for (uint32_t s = 0; s < symbol_count; ++s) {
+        IO::syntheticInstrumentId(s, prev_infos[s].instrument_id);
+        prev_infos[s].prev_close_price = 10.0 + s % 50;
+        prev_infos[s].prev_position = 0;
+    }
+    std::unique_ptr<OrderGateway> gateway;
+    std::thread server;
+    if (port == 0) {
+        gateway = std::make_unique<OrderGateway>(prev_infos, options);
+        port = gateway->port();
+        server = std::thread([&] { gateway->run(); });
+    }
+
+    Utils::LatencyHistogram ack_latencies, report_latencies;
+    uint64_t ack_max = 0, report_max = 0, rejected = 0, filled = 0;
+    {
+        IO::OrderEntryClient client(host, port);
+        IO::OrderEntryMessage message;
+        IO::order_log order{};
+        order.type = 0;
+        for (uint64_t i = 0; i < orders; ++i) {
+            // Bids and asks a few ticks around the base price, so about half of them trade.
+            std::memcpy(order.instrument_id, prev_infos[i % symbol_count].instrument_id, 8);
+            order.direction = (i / symbol_count) % 2 == 0 ? 1 : -1;
+            order.volume = 100 + static_cast<int>(i % 5) * 100;
+            order.price_off = 0.01 * static_cast<double>(static_cast<int>(i % 7) - 3);
+            auto start = std::chrono::steady_clock::now();
+            client.sendNewOrder(i, order);
+            if (!client.receive(message)) throw std::runtime_error("The gateway closed");
+            uint64_t ack_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+            ack_latencies.add(ack_ns);
+            ack_max = std::max(ack_max, ack_ns);
+            if (!message.ack.accepted) {
+                ++rejected;
+                continue;
+            }
+            if (!client.receive(message)) throw std::runtime_error("The gateway closed");
+            uint64_t report_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count();
+            report_latencies.add(report_ns);
+            report_max = std::max(report_max, report_ns);
+            if (message.report.status == uint8_t(IO::ExecutionStatus::Filled)) ++filled;
+        }
+    }
+    if (gateway) {
+        gateway->stop();
+        server.join();
+    }
+
+    std::printf("%llu orders over %s:%u, %llu filled, %llu rejected\n",
+                static_cast<unsigned long long>(orders), host.c_str(), port,
+                static_cast<unsigned long long>(filled),
+                static_cast<unsigned long long>(rejected));
+    report("ack RTT", ack_latencies, ack_max);
+    if (report_latencies.size() != 0) report("report RTT", report_latencies, report_max);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "flags.h"
+#include "io/order_decoder.h"
+#include "io/reader.h"
+#include "io/synthetic.h"
+
+using namespace UBIEngine;
+
+namespace {
+/* The per-row decode of the replay loop, kept out of line as a baseline. */
+void decodeInline(const IO::order_log* rows, size_t count, IO::OrderColumns& out) {
+    for (size_t i = 0; i < count; ++i) {
+        out.side[i] = rows[i].direction == 1 ? 1 : -1;
+        out.type[i] = rows[i].type;
+        double price_off_100 = rows[i].price_off * 100;
+        int32_t price_off_int;
+        if (price_off_100 > 0)
+            price_off_int = static_cast<int32_t>(price_off_100 + 0.5);
+        else
+            price_off_int = static_cast<int32_t>(price_off_100 - 0.5);
+        out.price_off_ticks[i] = rows[i].type != 0 ? 0 : price_off_int;
+        out.volume[i] = rows[i].volume;
+    }
+}
+
+/* Decodes the rows in batches like DecodedOrderQueue and returns the best rows/sec of `rounds`. */
+template <typename Decode>
+double measure(const IO::RecordFile<IO::order_log>& rows, size_t batch, int rounds, Decode decode,
+               uint64_t& checksum) {
+    IO::OrderColumns columns;
+    columns.resize(batch);
+    double best = 0;
+    for (int round = 0; round < rounds; ++round) {
+        checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < rows.size(); offset += batch) {
+            size_t count = std::min(batch, rows.size() - offset);
+            decode(rows.data() + offset, count, columns);
+            for (size_t i = 0; i < count; ++i) {
+                checksum += columns.side[i] + columns.type[i] + columns.price_off_ticks[i] +
+                            columns.volume[i];
+            }
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::max(best, rows.size() / seconds);
+    }
+    return best;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataset_dir = "synthetic_data";
+    int rounds = 5;
+    IO::SyntheticConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--rounds=", 0) == 0) {
+            rounds = std::stoi(arg.substr(std::string("--rounds=").size()));
+        } else if (Benchmark::parseSyntheticFlag(arg, config)) {
+            continue;
+        } else if (arg.rfind("--", 0) != 0) {
+            dataset_dir = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [dataset_dir] [--rounds=5] [flags]\n";
+            Benchmark::printSyntheticUsage();
+            return 1;
+        }
+    }
+    if (!boost::filesystem::exists(dataset_dir + "/order_log")) {
+        boost::filesystem::create_directories(dataset_dir);
+        IO::writeSyntheticDataset(dataset_dir, config);
+    }
+
+    // Warm page cache: the file is read once before timing.
+    IO::MapOptions options;
+    options.populate = true;
+    IO::RecordFile<IO::order_log> rows(dataset_dir + "/order_log", options);
+    const size_t batch = 1024;
+
+    uint64_t inline_sum = 0, scalar_sum = 0, avx2_sum = 0;
+    double inline_rate = measure(rows, batch, rounds, decodeInline, inline_sum);
+    double scalar_rate = measure(
+        rows, batch, rounds,
+        [](const IO::order_log* r, size_t n, IO::OrderColumns& out) {
+            IO::decodeOrdersScalar(r, n, out);
+        },
+        scalar_sum);
+    std::printf("[bench_decode] rows=%zu batch=%zu\n", rows.size(), batch);
+    std::printf("%-8s %14s %10s\n", "decoder", "rows/sec", "GB/s");
+    std::printf("%-8s %14.0f %10.2f\n", "inline", inline_rate,
+                inline_rate * sizeof(IO::order_log) / 1e9);
+    std::printf("%-8s %14.0f %10.2f\n", "scalar", scalar_rate,
+                scalar_rate * sizeof(IO::order_log) / 1e9);
+    if (IO::hasAvx2Decoder()) {
+        double avx2_rate = measure(
+            rows, batch, rounds,
+            [](const IO::order_log* r, size_t n, IO::OrderColumns& out) {
+                IO::decodeOrdersAvx2(r, n, out);
+            },
+            avx2_sum);
+        std::printf("%-8s %14.0f %10.2f\n", "avx2", avx2_rate,
+                    avx2_rate * sizeof(IO::order_log) / 1e9);
+        if (avx2_sum != scalar_sum) {
+            std::cerr << "AVX2 decoder does not match the scalar decoder!" << std::endl;
+            return 1;
+        }
+    }
+    if (inline_sum != scalar_sum) {
+        std::cerr << "Scalar decoder does not match the replay decode!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include <sys/resource.h>
+
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "engine/replay.h"
+#include "flags.h"
+#include "io/archive.h"
+#include "io/bulk_reader.h"
+#include "io/order_decoder.h"
+#include "io/reader.h"
+#include "io/stream_reader.h"
+#include "io/symbol_index.h"
+#include "io/synthetic.h"
+#include "utils/latency_histogram.h"
+
+using namespace UBIEngine;
+
+namespace {
+/* Records the time between two consecutive events as the latency of the later one. */
+struct LatencyObserver {
+    Utils::LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point last;
+
+    explicit LatencyObserver(Utils::LatencyHistogram& histogram_) : histogram(histogram_) {}
+
+    void onStart() { last = std::chrono::steady_clock::now(); }
+
+    void onEvent(ReplayEvent) {
+        auto now = std::chrono::steady_clock::now();
+        histogram.add(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+        last = now;
+    }
+};
+
+/* Parses `--sessions=3x1,5x2` into session configs. */
+std::vector<SessionConfig> parseSessions(const std::string& value) {
+    std::vector<SessionConfig> sessions;
+    size_t start = 0;
+    while (start < value.size()) {
+        size_t end = value.find(',', start);
+        if (end == std::string::npos) end = value.size();
+        unsigned num = 0, length = 0;
+        if (std::sscanf(value.substr(start, end - start).c_str(), "%ux%u", &num, &length) != 2 ||
+            num == 0) {
+            throw std::invalid_argument("Invalid session: " + value.substr(start, end - start));
+        }
+        sessions.push_back({num, length});
+        start = end + 1;
+    }
+    return sessions;
+}
+
+long peakRssKB() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // Kilobytes on Linux.
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct SessionReport {
+    SessionConfig config;
+    uint64_t events;
+    double replay_seconds;
+    double check_seconds;
+    uint64_t p50, p99, p999;
+};
+
+/* Runs every session like solve() does, without writing the outputs. */
+template <typename OrderQueue, typename AlphaQueue, typename PrevInfos>
+std::vector<SessionReport> runSessions(OrderQueue& order_queue, AlphaQueue& alpha_queue,
+                                       const PrevInfos& prev_trade_infos,
+                                       const std::vector<SessionConfig>& sessions) {
+    std::vector<SessionReport> reports;
+    for (const auto& session : sessions) {
+        Utils::LatencyHistogram histogram;
+        std::vector<IO::twap_order> ans;
+        std::vector<IO::pnl_and_pos> pnls;
+
+        auto replay_start = std::chrono::steady_clock::now();
+        uint64_t events = replaySession(order_queue, alpha_queue, prev_trade_infos, session, ans,
+                                        pnls, LatencyObserver(histogram));
+        double replay_seconds = secondsSince(replay_start);
+
+        // The outputs are emitted sorted, this is the O(n) check engine_main --verify-order does.
+        auto check_start = std::chrono::steady_clock::now();
+        if (!isSortedTwapOutput(ans) || !isSortedPnlOutput(pnls)) {
+            throw std::runtime_error("The replay outputs are not sorted");
+        }
+        double check_seconds = secondsSince(check_start);
+
+        reports.push_back({session, events, replay_seconds, check_seconds,
+                           histogram.percentile(0.5), histogram.percentile(0.99),
+                           histogram.percentile(0.999)});
+        order_queue.reset();
+        alpha_queue.reset();
+    }
+    return reports;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataset_dir = "synthetic_data";
+    // Same sessions as `solve()` in src/main.cpp.
+    std::vector<SessionConfig> sessions = {{3, 1}, {3, 3}, {3, 5}, {5, 2}, {5, 3}};
+    // How order_log is loaded: `decoded` (RecordFile + DecodedOrderQueue, like solve()),
+    // `sync` (reader_sync), `mmap` (RecordFile), `populate` (RecordFile with MAP_POPULATE),
+    // `uring`/`direct`/`pread` (readFiles with io_uring, io_uring + O_DIRECT, or pread),
+    // `archive` (ArchiveQueue, converting order_log on the first run) or `stream` (StreamQueue).
+    std::string load_mode = "decoded";
+    // `--index`: also time building the per-symbol index of order_log and alpha.
+    bool build_index = false;
+    IO::SyntheticConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--sessions=", 0) == 0) {
+            sessions = parseSessions(arg.substr(std::string("--sessions=").size()));
+        } else if (arg.rfind("--load=", 0) == 0) {
+            load_mode = arg.substr(std::string("--load=").size());
+        } else if (arg == "--index") {
+            build_index = true;
+        } else if (Benchmark::parseSyntheticFlag(arg, config)) {
+            continue;
+        } else if (arg.rfind("--", 0) != 0) {
+            dataset_dir = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [dataset_dir] [--sessions=3x1,5x2] [--index]\n"
+                      << "       [--load=decoded|sync|mmap|populate|uring|direct|pread|archive"
+                      << "|stream] [flags]\n"
+                      << "The dataset is generated with the flags below if it does not exist.\n";
+            Benchmark::printSyntheticUsage();
+            return 1;
+        }
+    }
+
+    if (!boost::filesystem::exists(dataset_dir + "/order_log")) {
+        auto gen_start = std::chrono::steady_clock::now();
+        boost::filesystem::create_directories(dataset_dir);
+        IO::writeSyntheticDataset(dataset_dir, config);
+        std::cout << "[bench_replay] generated " << dataset_dir << " in " << secondsSince(gen_start)
+                  << "s" << std::endl;
+    }
+
+    if (build_index) {
+        IO::RecordFile<IO::prev_trade_info> prev_infos(dataset_dir + "/prev_trade_info");
+        IO::RecordFile<IO::order_log> order_logs(dataset_dir + "/order_log");
+        IO::RecordFile<IO::alpha> alphas(dataset_dir + "/alpha");
+        auto index_start = std::chrono::steady_clock::now();
+        IO::SymbolTable symbols(prev_infos);
+        IO::SymbolIndex order_index(order_logs, symbols);
+        IO::SymbolIndex alpha_index(alphas, symbols);
+        double index_seconds = secondsSince(index_start);
+        uint32_t busiest = 0;
+        for (uint32_t s = 0; s < symbols.size(); ++s) {
+            if (order_index.count(s) > order_index.count(busiest)) busiest = s;
+        }
+        std::printf("[bench_replay] indexed %zu orders and %zu alphas in %.3fs (%.0f rows/sec), "
+                    "busiest symbol %u has %u orders, %u orders of unknown symbols\n",
+                    order_logs.size(), alphas.size(), index_seconds,
+                    (order_logs.size() + alphas.size()) / index_seconds, busiest,
+                    order_index.count(busiest), order_index.count(order_index.unknown()));
+    }
+
+    /* alpha and prev_trade_info are small, only the order_log loader is compared. */
+    auto load_start = std::chrono::steady_clock::now();
+    auto alpha_queue =
+        IO::VectorQueue<IO::alpha>(IO::reader_sync<IO::alpha>(dataset_dir + "/alpha"));
+    auto prev_trade_infos =
+        IO::reader_sync<IO::prev_trade_info>(dataset_dir + "/prev_trade_info");
+
+    std::vector<SessionReport> reports;
+    size_t order_count = 0;
+    double load_seconds = 0;
+    if (load_mode == "sync") {
+        auto order_queue = IO::VectorQueue<IO::order_log>(
+            IO::reader_sync<IO::order_log>(dataset_dir + "/order_log"));
+        load_seconds = secondsSince(load_start);
+        order_count = order_queue.size();
+        reports = runSessions(order_queue, alpha_queue, prev_trade_infos, sessions);
+    } else if (load_mode == "decoded") {
+        IO::DecodedOrderQueue<IO::RecordFile<IO::order_log>> order_queue(
+            IO::RecordFile<IO::order_log>(dataset_dir + "/order_log"));
+        load_seconds = secondsSince(load_start);
+        order_count = order_queue.size();
+        reports = runSessions(order_queue, alpha_queue, prev_trade_infos, sessions);
+    } else if (load_mode == "mmap" || load_mode == "populate") {
+        IO::MapOptions options;
+        options.populate = load_mode == "populate";
+        IO::VectorQueue<IO::order_log, IO::RecordFile<IO::order_log>> order_queue(
+            IO::RecordFile<IO::order_log>(dataset_dir + "/order_log", options));
+        load_seconds = secondsSince(load_start);
+        order_count = order_queue.size();
+        reports = runSessions(order_queue, alpha_queue, prev_trade_infos, sessions);
+    } else if (load_mode == "uring" || load_mode == "direct" || load_mode == "pread") {
+        IO::BulkReadOptions options;
+        options.direct = load_mode == "direct";
+        options.use_uring = load_mode != "pread";
+        IO::BulkReadStats stats;
+        auto buffers = IO::readFiles({dataset_dir + "/order_log"}, options, &stats);
+        IO::VectorQueue<IO::order_log, IO::RecordBuffer<IO::order_log>> order_queue(
+            IO::RecordBuffer<IO::order_log>(std::move(buffers[0])));
+        load_seconds = secondsSince(load_start);
+        order_count = order_queue.size();
+        std::printf("[bench_replay] read %.1f MB at %.2f GB/s (%s%s)\n", stats.bytes / 1e6,
+                    stats.gbps(), stats.used_uring ? "io_uring" : "pread",
+                    stats.used_direct ? ", O_DIRECT" : "");
+        reports = runSessions(order_queue, alpha_queue, prev_trade_infos, sessions);
+    } else if (load_mode == "archive") {
+        std::string archive_path = dataset_dir + "/order_log.archive";
+        if (!boost::filesystem::exists(archive_path)) {
+            IO::convertOrderLog(dataset_dir + "/order_log", archive_path);
+            load_start = std::chrono::steady_clock::now();
+        }
+        IO::ArchiveQueue order_queue(archive_path);
+        load_seconds = secondsSince(load_start);
+        order_count = order_queue.size();
+        std::printf("[bench_replay] archive %.1f MB, %.1fx smaller than order_log\n",
+                    order_queue.source().bytes() / 1e6,
+                    static_cast<double>(order_count * sizeof(IO::order_log)) /
+                        order_queue.source().bytes());
+        reports = runSessions(order_queue, alpha_queue, prev_trade_infos, sessions);
+    } else if (load_mode == "stream") {
+        IO::StreamQueue<IO::order_log> order_queue(dataset_dir + "/order_log");
+        load_seconds = secondsSince(load_start);
+        order_count = order_queue.size();
+        reports = runSessions(order_queue, alpha_queue, prev_trade_infos, sessions);
+    } else {
+        std::cerr << "Unknown load mode: " << load_mode << std::endl;
+        return 1;
+    }
+
+    std::printf("\n[bench_replay] dataset=%s load=%s orders=%zu alphas=%zu symbols=%zu "
+                "load_time=%.3fs\n",
+                dataset_dir.c_str(), load_mode.c_str(), order_count, alpha_queue.size(),
+                prev_trade_infos.size(), load_seconds);
+    std::printf("%-8s %12s %10s %14s %9s %9s %9s %8s\n", "session", "events", "replay(s)",
+                "events/sec", "p50(ns)", "p99(ns)", "p999(ns)", "check(s)");
+    for (const auto& r : reports) {
+        std::string name =
+            std::to_string(r.config.session_num) + "_" + std::to_string(r.config.session_length);
+        std::printf("%-8s %12lu %10.3f %14.0f %9lu %9lu %9lu %8.3f\n", name.c_str(), r.events,
+                    r.replay_seconds, r.events / r.replay_seconds, r.p50, r.p99, r.p999,
+                    r.check_seconds);
+    }
+    std::printf("peak RSS: %.1f MB\n", peakRssKB() / 1024.0);
+    return 0;
+}
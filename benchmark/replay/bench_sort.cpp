@@ -0,0 +1,140 @@
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "engine/replay.h"
+#include "flags.h"
+#include "io/order_decoder.h"
+#include "io/reader.h"
+#include "io/synthetic.h"
+#include "utils/radix_sort.h"
+#include "utils/sort.h"
+
+using namespace UBIEngine;
+
+namespace {
+/* Sorts copies of `input` and returns the best seconds of `rounds`. */
+template <typename T, typename Sort>
+double measure(const std::vector<T>& input, int rounds, Sort sort, std::vector<T>& output) {
+    double best = 1e30;
+    for (int round = 0; round < rounds; ++round) {
+        output = input;
+        auto start = std::chrono::steady_clock::now();
+        sort(output);
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds);
+    }
+    return best;
+}
+
+/* True if both are ordered the same by (timestamp, instrument_id). */
+bool sameKeys(const std::vector<IO::twap_order>& a, const std::vector<IO::twap_order>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (Utils::my_compare_twap(a[i], b[i]) || Utils::my_compare_twap(b[i], a[i])) return false;
+    }
+    return true;
+}
+
+void report(const char* name, size_t count, double seconds, double baseline) {
+    std::printf("%-24s %12.3f %14.0f %9.2fx\n", name, seconds * 1e3, count / seconds,
+                baseline / seconds);
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataset_dir = "synthetic_data";
+    int rounds = 5;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    // The outputs of one session are usually small, --repeat concatenates the
+    // session's twap_orders (shifted in time) to get a larger input.
+    int repeat = 1;
+    IO::SyntheticConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--rounds=", 0) == 0) {
+            rounds = std::stoi(arg.substr(std::string("--rounds=").size()));
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = std::stoul(arg.substr(std::string("--threads=").size()));
+        } else if (arg.rfind("--repeat=", 0) == 0) {
+            repeat = std::stoi(arg.substr(std::string("--repeat=").size()));
+        } else if (Benchmark::parseSyntheticFlag(arg, config)) {
+            continue;
+        } else if (arg.rfind("--", 0) != 0) {
+            dataset_dir = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [dataset_dir] [--rounds=5] [--threads=N] [--repeat=1] [flags]\n";
+            Benchmark::printSyntheticUsage();
+            return 1;
+        }
+    }
+    if (!boost::filesystem::exists(dataset_dir + "/order_log")) {
+        boost::filesystem::create_directories(dataset_dir);
+        IO::writeSyntheticDataset(dataset_dir, config);
+    }
+
+    // The twap_orders of the longest session of solve(). The replay outputs them sorted, the
+    // orders of each timestamp are shuffled back to an emission-like order.
+    IO::DecodedOrderQueue<IO::RecordFile<IO::order_log>> order_queue(
+        IO::RecordFile<IO::order_log>(dataset_dir + "/order_log"));
+    IO::VectorQueue<IO::alpha, IO::RecordFile<IO::alpha>> alpha_queue(
+        IO::RecordFile<IO::alpha>(dataset_dir + "/alpha"));
+    IO::RecordFile<IO::prev_trade_info> prev_trade_infos(dataset_dir + "/prev_trade_info");
+    std::vector<IO::twap_order> session;
+    std::vector<IO::pnl_and_pos> pnls;
+    replaySession(order_queue, alpha_queue, prev_trade_infos, SessionConfig{5, 3}, session, pnls);
+    std::vector<IO::twap_order> emitted;
+    long span = session.empty() ? 0 : session.back().timestamp - session.front().timestamp + 1;
+    for (int r = 0; r < repeat; ++r) {
+        for (auto order : session) {
+            order.timestamp += r * span;
+            emitted.push_back(order);
+        }
+    }
+    std::mt19937 rng(42);
+    for (size_t begin = 0, end; begin < emitted.size(); begin = end) {
+        for (end = begin + 1; end < emitted.size(); ++end)
+            if (emitted[end].timestamp != emitted[begin].timestamp) break;
+        std::shuffle(emitted.begin() + begin, emitted.begin() + end, rng);
+    }
+    std::vector<IO::twap_order> shuffled = emitted;
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+
+    std::printf("[bench_sort] twap_orders=%zu threads=%u\n", emitted.size(), threads);
+    std::printf("%-24s %12s %14s %10s\n", "sort", "ms", "rows/sec", "speedup");
+    std::vector<IO::twap_order> expected, output;
+    bool ok = true;
+    for (const auto* input : {&emitted, &shuffled}) {
+        std::printf("-- %s input\n", input == &emitted ? "time-ordered" : "shuffled");
+        double baseline = measure(*input, rounds, [](auto& v) {
+            Utils::multiThreadSort(v, Utils::my_compare_twap);
+        }, expected);
+        report("multiThreadSort", input->size(), baseline, baseline);
+        double single = measure(*input, rounds, [](auto& v) {
+            Utils::radixSort(v, Utils::twapSortKey, 1);
+        }, output);
+        ok &= sameKeys(expected, output);
+        report("radixSort (1 thread)", input->size(), single, baseline);
+        double parallel = measure(*input, rounds, [&](auto& v) {
+            Utils::radixSort(v, Utils::twapSortKey, threads);
+        }, output);
+        ok &= sameKeys(expected, output);
+        report("radixSort", input->size(), parallel, baseline);
+        double nearly = measure(*input, rounds, [&](auto& v) {
+            Utils::sortNearlySorted(v, Utils::twapSortKey, threads);
+        }, output);
+        ok &= sameKeys(expected, output);
+        report("sortNearlySorted", input->size(), nearly, baseline);
+    }
+    if (!ok) {
+        std::cerr << "Radix sort does not match multiThreadSort!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
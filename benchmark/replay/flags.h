@@ -0,0 +1,69 @@
+#ifndef UBI_TRADER_BENCHMARK_REPLAY_FLAGS_H
+#define UBI_TRADER_BENCHMARK_REPLAY_FLAGS_H
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "io/synthetic.h"
+
+namespace UBIEngine::Benchmark {
+/**
+ * Parses one `--name=value` flag of the synthetic dataset generator.
+ *
+ * @return true if the flag is a generator flag and false otherwise.
+ */
+inline bool parseSyntheticFlag(const std::string& arg, IO::SyntheticConfig& config) {
+    auto pos = arg.find('=');
+    if (arg.rfind("--", 0) != 0 || pos == std::string::npos) return false;
+    std::string name = arg.substr(2, pos - 2);
+    std::string value = arg.substr(pos + 1);
+
+    if (name == "symbols") {
+        config.symbol_count = std::stoul(value);
+    } else if (name == "orders") {
+        config.order_count = std::stoull(value);
+    } else if (name == "alphas") {
+        config.alpha_count = std::stoull(value);
+    } else if (name == "skew") {
+        config.symbol_skew = std::stod(value);
+    } else if (name == "type-mix") {
+        // Six comma separated weights, e.g. --type-mix=80,5,5,3,4,3.
+        std::stringstream ss(value);
+        std::string weight;
+        for (auto& w : config.type_mix) {
+            if (!std::getline(ss, weight, ',')) {
+                throw std::invalid_argument("--type-mix requires six weights");
+            }
+            w = std::stod(weight);
+        }
+    } else if (name == "cancel-ratio") {
+        config.cancel_ratio = std::stod(value);
+    } else if (name == "price-sigma") {
+        config.price_off_sigma = std::stod(value);
+    } else if (name == "max-price-off") {
+        config.max_price_off = std::stoi(value);
+    } else if (name == "max-lots") {
+        config.max_lots = std::stoi(value);
+    } else if (name == "seed") {
+        config.seed = std::stoull(value);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline void printSyntheticUsage() {
+    std::cerr << "  --symbols=N        number of instruments (default 100)\n"
+              << "  --orders=N         number of order_log rows (default 1000000)\n"
+              << "  --alphas=N         number of alpha rows (default 10000)\n"
+              << "  --skew=S           Zipf exponent of symbol activity (default 0)\n"
+              << "  --type-mix=w0,..w5 weights of order types 0..5\n"
+              << "  --cancel-ratio=R   share of IOC/FOK style orders (types 3-5)\n"
+              << "  --price-sigma=T    stddev of LIMIT price offsets in ticks (default 5)\n"
+              << "  --max-price-off=T  clamp of LIMIT price offsets in ticks (default 50)\n"
+              << "  --max-lots=N       max order volume in lots of 100 (default 10)\n"
+              << "  --seed=N           random seed (default 42)\n";
+}
+}  // namespace UBIEngine::Benchmark
+#endif  // UBI_TRADER_BENCHMARK_REPLAY_FLAGS_H
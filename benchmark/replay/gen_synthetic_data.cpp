@@ -0,0 +1,31 @@
+#include <boost/filesystem.hpp>
+#include <iostream>
+
+#include "flags.h"
+#include "io/synthetic.h"
+
+using namespace UBIEngine;
+
+// Writes a synthetic dataset (order_log, alpha, prev_trade_info) for `bench_replay`.
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <output_dir> [flags]\n";
+        Benchmark::printSyntheticUsage();
+        return 1;
+    }
+
+    IO::SyntheticConfig config;
+    for (int i = 2; i < argc; ++i) {
+        if (!Benchmark::parseSyntheticFlag(argv[i], config)) {
+            std::cerr << "Unknown flag: " << argv[i] << std::endl;
+            Benchmark::printSyntheticUsage();
+            return 1;
+        }
+    }
+
+    boost::filesystem::create_directories(argv[1]);
+    IO::writeSyntheticDataset(argv[1], config);
+    std::cout << "Wrote " << config.order_count << " orders, " << config.alpha_count
+              << " alphas and " << config.symbol_count << " symbols to " << argv[1] << std::endl;
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "io/transport.h"
+#include "utils/latency_histogram.h"
+
+using namespace UBIEngine;
+
+namespace {
+struct Options {
+    uint64_t rounds = 100000;
+    size_t size = 64;  // Bytes per message, about an order-entry message.
+    int client_cpu = -1;
+    int server_cpu = -1;
+};
+
+int listenLoopback(uint16_t& port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) throw std::runtime_error("创建 socket 失败！");
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 || listen(fd, 1) == -1 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1) {
+        close(fd);
+        throw std::runtime_error("Bind failed!");
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+// 一问一答：客户端发送一条消息，服务端原样返回，测量往返延迟。
+void pingPong(IO::TransportKind kind, const Options& options) {
+    uint16_t port = 0;
+    int listen_fd = listenLoopback(port);
+    IO::TransportOptions server_options;
+    server_options.kind = kind;
+    server_options.cpu = options.server_cpu;
+    std::thread server([&] {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd == -1) return;
+        auto transport = IO::makeTransport(fd, server_options);
+        std::vector<char> buffer(options.size);
+        while (transport->receiveFully(buffer.data(), buffer.size()))
+            transport->send(buffer.data(), buffer.size());
+    });
+
+    IO::TransportOptions client_options;
+    client_options.kind = kind;
+    client_options.cpu = options.client_cpu;
+    Utils::LatencyHistogram latencies;
+    uint64_t max = 0;
+    std::string name;
+    {
+        auto transport = IO::connectTransport("127.0.0.1", port, client_options);
+        name = transport->name();
+        std::vector<char> buffer(options.size, 'x');
+        for (uint64_t i = 0; i < options.rounds; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            transport->send(buffer.data(), buffer.size());
+            if (!transport->receiveFully(buffer.data(), buffer.size()))
+                throw std::runtime_error("The server closed");
+            uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+            latencies.add(ns);
+            max = std::max(max, ns);
+        }
+    }
+    server.join();
+    close(listen_fd);
+    std::printf("%-22s p50 %8.2f us  p99 %8.2f us  p99.9 %8.2f us  max %8.2f us\n", name.c_str(),
+                latencies.percentile(0.5) / 1e3, latencies.percentile(0.99) / 1e3,
+                latencies.percentile(0.999) / 1e3, max / 1e3);
+}
+}  // namespace
+
+// Ping-pong round trips over loopback with each transport of io/transport.h.
+// Busy-polling needs a free core per side: pin them with --cpus=<client>,<server>.
+int main(int argc, char* argv[]) {
+    Options options;
+    std::vector<IO::TransportKind> kinds = {IO::TransportKind::Epoll, IO::TransportKind::BusyPoll};
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--rounds=", 0) == 0) {
+                options.rounds = std::stoull(arg.substr(9));
+            } else if (arg.rfind("--size=", 0) == 0) {
+                options.size = std::max<size_t>(1, std::stoul(arg.substr(7)));
+            } else if (arg.rfind("--transport=", 0) == 0) {
+                kinds = {IO::parseTransportKind(arg.substr(12))};
+            } else if (arg.rfind("--cpus=", 0) == 0 && arg.find(',') != std::string::npos) {
+                options.client_cpu = std::stoi(arg.substr(7, arg.find(',') - 7));
+                options.server_cpu = std::stoi(arg.substr(arg.find(',') + 1));
+            } else {
+                std::cerr << "Usage: " << argv[0]
+                          << " [--rounds=N] [--size=B] [--transport=epoll|busy-poll]"
+                          << " [--cpus=<client>,<server>]" << std::endl;
+                return 1;
+            }
+        }
+        std::printf("%llu round trips of %zu bytes over loopback\n",
+                    static_cast<unsigned long long>(options.rounds), options.size);
+        for (IO::TransportKind kind : kinds) {
+            if (kind == IO::TransportKind::BusyPoll && std::thread::hardware_concurrency() < 2)
+                std::printf("(one CPU: the spinning sides take turns, busy-poll is meaningless)\n");
+            pingPong(kind, options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,477 @@
+#ifndef UBI_TRADER_ENGINE_MARKET_DATA_PUBLISHER_H
+#define UBI_TRADER_ENGINE_MARKET_DATA_PUBLISHER_H
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book_listener.h"
+#include "io/market_data.h"
+#include "io/symbol_index.h"
+#include "utils/spsc_queue.h"
+
+namespace UBIEngine {
+/* Options of MarketDataPublisher. */
+struct MarketDataOptions {
+    // Where the UDP packets go, a multicast group (224.0.0.0/4) works too.
+    std::string host = "127.0.0.1";
+    uint16_t port = 9100;
+    // The TCP port that serves snapshots for gap recovery, 0 picks a free one.
+    uint16_t recovery_port = 0;
+    // Book changes in flight from the matching thread, `onLevel()` waits beyond it.
+    size_t queue_capacity = 1 << 16;
+    // Messages are batched into packets of at most this many bytes.
+    size_t max_packet = 1400;
+    // The levels per side of the periodic snapshots, recovery snapshots are complete.
+    uint32_t snapshot_depth = 32;
+    // 0 disables the periodic snapshots.
+    std::chrono::milliseconds snapshot_interval{1000};
+    // An empty packet announces the next sequence number after this much silence.
+    std::chrono::milliseconds heartbeat_interval{100};
+    int multicast_ttl = 1;
+};
+
+/* Counters of a MarketDataPublisher. */
+struct MarketDataStats {
+    uint64_t messages = 0;
+    uint64_t packets = 0;
+    uint64_t send_errors = 0;
+    uint64_t recoveries = 0;  // Snapshot requests served.
+};
+
+/**
+ * Publishes the book changes of a Market as sequenced L2 market data
+ * (protocol in io/market_data.h).
+ *
+ * Set it as the book listener of the market (`Market::setBookListener()`):
+ * the matching thread only pushes small events into a lock-free SPSC ring.
+ * The publisher thread numbers them, keeps its own L2 copy of every book
+ * (so snapshots never read the MapOrderBook across threads), batches the
+ * messages into UDP packets, sends periodic snapshots and heartbeats, and
+ * serves full snapshots on a TCP port for receivers that missed packets.
+ */
+class MarketDataPublisher : public BookListener {
+   public:
+    /**
+     * @param prev_trade_infos the symbols of the market, numbered like IO::SymbolTable.
+     */
+    template <typename PrevInfos>
+    explicit MarketDataPublisher(const PrevInfos& prev_trade_infos,
+                                 const MarketDataOptions& options_ = MarketDataOptions())
+        : options(options_), events(options_.queue_capacity) {
+        IO::SymbolTable symbols(prev_trade_infos);
+        books.resize(symbols.size());
+        for (const auto& prev_info : prev_trade_infos) {
+            Book& book = books[symbols.symbolId(prev_info.instrument_id)];
+            std::memcpy(book.instrument_id, prev_info.instrument_id, 8);
+        }
+        openSockets();
+        worker = std::thread([this] { run(); });
+    }
+
+    MarketDataPublisher(const MarketDataPublisher&) = delete;
+    MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+    ~MarketDataPublisher() override {
+        close();
+        closeSockets();
+    }
+
+    /* Matching thread only. */
+    void onLevel(uint32_t symbol_id, OrderSide side, uint64_t price, uint64_t volume) override {
+        push({symbol_id, kLevelEvent,
+              side == OrderSide::Ask ? IO::BookSide::Ask : IO::BookSide::Bid, price, volume});
+    }
+
+    /* Matching thread only. */
+    void onTrade(uint32_t symbol_id, uint64_t price, uint64_t quantity) override {
+        push({symbol_id, kTradeEvent, IO::BookSide::Bid, price, quantity});
+    }
+
+    /* Waits until every change reported so far is sent. Matching thread only. */
+    void flush() {
+        while (published.load(std::memory_order_acquire) < pushed) {
+            wake();
+            std::this_thread::yield();
+        }
+    }
+
+    /* Sends what is queued and stops the publisher thread. */
+    void close() {
+        if (!worker.joinable()) return;
+        closing = true;
+        notify();
+        worker.join();
+    }
+
+    uint16_t recoveryPort() const { return bound_recovery_port; }
+
+    /* The sequence number of the last message sent, 0 before the first one. */
+    uint64_t lastSequence() const { return last_sent_sequence.load(); }
+
+    MarketDataStats stats() const {
+        MarketDataStats result;
+        result.messages = message_count;
+        result.packets = packet_count;
+        result.send_errors = send_error_count;
+        result.recoveries = recovery_count;
+        return result;
+    }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr uint8_t kLevelEvent = 0;
+    static constexpr uint8_t kTradeEvent = 1;
+    // How often a busy publisher still looks at its timers and the recovery port.
+    static constexpr std::chrono::milliseconds kServiceInterval{1};
+
+    struct BookEvent {
+        uint32_t symbol_id;
+        uint8_t kind;
+        IO::BookSide side;
+        uint64_t price;
+        uint64_t volume;  // The quantity of trades.
+    };
+
+    struct Book : IO::L2Book {
+        char instrument_id[8] = {};
+    };
+
+    struct RecoveryClient {
+        int fd;
+        IO::SnapshotRequestMessage request;
+        size_t received = 0;
+    };
+
+    void push(const BookEvent& event) {
+        while (!events.tryPush(event)) {
+            wake();
+            std::this_thread::yield();
+        }
+        ++pushed;
+        wake();
+    }
+
+    /* Wakes the publisher thread if it sleeps. Pairs with the fence in `run()`. */
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) notify();
+    }
+
+    void notify() {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    void openSockets() {
+        udp_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (udp_fd == -1 || listen_fd == -1 || wake_fd == -1) {
+            closeSockets();
+            throw std::runtime_error("创建 socket 失败！");
+        }
+        destination.sin_family = AF_INET;
+        destination.sin_port = htons(options.port);
+        if (inet_pton(AF_INET, options.host.c_str(), &destination.sin_addr) != 1) {
+            closeSockets();
+            throw std::invalid_argument("Bad IPv4 address: " + options.host);
+        }
+        if (IN_MULTICAST(ntohl(destination.sin_addr.s_addr))) {
+            unsigned char ttl = static_cast<unsigned char>(options.multicast_ttl);
+            unsigned char loop = 1;  // Receivers on this host get the packets too.
+            setsockopt(udp_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+            setsockopt(udp_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        }
+
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options.recovery_port);
+        addr.sin_addr.s_addr = INADDR_ANY;
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+            listen(listen_fd, 16) == -1 ||
+            getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1) {
+            closeSockets();
+            throw std::runtime_error("Bind failed!");
+        }
+        bound_recovery_port = ntohs(addr.sin_port);
+    }
+
+    void closeSockets() {
+        for (auto& client : recovery_clients) ::close(client.fd);
+        recovery_clients.clear();
+        for (int fd : {udp_fd, listen_fd, wake_fd})
+            if (fd != -1) ::close(fd);
+        udp_fd = listen_fd = wake_fd = -1;
+    }
+
+    /* The publisher thread. */
+    void run() {
+        auto now = Clock::now();
+        next_snapshot = now + options.snapshot_interval;
+        last_send = now;
+        auto next_service = now;
+        while (true) {
+            size_t drained = drain();
+            now = Clock::now();
+            if (drained != 0 && now < next_service) continue;
+            next_service = now + kServiceInterval;
+            runTimers(now);
+            if (drained != 0) {
+                serve(0);
+                continue;
+            }
+            if (closing) {
+                if (events.empty()) return;
+                continue;
+            }
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (events.empty() && !closing) serve(timeoutMs(now));
+            sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    /* Publishes the queued events, returns how many. */
+    size_t drain() {
+        BookEvent event;
+        size_t count = 0;
+        while (events.tryPop(event)) {
+            publish(event);
+            ++count;
+        }
+        if (count != 0) {
+            sendPacket();
+            published.fetch_add(count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    void publish(const BookEvent& event) {
+        if (event.symbol_id >= books.size()) books.resize(event.symbol_id + 1);
+        Book& book = books[event.symbol_id];
+        if (event.kind == kLevelEvent) {
+            book.set(event.side, event.price, event.volume);
+            IO::LevelUpdateMessage message{};
+            message.header =
+                IO::marketDataHeader<IO::LevelUpdateMessage>(IO::MarketDataType::Level);
+            message.symbol_id = event.symbol_id;
+            message.side = static_cast<uint8_t>(event.side);
+            message.price = event.price;
+            message.volume = event.volume;
+            append(&message, sizeof(message));
+        } else {
+            book.last_price = event.price;
+            IO::TradeMessage message{};
+            message.header = IO::marketDataHeader<IO::TradeMessage>(IO::MarketDataType::Trade);
+            message.symbol_id = event.symbol_id;
+            message.price = event.price;
+            message.quantity = event.volume;
+            append(&message, sizeof(message));
+        }
+    }
+
+    /* Adds a message to the current packet, sending the packet first if it would not fit. */
+    void append(const void* message, size_t size) {
+        if (packet_count_messages != 0 && packet.size() + size > options.max_packet) sendPacket();
+        if (packet_count_messages == 0) {
+            IO::MarketDataPacketHeader header{IO::kMarketDataMagic, IO::kMarketDataVersion, 0,
+                                              next_sequence};
+            packet.assign(reinterpret_cast<const char*>(&header),
+                          reinterpret_cast<const char*>(&header) + sizeof(header));
+        }
+        packet.insert(packet.end(), static_cast<const char*>(message),
+                      static_cast<const char*>(message) + size);
+        ++packet_count_messages;
+        ++next_sequence;
+        ++message_count;
+    }
+
+    void sendPacket() {
+        if (packet_count_messages == 0) return;
+        IO::MarketDataPacketHeader header;
+        std::memcpy(&header, packet.data(), sizeof(header));
+        header.count = static_cast<uint16_t>(packet_count_messages);
+        std::memcpy(packet.data(), &header, sizeof(header));
+        sendDatagram(packet.data(), packet.size());
+        packet_count_messages = 0;
+        last_sent_sequence.store(next_sequence - 1);
+    }
+
+    void sendDatagram(const char* data, size_t size) {
+        // UDP is best effort: a lost packet is recovered by the receivers.
+        while (sendto(udp_fd, data, size, 0, reinterpret_cast<const sockaddr*>(&destination),
+                      sizeof(destination)) == -1) {
+            if (errno == EINTR) continue;
+            ++send_error_count;
+            break;
+        }
+        ++packet_count;
+        last_send = Clock::now();
+    }
+
+    void runTimers(Clock::time_point now) {
+        if (options.snapshot_interval.count() > 0 && now >= next_snapshot) {
+            for (uint32_t symbol_id = 0; symbol_id < books.size(); ++symbol_id) {
+                const Book& book = books[symbol_id];
+                if (book.bids.empty() && book.asks.empty() && book.last_price == 0) continue;
+                snapshot(symbol_id, options.snapshot_depth, next_sequence - 1);
+                append(scratch.data(), scratch.size());
+            }
+            sendPacket();
+            next_snapshot = now + options.snapshot_interval;
+        }
+        if (now - last_send >= options.heartbeat_interval) {
+            IO::MarketDataPacketHeader header{IO::kMarketDataMagic, IO::kMarketDataVersion, 0,
+                                              next_sequence};
+            sendDatagram(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+    }
+
+    int timeoutMs(Clock::time_point now) const {
+        auto deadline = last_send + options.heartbeat_interval;
+        if (options.snapshot_interval.count() > 0) deadline = std::min(deadline, next_snapshot);
+        auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+        return static_cast<int>(std::max<int64_t>(wait, 0));
+    }
+
+    /* Builds the snapshot message of a symbol in `scratch`. */
+    void snapshot(uint32_t symbol_id, uint32_t depth, uint64_t last_sequence) {
+        const Book& book = books[symbol_id];
+        IO::SnapshotMessage message{};
+        message.symbol_id = symbol_id;
+        std::memcpy(message.instrument_id, book.instrument_id, 8);
+        message.bid_count = static_cast<uint32_t>(std::min<size_t>(book.bids.size(), depth));
+        message.ask_count = static_cast<uint32_t>(std::min<size_t>(book.asks.size(), depth));
+        if (message.bid_count < book.bids.size()) message.flags |= IO::kSnapshotBidsTruncated;
+        if (message.ask_count < book.asks.size()) message.flags |= IO::kSnapshotAsksTruncated;
+        message.last_sequence = last_sequence;
+        message.last_price = book.last_price;
+        size_t size = sizeof(message) +
+                      (message.bid_count + message.ask_count) * sizeof(IO::SnapshotLevel);
+        message.header = IO::marketDataHeader<IO::SnapshotMessage>(IO::MarketDataType::Snapshot,
+                                                                   static_cast<uint32_t>(size));
+        scratch.resize(size);
+        std::memcpy(scratch.data(), &message, sizeof(message));
+        auto* levels = reinterpret_cast<IO::SnapshotLevel*>(scratch.data() + sizeof(message));
+        auto copy = [&levels](const auto& side, uint32_t count) {
+            for (auto it = side.begin(); count-- != 0; ++it) *levels++ = {it->first, it->second};
+        };
+        copy(book.bids, message.bid_count);
+        copy(book.asks, message.ask_count);
+    }
+
+    /* Handles the recovery port, waiting up to `timeout_ms` for something to happen. */
+    void serve(int timeout_ms) {
+        std::vector<pollfd> fds = {{wake_fd, POLLIN, 0}, {listen_fd, POLLIN, 0}};
+        for (const auto& client : recovery_clients) fds.push_back({client.fd, POLLIN, 0});
+        if (::poll(fds.data(), fds.size(), timeout_ms) <= 0) return;
+        if (fds[0].revents) {
+            uint64_t count;
+            ssize_t ignored = read(wake_fd, &count, sizeof(count));
+            (void)ignored;
+        }
+        for (size_t i = fds.size() - 1; i >= 2; --i) {
+            if (fds[i].revents) receiveRequest(i - 2);
+        }
+        if (fds[1].revents) acceptClients();
+    }
+
+    void acceptClients() {
+        while (true) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd == -1) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return;
+            }
+            recovery_clients.push_back({fd, {}, 0});
+        }
+    }
+
+    void receiveRequest(size_t index) {
+        RecoveryClient& client = recovery_clients[index];
+        char* buffer = reinterpret_cast<char*>(&client.request);
+        ssize_t n = recv(client.fd, buffer + client.received,
+                         sizeof(client.request) - client.received, 0);
+        if (n == -1 && (errno == EAGAIN || errno == EINTR)) return;
+        if (n > 0) client.received += n;
+        if (n > 0 && client.received < sizeof(client.request)) return;
+        if (n > 0 && client.request.header.type == uint16_t(IO::MarketDataType::SnapshotRequest))
+            sendSnapshots(client.fd, client.request.symbol_id);
+        ::close(client.fd);
+        recovery_clients.erase(recovery_clients.begin() + index);
+    }
+
+    /* Complete snapshots as of the last message sent. Blocks the publisher while sending. */
+    void sendSnapshots(int fd, uint32_t wanted) {
+        sendPacket();
+        int flags = fcntl(fd, F_GETFL);
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+        timeval timeout{1, 0};  // A stuck receiver must not stall the stream for long.
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        for (uint32_t symbol_id = 0; symbol_id < books.size(); ++symbol_id) {
+            if (wanted != IO::kAllSymbols && wanted != symbol_id) continue;
+            snapshot(symbol_id, UINT32_MAX, next_sequence - 1);
+            size_t sent = 0;
+            while (sent < scratch.size()) {
+                ssize_t n = send(fd, scratch.data() + sent, scratch.size() - sent, MSG_NOSIGNAL);
+                if (n == -1 && errno == EINTR) continue;
+                if (n <= 0) return;
+                sent += n;
+            }
+        }
+        ++recovery_count;
+    }
+
+    MarketDataOptions options;
+    int udp_fd = -1;
+    int listen_fd = -1;
+    int wake_fd = -1;
+    sockaddr_in destination{};
+    uint16_t bound_recovery_port = 0;
+
+    // Matching thread.
+    uint64_t pushed = 0;
+
+    // Publisher thread.
+    std::vector<Book> books;
+    std::vector<char> packet;
+    size_t packet_count_messages = 0;
+    std::vector<char> scratch;
+    uint64_t next_sequence = 1;
+    Clock::time_point next_snapshot;
+    Clock::time_point last_send;
+    std::vector<RecoveryClient> recovery_clients;
+
+    Concurrent::SpscQueue<BookEvent> events;
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> last_sent_sequence{0};
+    std::atomic_bool sleeping{false};
+    std::atomic_bool closing{false};
+    std::atomic<uint64_t> message_count{0};
+    std::atomic<uint64_t> packet_count{0};
+    std::atomic<uint64_t> send_error_count{0};
+    std::atomic<uint64_t> recovery_count{0};
+    std::thread worker;
+};
+}  // namespace UBIEngine
+#endif  // UBI_TRADER_ENGINE_MARKET_DATA_PUBLISHER_H
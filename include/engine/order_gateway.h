@@ -0,0 +1,544 @@
+#ifndef UBI_TRADER_ENGINE_ORDER_GATEWAY_H
+#define UBI_TRADER_ENGINE_ORDER_GATEWAY_H
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "io/order_entry.h"
+#include "io/order_event.h"
+#include "io/symbol_index.h"
+#include "io/validate.h"
+#include "market.h"
+#include "utils/cpu.h"
+#include "utils/spsc_queue.h"
+
+namespace UBIEngine {
+/* Options of OrderGateway. */
+struct OrderGatewayOptions {
+    // The TCP port to listen on, 0 picks a free one (see `OrderGateway::port()`).
+    uint16_t port = 0;
+    int backlog = 128;
+    // The requests and replies in flight between the network and matching threads.
+    size_t queue_capacity = 1 << 16;
+    // Empty polls of the matching thread before it sleeps on an eventfd. Spinning keeps the
+    // wakeup off the round trip while orders flow; 0 always sleeps (for machines with one CPU).
+    uint32_t spin = 20000;
+    // Told about every book change on the matching thread, e.g. a MarketDataPublisher.
+    BookListener* book_listener = nullptr;
+};
+
+namespace detail {
+/* A request handed from the network thread to the matching thread. */
+struct GatewayCommand {
+    uint64_t connection;
+    IO::OrderEntryMessage message;
+};
+
+/* The answer to one request, routed back to `connection` if it is still open. */
+struct GatewayReply {
+    uint64_t connection;
+    IO::AckMessage ack;
+    IO::ExecutionReportMessage report;
+    bool has_report;
+};
+}  // namespace detail
+
+/**
+ * A live order-entry front end of the matching engine (protocol in
+ * io/order_entry.h).
+ *
+ * One network thread runs an edge-triggered epoll loop over non-blocking
+ * sockets; each connection has a parse buffer, complete messages go through
+ * an SPSC queue to a single matching thread that owns the Market, so the book
+ * needs no locks. Replies come back through a second SPSC queue and an
+ * eventfd, and are written per connection with one send() per batch. New
+ * orders are priced and validated exactly like replayed order_log records.
+ *
+ * `run()` serves until `stop()` is called, from any thread.
+ */
+class OrderGateway {
+   public:
+    /**
+     * Creates the market of `prev_trade_infos` and listens on `options.port`.
+     */
+    template <typename PrevInfos>
+    explicit OrderGateway(const PrevInfos& prev_trade_infos,
+                          const OrderGatewayOptions& options_ = OrderGatewayOptions())
+        : options(options_),
+          symbols(prev_trade_infos),
+          commands(options_.queue_capacity),
+          replies(options_.queue_capacity) {
+        for (const auto& prev_info : prev_trade_infos) {
+            uint32_t symbol_id = symbols.symbolId(prev_info.instrument_id);
+            if (market.hasSymbol(symbol_id)) continue;
+            market.addSymbol(symbol_id, std::string(prev_info.instrument_id, strnlen(
+                                                        prev_info.instrument_id, 8)),
+                             static_cast<uint64_t>(prev_info.prev_close_price * 100 + 0.5),
+                             prev_info.prev_position);
+        }
+        market.setBookListener(options.book_listener);
+
+        listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        reply_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        command_fd = eventfd(0, EFD_CLOEXEC);  // Blocking, the matching thread sleeps on it.
+        if (listen_fd == -1 || epoll_fd == -1 || wake_fd == -1 || reply_fd == -1 ||
+            command_fd == -1) {
+            closeAll();
+            throw std::runtime_error("创建 socket 失败！");
+        }
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options.port);
+        addr.sin_addr.s_addr = INADDR_ANY;
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+            listen(listen_fd, options.backlog) == -1 ||
+            getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1) {
+            closeAll();
+            throw std::runtime_error("Bind failed!");
+        }
+        bound_port = ntohs(addr.sin_port);
+        watch(listen_fd, kListenId, EPOLLIN);
+        watch(wake_fd, kWakeId, EPOLLIN);
+        watch(reply_fd, kReplyId, EPOLLIN | EPOLLET);
+    }
+
+    OrderGateway(const OrderGateway&) = delete;
+    OrderGateway& operator=(const OrderGateway&) = delete;
+
+    ~OrderGateway() { closeAll(); }
+
+    /* The port the gateway listens on. */
+    uint16_t port() const { return bound_port; }
+
+    /* Serves until `stop()`. The matching thread runs while `run()` does. */
+    void run() {
+        std::thread matcher([this] { match(); });
+        std::vector<epoll_event> events(64);
+        try {
+            while (!stopping) {
+                int n = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+                if (n == -1) {
+                    if (errno == EINTR) continue;
+                    throw std::runtime_error(std::string("epoll_wait failed: ") +
+                                             strerror(errno));
+                }
+                for (int i = 0; i < n; ++i) {
+                    uint64_t id = events[i].data.u64;
+                    if (id == kListenId) {
+                        acceptAll();
+                    } else if (id == kReplyId) {
+                        uint64_t count;
+                        ssize_t ignored = read(reply_fd, &count, sizeof(count));
+                        (void)ignored;
+                        drainReplies();
+                    } else if (id != kWakeId) {
+                        serve(id, events[i].events);
+                    }
+                }
+                closeBroken();
+            }
+        } catch (...) {
+            stopMatcher(matcher);
+            throw;
+        }
+        stopMatcher(matcher);
+    }
+
+    /* Makes `run()` return. Thread-safe. */
+    void stop() {
+        stopping = true;
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    /* The number of requests matched. */
+    uint64_t requests() const { return request_count; }
+    /* The number of open connections. */
+    size_t connections() const { return open_connections; }
+
+   private:
+    // epoll ids of the non-connection descriptors, connections count up from kFirstConnection.
+    static constexpr uint64_t kListenId = 0;
+    static constexpr uint64_t kWakeId = 1;
+    static constexpr uint64_t kReplyId = 2;
+    static constexpr uint64_t kFirstConnection = 3;
+    static constexpr size_t kReadChunk = 64 * 1024;
+    // The owners of resting orders are swept for filled orders beyond twice this many.
+    static constexpr size_t kMinOwnerSweep = 1024;
+
+    struct Connection {
+        int fd;
+        std::vector<char> in;  // Received bytes, a partial message at most once parsed.
+        size_t in_size = 0;
+        std::vector<char> out;  // Replies not yet accepted by the socket.
+        size_t out_sent = 0;
+        bool broken = false;
+    };
+
+    void watch(int fd, uint64_t id, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+            throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd == -1) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    std::cerr << "Accept failed: " << strerror(errno) << std::endl;
+                return;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            uint64_t id = next_connection++;
+            connections_by_id[id].fd = fd;
+            // EPOLLOUT is edge-triggered too: it only fires when a full socket drains.
+            watch(fd, id, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+            ++open_connections;
+        }
+    }
+
+    void serve(uint64_t id, uint32_t events) {
+        auto it = connections_by_id.find(id);
+        if (it == connections_by_id.end()) return;
+        if (events & EPOLLOUT) flush(it->second);
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) receive(id, it->second);
+    }
+
+    /* Reads until the socket would block, queues every complete message. */
+    void receive(uint64_t id, Connection& connection) {
+        while (!connection.broken) {
+            if (connection.in.size() - connection.in_size < kReadChunk)
+                connection.in.resize(connection.in_size + kReadChunk);
+            ssize_t n = read(connection.fd, connection.in.data() + connection.in_size,
+                             connection.in.size() - connection.in_size);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    std::cerr << "Error receiving orders: " << strerror(errno) << std::endl;
+                    connection.broken = true;
+                }
+                return;
+            }
+            if (n == 0) {
+                connection.broken = true;
+                return;
+            }
+            connection.in_size += n;
+            parse(id, connection);
+        }
+    }
+
+    void parse(uint64_t id, Connection& connection) {
+        size_t offset = 0;
+        detail::GatewayCommand command;
+        command.connection = id;
+        while (connection.in_size - offset >= sizeof(IO::OrderEntryHeader)) {
+            IO::OrderEntryHeader header;
+            std::memcpy(&header, connection.in.data() + offset, sizeof(header));
+            bool request = header.type == uint16_t(IO::OrderEntryType::NewOrder) ||
+                           header.type == uint16_t(IO::OrderEntryType::CancelOrder);
+            if (!request || header.length != IO::orderEntryLength(header.type)) {
+                std::cerr << "Bad order-entry message, closing the connection" << std::endl;
+                connection.broken = true;
+                return;
+            }
+            if (connection.in_size - offset < header.length) break;
+            std::memcpy(&command.message, connection.in.data() + offset, header.length);
+            offset += header.length;
+            while (!commands.tryPush(command)) {
+                // The matching thread is behind: take its replies so it cannot block on them.
+                wakeMatcher();
+                drainReplies();
+                std::this_thread::yield();
+            }
+        }
+        std::memmove(connection.in.data(), connection.in.data() + offset,
+                     connection.in_size - offset);
+        connection.in_size -= offset;
+        wakeMatcher();
+    }
+
+    void drainReplies() {
+        detail::GatewayReply reply;
+        std::vector<Connection*> touched;
+        while (replies.tryPop(reply)) {
+            auto it = connections_by_id.find(reply.connection);
+            if (it == connections_by_id.end()) continue;  // Closed meanwhile.
+            Connection& connection = it->second;
+            if (connection.out.size() == connection.out_sent) touched.push_back(&connection);
+            append(connection, &reply.ack, sizeof(reply.ack));
+            if (reply.has_report) append(connection, &reply.report, sizeof(reply.report));
+        }
+        for (Connection* connection : touched) flush(*connection);
+    }
+
+    static void append(Connection& connection, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        connection.out.insert(connection.out.end(), p, p + size);
+    }
+
+    /* Sends the pending replies until the socket would block (EPOLLOUT resumes). */
+    void flush(Connection& connection) {
+        while (connection.out_sent < connection.out.size() && !connection.broken) {
+            ssize_t n = send(connection.fd, connection.out.data() + connection.out_sent,
+                             connection.out.size() - connection.out_sent, MSG_NOSIGNAL);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) connection.broken = true;
+                return;
+            }
+            connection.out_sent += n;
+        }
+        if (connection.out_sent == connection.out.size()) {
+            connection.out.clear();
+            connection.out_sent = 0;
+        }
+    }
+
+    /* Connections are only closed here, so nothing above holds a dangling reference. */
+    void closeBroken() {
+        for (auto it = connections_by_id.begin(); it != connections_by_id.end();) {
+            if (!it->second.broken) {
+                ++it;
+                continue;
+            }
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+            close(it->second.fd);
+            it = connections_by_id.erase(it);
+            --open_connections;
+        }
+    }
+
+    /* Wakes the matching thread if it sleeps. Pairs with the fence in `match()`. */
+    void wakeMatcher() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (matcher_sleeping.load(std::memory_order_relaxed)) notify(command_fd);
+    }
+
+    static void notify(int fd) {
+        uint64_t one = 1;
+        ssize_t ignored = write(fd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    void stopMatcher(std::thread& matcher) {
+        matcher_stopping = true;
+        notify(command_fd);
+        matcher.join();
+    }
+
+    /* The matching thread: the only one that touches `market`. */
+    void match() {
+        detail::GatewayCommand command;
+        detail::GatewayReply reply;
+        bool pending = false;  // Replies the network thread was not told about yet.
+        uint32_t idle = 0;
+        while (true) {
+            if (commands.tryPop(command)) {
+                handle(command, reply);
+                ++request_count;
+                while (!replies.tryPush(reply)) {
+                    notify(reply_fd);
+                    std::this_thread::yield();
+                }
+                pending = true;
+                idle = 0;
+                continue;
+            }
+            // The queue ran dry: one eventfd write for the whole batch.
+            if (pending) {
+                notify(reply_fd);
+                pending = false;
+            }
+            if (matcher_stopping) return;
+            if (idle < options.spin) {
+                ++idle;
+                Utils::cpuRelax();
+                continue;
+            }
+            matcher_sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (commands.empty() && !matcher_stopping) {
+                uint64_t count;
+                ssize_t ignored = read(command_fd, &count, sizeof(count));
+                (void)ignored;
+            }
+            matcher_sleeping.store(false, std::memory_order_relaxed);
+            idle = 0;
+        }
+    }
+
+    void handle(const detail::GatewayCommand& command, detail::GatewayReply& reply) {
+        reply.connection = command.connection;
+        reply.has_report = false;
+        reply.ack = {};
+        reply.ack.header = IO::orderEntryHeader(IO::OrderEntryType::Ack);
+        reply.report = {};
+        reply.report.header = IO::orderEntryHeader(IO::OrderEntryType::ExecutionReport);
+        if (command.message.header.type == uint16_t(IO::OrderEntryType::NewOrder)) {
+            handleNewOrder(command.message.new_order, reply);
+        } else {
+            handleCancel(command.message.cancel, reply);
+        }
+        reply.report.client_order_id = reply.ack.client_order_id;
+        reply.report.order_id = reply.ack.order_id;
+    }
+
+    void handleNewOrder(const IO::NewOrderMessage& message, detail::GatewayReply& reply) {
+        const IO::order_log& row = message.order;
+        reply.ack.client_order_id = message.client_order_id;
+        IO::RejectReason reason;
+        if (IO::detail::rejectOrder(row, symbols, reason)) {
+            reply.ack.reason = static_cast<uint8_t>(reason);
+            return;
+        }
+        uint32_t symbol_id = symbols.symbolId(row.instrument_id);
+        OrderSide side = row.direction == 1 ? OrderSide::Bid : OrderSide::Ask;
+        uint64_t base_price = market.getBasePrice(symbol_id, side);
+        int32_t price_off = IO::priceOffTicks(row);
+        // 和回放一样，负的 price_off 不能低于基准价格。
+        if (price_off < 0 && base_price < static_cast<uint64_t>(-int64_t(price_off))) {
+            reply.ack.reason = static_cast<uint8_t>(IO::OrderEntryReject::PriceOutOfRange);
+            return;
+        }
+        uint64_t price = row.type == 0 ? base_price + price_off : 0;
+        uint64_t order_id = ++last_order_id;
+        market.addOrder(Order::newOrder(int2OrderType(row.type), side, order_id, symbol_id,
+                                        row.volume, price, false));
+        uint64_t executed = market.lastAddedExecutedQuantity(symbol_id);
+        const Order* resting = market.findOrder(symbol_id, order_id);
+        IO::ExecutionStatus status;
+        if (resting != nullptr) {
+            status = executed == 0 ? IO::ExecutionStatus::New
+                                   : IO::ExecutionStatus::PartiallyFilled;
+        } else {
+            status = executed == uint64_t(row.volume) ? IO::ExecutionStatus::Filled
+                                                      : IO::ExecutionStatus::Expired;
+        }
+        reply.ack.accepted = 1;
+        reply.ack.order_id = order_id;
+        reply.has_report = true;
+        reply.report.status = static_cast<uint8_t>(status);
+        reply.report.executed_quantity = static_cast<uint32_t>(executed);
+        reply.report.open_quantity = resting ? static_cast<uint32_t>(resting->getOpenQuantity())
+                                             : 0;
+        if (resting != nullptr) addOwner(order_id, symbol_id, reply.connection);
+    }
+
+    void handleCancel(const IO::CancelOrderMessage& message, detail::GatewayReply& reply) {
+        reply.ack.client_order_id = message.client_order_id;
+        uint32_t symbol_id = symbols.symbolId(message.instrument_id);
+        if (symbol_id == symbols.unknown()) {
+            reply.ack.reason = static_cast<uint8_t>(IO::OrderEntryReject::UnknownSymbol);
+            return;
+        }
+        // Only the connection that placed an order may cancel it, others can not tell it exists.
+        auto owner = owner_of.find(message.order_id);
+        if (owner == owner_of.end() || owner->second.connection != reply.connection) {
+            reply.ack.reason = static_cast<uint8_t>(IO::OrderEntryReject::UnknownOrder);
+            return;
+        }
+        const Order* resting = market.findOrder(symbol_id, message.order_id);
+        if (resting == nullptr) {
+            if (owner->second.symbol_id == symbol_id) owner_of.erase(owner);  // Filled meanwhile.
+            reply.ack.reason = static_cast<uint8_t>(IO::OrderEntryReject::UnknownOrder);
+            return;
+        }
+        reply.ack.accepted = 1;
+        reply.ack.order_id = message.order_id;
+        reply.has_report = true;
+        reply.report.status = static_cast<uint8_t>(IO::ExecutionStatus::Cancelled);
+        reply.report.executed_quantity = static_cast<uint32_t>(resting->getExecutedQuantity());
+        reply.report.open_quantity = static_cast<uint32_t>(resting->getOpenQuantity());
+        market.deleteOrder(symbol_id, message.order_id);
+        owner_of.erase(owner);
+    }
+
+    void addOwner(uint64_t order_id, uint32_t symbol_id, uint64_t connection) {
+        owner_of.emplace(order_id, OrderOwner{connection, symbol_id});
+        if (owner_of.size() > 2 * owners_after_sweep + kMinOwnerSweep) sweepOwners();
+    }
+
+    /*
+     * Drops the owners of orders that later orders filled, which the book does
+     * not report. Runs once the map doubled since the last sweep, so it costs
+     * O(1) per order.
+     */
+    void sweepOwners() {
+        for (auto it = owner_of.begin(); it != owner_of.end();) {
+            if (market.findOrder(it->second.symbol_id, it->first) == nullptr)
+                it = owner_of.erase(it);
+            else
+                ++it;
+        }
+        owners_after_sweep = owner_of.size();
+    }
+
+    void closeAll() {
+        for (auto& entry : connections_by_id) close(entry.second.fd);
+        connections_by_id.clear();
+        for (int fd : {listen_fd, epoll_fd, wake_fd, reply_fd, command_fd})
+            if (fd != -1) close(fd);
+        listen_fd = epoll_fd = wake_fd = reply_fd = command_fd = -1;
+    }
+
+    /* The connection that placed a resting order, and its symbol to look the order up. */
+    struct OrderOwner {
+        uint64_t connection;
+        uint32_t symbol_id;
+    };
+    OrderGatewayOptions options;
+
+    // Matching thread.
+    IO::SymbolTable symbols;
+    Market market;
+    uint64_t last_order_id = 0;  // Order ids start at 1, 0 means none in acks.
+    std::unordered_map<uint64_t, OrderOwner> owner_of;  // By order id, see handleCancel().
+    size_t owners_after_sweep = 0;
+
+    // Network thread.
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    int reply_fd = -1;    // Signalled by the matching thread when replies are queued.
+    int command_fd = -1;  // Signalled by the network thread when the matcher sleeps.
+    uint16_t bound_port = 0;
+    uint64_t next_connection = kFirstConnection;
+    std::unordered_map<uint64_t, Connection> connections_by_id;
+
+    Concurrent::SpscQueue<detail::GatewayCommand> commands;
+    Concurrent::SpscQueue<detail::GatewayReply> replies;
+    std::atomic_bool matcher_sleeping{false};
+    std::atomic_bool matcher_stopping{false};
+    std::atomic_bool stopping{false};
+    std::atomic<uint64_t> request_count{0};
+    std::atomic<size_t> open_connections{0};
+};
+}  // namespace UBIEngine
+#endif  // UBI_TRADER_ENGINE_ORDER_GATEWAY_H
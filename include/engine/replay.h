@@ -0,0 +1,278 @@
+#ifndef UBI_TRADER_ENGINE_REPLAY_H
+#define UBI_TRADER_ENGINE_REPLAY_H
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "engine/sorted_output.h"
+#include "io/order_event.h"
+#include "io/reader.h"
+#include "io/type.h"
+#include "market.h"
+#include "symbol.h"
+#include "utils/trace.h"
+
+namespace UBIEngine {
+/**
+ * TWAP parameters of one replay session: every alpha signal is split into
+ * `session_num` slices that are `session_length` seconds apart.
+ */
+struct SessionConfig {
+    uint32_t session_num;
+    uint32_t session_length;
+};
+
+/**
+ * The kinds of event the replay loop processes.
+ */
+enum class ReplayEvent {
+    Order,     // A historical order from order_log.
+    Alpha,     // An alpha signal that is split into TWAP slices.
+    Strategy   // A TWAP slice that is sent to the market.
+};
+
+/**
+ * The default replay observer, every hook is empty and compiles away.
+ */
+struct NullReplayObserver {
+    void onStart() {}
+    void onEvent(ReplayEvent) {}
+};
+
+namespace detail {
+/**
+ * Maps the instrument of a historical order to its symbol id. Raw rows go
+ * through the SymbolManager, dictionary coded events (IO::order_event) are
+ * resolved once per code and then cached.
+ */
+class SymbolResolver {
+   public:
+    explicit SymbolResolver(SymbolManager& symbol_manager_) : symbol_manager(symbol_manager_) {}
+
+    template <typename OrderQueue>
+    uint32_t operator()(const OrderQueue&, const IO::order_log& row) {
+        return symbol_manager.getSymbolId(row.instrument_id);
+    }
+
+    template <typename OrderQueue>
+    uint32_t operator()(const OrderQueue& queue, const IO::order_event& event) {
+        if (event.instrument >= symbol_of_code.size()) {
+            symbol_of_code.resize(event.instrument + 1, kUnresolved);
+        }
+        uint32_t& symbol_id = symbol_of_code[event.instrument];
+        if (symbol_id == kUnresolved) {
+            symbol_id = symbol_manager.getSymbolId(queue.instrumentId(event.instrument));
+        }
+        return symbol_id;
+    }
+
+   private:
+    static constexpr uint32_t kUnresolved = UINT32_MAX;
+
+    SymbolManager& symbol_manager;
+    std::vector<uint32_t> symbol_of_code;
+};
+}  // namespace detail
+
+/**
+ * Replays one session over the input queues. This is the body of the original
+ * `solve()` main loop, it is shared by `engine_main` and `bench_replay`.
+ *
+ * @tparam OrderQueue a queue of IO::order_log (`empty`/`front`/`pop`/`size`), or of
+ *                    IO::order_event that also provides `instrumentId(code)`.
+ * @tparam AlphaQueue a queue of IO::alpha (`empty`/`front`/`pop`/`size`).
+ * @tparam PrevInfos an iterable range of IO::prev_trade_info.
+ * @tparam TwapRecords std::vector<IO::twap_order> or another container that
+ *                     SortedTwapOutput accepts, e.g. IO::MappedRecords.
+ * @tparam Observer receives `onStart()` before the main loop and `onEvent()` after
+ *                  every processed event.
+ * @param order_queue the historical orders, consumed by the replay.
+ * @param alpha_queue the alpha signals, consumed by the replay.
+ * @param prev_trade_infos the previous close price and position of each symbol.
+ * @param config the TWAP parameters of the session.
+ * @param ans the TWAP orders are appended to it in (timestamp, instrument_id) order,
+ *            require that it is sorted already (e.g. empty).
+ * @param pnls the pnl and position of each symbol are appended to it in instrument_id
+ *             order.
+ * @param observer the observer of the replay.
+ * @return the number of processed events.
+ */
+template <typename OrderQueue, typename AlphaQueue, typename PrevInfos, typename TwapRecords,
+          typename Observer = NullReplayObserver>
+uint64_t replaySession(OrderQueue& order_queue, AlphaQueue& alpha_queue,
+                       const PrevInfos& prev_trade_infos, const SessionConfig& config,
+                       TwapRecords& ans, std::vector<IO::pnl_and_pos>& pnls,
+                       Observer&& observer = Observer()) {
+    const uint32_t session_num = config.session_num;
+    const uint32_t session_length = config.session_length;
+    std::priority_queue<IO::twap_order, std::vector<IO::twap_order>, IO::priority_cmp>
+        strategy_queue;
+
+    std::cout << "Start init symbol_manager and market!\n";
+    /* Init market */
+    Market market;
+    SymbolManager symbol_manager;
+    for (const auto& prev_info : prev_trade_infos) {
+        // 首先这样可以获得 char[8] to uint32_t 的转换。
+        symbol_manager.getSymbolId(prev_info.instrument_id);
+        // 把对应的 symbol 加入到 market 中。
+        market.addSymbol(symbol_manager.getSymbolId(prev_info.instrument_id),
+                         std::string(prev_info.instrument_id),
+                         static_cast<uint64_t>(prev_info.prev_close_price * 100 + 0.5),
+                         prev_info.prev_position);
+    }
+
+    detail::SymbolResolver resolve_symbol(symbol_manager);
+    uint64_t order_id = 0;
+    uint64_t event_count = 0;
+    // 为了方便，直接分配好内存。
+    ans.reserve(ans.size() + alpha_queue.size() * session_num);
+    // 按输出顺序插入，session 结束后不再排序。
+    SortedTwapOutput twap_output(ans);
+    std::cout << "[Start]: " << session_num << "_" << session_length << std::endl;
+    auto start_time = std::chrono::steady_clock::now();
+    observer.onStart();
+    /* main loop */
+    while (!order_queue.empty() || !alpha_queue.empty() || !strategy_queue.empty()) {
+        // 即使时间相同，也要先处理order_log。
+        if (!order_queue.empty() &&
+            (alpha_queue.empty() || order_queue.front().timestamp <= alpha_queue.front().timestamp) &&
+            (strategy_queue.empty() ||
+             order_queue.front().timestamp <= strategy_queue.top().timestamp)) {
+            const auto& raw_order = order_queue.front();
+            order_queue.pop();
+            ++event_count;
+            uint32_t symbol_id = resolve_symbol(order_queue, raw_order);
+            OrderSide side = raw_order.direction == 1 ? OrderSide::Bid : OrderSide::Ask;
+            //! 获取基准价格
+            auto basePrice = market.getBasePrice(symbol_id, side);
+            //! Only LIMIT order has price_off.
+            int32_t price_off_int = IO::priceOffTicks(raw_order);
+
+            uint32_t price = raw_order.type == 0 ? basePrice + price_off_int : 0;
+            Order order = Order::newOrder(int2OrderType(raw_order.type), side, order_id++,
+                                          symbol_id, raw_order.volume, price,
+                                          false  // is Strategy Order?
+            );
+
+            // Check 下价格是否合法
+            if (price_off_int < 0 && basePrice < -price_off_int) {
+                std::cout << ">>>>>>>>>> Price off is too large! <<<<<<<<<<\n";
+                UBI_TRACE_EVENT(RejectedOrder, symbol_id, raw_order.timestamp,
+                                raw_order.direction, raw_order.type, raw_order.volume, price,
+                                basePrice);
+                observer.onEvent(ReplayEvent::Order);
+                continue;
+            }
+
+            // Rejected orders are traced as RejectedOrder only.
+            UBI_TRACE_EVENT(HistoryOrder, symbol_id, raw_order.timestamp, raw_order.direction,
+                            raw_order.type, raw_order.volume, price, basePrice,
+                            market.getUpLimit(symbol_id, side),
+                            market.getDownLimit(symbol_id, side));
+            market.addOrder(order);
+            observer.onEvent(ReplayEvent::Order);
+        }
+        // 处理信号
+        if (!alpha_queue.empty() &&
+            (order_queue.empty() || alpha_queue.front().timestamp < order_queue.front().timestamp) &&
+            (strategy_queue.empty() ||
+             alpha_queue.front().timestamp <= strategy_queue.top().timestamp)) {
+            auto alpha_t = alpha_queue.front();
+            alpha_queue.pop();
+            ++event_count;
+
+            uint32_t symbol_id = symbol_manager.getSymbolId(alpha_t.instrument_id);
+            const auto& pnl_helper = market.getPnlHelper(symbol_id);
+            int32_t diff = alpha_t.target_volume - pnl_helper.getPosition();
+
+            //! If diff == 0, skip!!
+            if (diff == 0) {
+                observer.onEvent(ReplayEvent::Alpha);
+                continue;
+            }
+
+            // 通过 diff 判断是 Bid or Ask
+            int32_t strategy_side = diff > 0 ? 1 : -1;
+            // 并且下单的量肯定是 diff 的绝对值
+            uint64_t volume = std::abs(diff);
+
+            for (int part_id = 0; part_id < session_num; ++part_id) {
+                int32_t part_volume =
+                    (volume * (part_id + 1) / session_num) - (volume * part_id / session_num);
+                IO::emplaceTwapOrder_queue(strategy_queue, alpha_t.instrument_id,
+                                           alpha_t.timestamp + part_id * session_length * 1000,
+                                           strategy_side, part_volume,
+                                           static_cast<double>(0)  // ! Note 需要就地构造
+                );
+            }
+            observer.onEvent(ReplayEvent::Alpha);
+        }
+
+        // 处理策略单
+        if (!strategy_queue.empty() &&
+            (order_queue.empty() ||
+             strategy_queue.top().timestamp < order_queue.front().timestamp) &&
+            (alpha_queue.empty() || strategy_queue.top().timestamp < alpha_queue.front().timestamp)) {
+            auto strategy_order = strategy_queue.top();
+            strategy_queue.pop();
+            ++event_count;
+
+            uint32_t symbol_id = symbol_manager.getSymbolId(strategy_order.instrument_id);
+            OrderSide side = strategy_order.direction == 1 ? OrderSide::Bid : OrderSide::Ask;
+            //! 获取基准价格.
+            auto basePrice = market.getBasePrice(symbol_id, side);
+
+            // Must be LIMIT order.
+            uint32_t price = basePrice;
+            double price_double = static_cast<double>(price) / 100;
+
+            twap_output.emplace(strategy_order.instrument_id, strategy_order.timestamp,
+                                strategy_order.direction, strategy_order.volume, price_double);
+
+            UBI_TRACE_EVENT(TwapOrder, symbol_id, strategy_order.timestamp,
+                            strategy_order.direction, 0, strategy_order.volume, price, basePrice);
+
+            // 如果 volume == 0, 则不进入撮合系统.
+            if (strategy_order.volume == 0) {
+                observer.onEvent(ReplayEvent::Strategy);
+                continue;
+            }
+
+            Order order = Order::newOrder(OrderType::LIMIT, side, order_id++, symbol_id,
+                                          strategy_order.volume, price,
+                                          true  // is Strategy Order?
+            );
+            market.addOrder(order);
+            observer.onEvent(ReplayEvent::Strategy);
+        }
+    }
+
+    twap_output.finish();
+    auto end_time = std::chrono::steady_clock::now();
+    std::cout << "[Done]: " << session_num << "_" << session_length << " Cost Time: "
+              << static_cast<double>(
+                     std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time)
+                         .count()) /
+                     1000
+              << "s" << std::endl;
+
+    // 按 instrument_id 的顺序输出，不再排序。
+    for (uint32_t index : instrumentOrder(prev_trade_infos)) {
+        const auto& prev_info = prev_trade_infos[index];
+        int64_t pnl = market.calculatePnl(symbol_manager.getSymbolId(prev_info.instrument_id));
+        double pnl_double = static_cast<double>(pnl) / 100;
+        IO::emplacePnlAndPos_vec(
+            pnls, prev_info.instrument_id,
+            market.getPnlHelper(symbol_manager.getSymbolId(prev_info.instrument_id)).getPosition(),
+            pnl_double);
+    }
+    return event_count;
+}
+}  // namespace UBIEngine
+#endif  // UBI_TRADER_ENGINE_REPLAY_H
@@ -0,0 +1,144 @@
+#ifndef UBI_TRADER_ENGINE_SORTED_OUTPUT_H
+#define UBI_TRADER_ENGINE_SORTED_OUTPUT_H
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "io/type.h"
+#include "utils/radix_sort.h"
+#include "utils/sort.h"
+
+namespace UBIEngine {
+/**
+ * Appends twap_orders to a container in output order, (timestamp, instrument_id)
+ * like Utils::my_compare_twap, so the vector never has to be sorted.
+ *
+ * The replay emits TWAP slices in time order, only slices with the same
+ * timestamp come in heap order, which does not look at the instrument. The
+ * orders of the last timestamp (the open group) are therefore appended as
+ * they come and sorted by their cached instrument keys once, when a later
+ * timestamp arrives or at finish(): O(g log g) for a group of g orders, even
+ * if thousands of instruments share an alpha timestamp. Orders with equal keys
+ * keep the order they were emitted in, as with a stable sort. An order that is
+ * older than the last one, which the replay never emits, is still inserted at
+ * its place.
+ *
+ * `Records` is a std::vector<twap_order> or any container with its
+ * `push_back`, `insert`, `back` and indexing, e.g. IO::MappedRecords to write
+ * into the output file.
+ */
+template <typename Records = std::vector<IO::twap_order>>
+class SortedTwapOutput {
+   public:
+    /* `ans` must be sorted already, e.g. empty. */
+    explicit SortedTwapOutput(Records& ans_) : ans(ans_) { resetGroup(); }
+
+    SortedTwapOutput(const SortedTwapOutput&) = delete;
+    SortedTwapOutput& operator=(const SortedTwapOutput&) = delete;
+
+    ~SortedTwapOutput() { finish(); }
+
+    void emplace(const char* instrument_id, long timestamp, int32_t direction, int32_t volume,
+                 double price) {
+        IO::twap_order order;
+        std::memcpy(order.instrument_id, instrument_id, sizeof(order.instrument_id));
+        order.timestamp = timestamp;
+        order.direction = direction;
+        order.volume = volume;
+        order.price = price;
+
+        if (ans.empty() || timestamp > ans.back().timestamp) {
+            // A new group, the common case.
+            finish();
+            group_begin = ans.size();
+            group_keys.clear();
+        } else if (timestamp < ans.back().timestamp) {
+            insertOutOfOrder(order);
+            return;
+        }
+        uint64_t key = Utils::instrumentSortKey(order.instrument_id);
+        group_sorted = group_sorted && (group_keys.empty() || group_keys.back() <= key);
+        group_keys.push_back(key);
+        ans.push_back(order);
+    }
+
+    /* Sorts the open group, call it before reading `ans`. The destructor calls it too. */
+    void finish() {
+        if (group_sorted) return;
+        group_sorted = true;
+        const size_t size = group_keys.size();
+        // (key, position) pairs are unique, so an unstable sort keeps equal keys in order.
+        order_of.resize(size);
+        for (size_t i = 0; i < size; ++i) order_of[i] = i;
+        std::sort(order_of.begin(), order_of.end(), [&](size_t a, size_t b) {
+            return group_keys[a] != group_keys[b] ? group_keys[a] < group_keys[b] : a < b;
+        });
+        group.clear();
+        for (size_t i = 0; i < size; ++i) group.push_back(ans[group_begin + i]);
+        sorted_keys.resize(size);
+        for (size_t i = 0; i < size; ++i) {
+            ans[group_begin + i] = group[order_of[i]];
+            sorted_keys[i] = group_keys[order_of[i]];
+        }
+        group_keys.swap(sorted_keys);
+    }
+
+   private:
+    void insertOutOfOrder(const IO::twap_order& order) {
+        finish();
+        auto it = std::upper_bound(ans.begin(), ans.end(), order, Utils::my_compare_twap);
+        ans.insert(it, order);
+        resetGroup();
+    }
+
+    /* Finds the group of the last timestamp and caches its keys, `ans` is sorted. */
+    void resetGroup() {
+        group_begin = ans.size();
+        while (group_begin > 0 && ans[group_begin - 1].timestamp == ans.back().timestamp)
+            --group_begin;
+        group_keys.clear();
+        for (size_t i = group_begin; i < ans.size(); ++i)
+            group_keys.push_back(Utils::instrumentSortKey(ans[i].instrument_id));
+        group_sorted = true;
+    }
+
+    Records& ans;
+    size_t group_begin = 0;
+    std::vector<uint64_t> group_keys;  // The keys of ans[group_begin, end).
+    // Whether ans[group_begin, end) is in key order already, e.g. when it is small.
+    bool group_sorted = true;
+    // Buffers of finish(), kept between groups.
+    std::vector<size_t> order_of;
+    std::vector<IO::twap_order> group;
+    std::vector<uint64_t> sorted_keys;
+};
+
+/* The O(n) check of the output order of twap_orders. */
+template <typename Records = std::vector<IO::twap_order>>
+bool isSortedTwapOutput(const Records& ans) {
+    return std::is_sorted(ans.begin(), ans.end(), Utils::my_compare_twap);
+}
+
+/* The O(n) check of the output order of pnl_and_pos. */
+inline bool isSortedPnlOutput(const std::vector<IO::pnl_and_pos>& pnls) {
+    return std::is_sorted(pnls.begin(), pnls.end(), Utils::my_compare_pnl);
+}
+
+/**
+ * The positions of prev_trade_infos in instrument_id order, duplicates in
+ * input order. Pnls written in this order need no sort.
+ */
+template <typename PrevInfos>
+std::vector<uint32_t> instrumentOrder(const PrevInfos& prev_trade_infos) {
+    std::vector<uint64_t> keys;
+    for (const auto& prev_info : prev_trade_infos)
+        keys.push_back(Utils::instrumentSortKey(prev_info.instrument_id));
+    std::vector<uint32_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<uint32_t>(i);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+    return order;
+}
+}  // namespace UBIEngine
+#endif  // UBI_TRADER_ENGINE_SORTED_OUTPUT_H
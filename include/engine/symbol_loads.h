@@ -0,0 +1,34 @@
+#ifndef UBI_TRADER_ENGINE_SYMBOL_LOADS_H
+#define UBI_TRADER_ENGINE_SYMBOL_LOADS_H
+#include <cstdint>
+
+#include "concurrent_market.h"
+#include "io/symbol_index.h"
+
+namespace UBIEngine {
+/**
+ * The events of each symbol of `index`, the initial load for
+ * ConcurrentMarket::placeSymbols(). Unknown instruments are left out, the
+ * replay drops them.
+ */
+inline SymbolLoads symbolLoads(const IO::SymbolIndex& index) {
+    SymbolLoads loads;
+    for (uint32_t symbol_id = 0; symbol_id < index.symbolCount(); ++symbol_id) {
+        if (index.count(symbol_id) != 0) loads[symbol_id] = index.count(symbol_id);
+    }
+    return loads;
+}
+
+/**
+ * Counts the events of each symbol in order_log, see symbolLoads().
+ *
+ * @tparam OrderRows a random access range of IO::order_log, e.g. IO::RecordFile.
+ * @param symbols the symbol table of prev_trade_info, whose ids are the ones
+ *                the replay gives its SymbolManager.
+ */
+template <typename OrderRows>
+SymbolLoads countSymbolEvents(const OrderRows& order_rows, const IO::SymbolTable& symbols) {
+    return symbolLoads(IO::SymbolIndex(order_rows, symbols));
+}
+}  // namespace UBIEngine
+#endif  // UBI_TRADER_ENGINE_SYMBOL_LOADS_H
@@ -0,0 +1,558 @@
+#ifndef UBI_TRADER_IO_ARCHIVE_H
+#define UBI_TRADER_IO_ARCHIVE_H
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "io/order_event.h"
+#include "io/reader.h"
+#include "io/type.h"
+#include "io/varint.h"
+#include "utils/robin_hood.h"
+
+namespace UBIEngine::IO {
+/**
+ * Columnar archive of order_log
+ * =============================
+ *
+ * File layout: `ArchiveHeader | block 0 | block 1 | ... | dictionary | block index`.
+ *
+ * Every block holds up to `block_records` rows, stored column by column:
+ *
+ * - timestamp: the first one in the block header, then delta-of-delta, with a
+ *   prefix code of 1 bit for 0 and 9/15/24/68 bits for larger values.
+ * - instrument: a code into the file dictionary of instrument ids, bit-packed.
+ * - type and direction: 3 + 1 bits.
+ * - volume: frame of reference (minimum and gcd of the block), bit-packed.
+ * - price offset: rounded to ticks exactly like the replay, frame of reference,
+ *   bit-packed. Only LIMIT orders keep it.
+ *
+ * The archive is lossless for the replay: decoding a block gives the
+ * order_events the replay would derive from the raw rows. The direction is
+ * kept as bid (1) or ask (-1), and `price_off` as its tick count.
+ */
+inline constexpr char kArchiveMagic[8] = {'U', 'B', 'I', 'O', 'L', 'O', 'G', '1'};
+inline constexpr uint32_t kArchiveVersion = 1;
+
+struct ArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_records;
+    uint64_t record_count;
+    uint64_t dictionary_offset;
+    uint32_t dictionary_size;
+    uint32_t block_count;
+    uint64_t index_offset;
+} __attribute__((packed));
+
+struct ArchiveBlockIndex {
+    uint64_t offset;
+    uint32_t count;
+    uint32_t bytes;
+    int64_t first_timestamp;
+    int64_t last_timestamp;
+} __attribute__((packed));
+
+struct ArchiveBlockHeader {
+    int64_t first_timestamp;
+    int64_t volume_min;
+    uint32_t volume_gcd;
+    int32_t tick_min;
+    uint8_t code_width;
+    uint8_t volume_width;
+    uint8_t tick_width;
+    uint8_t reserved;
+    // The byte length of each column: timestamp, instrument, type/direction, volume, tick.
+    uint32_t column_bytes[5];
+} __attribute__((packed));
+
+namespace detail {
+inline uint8_t bitWidth(uint64_t value) {
+    return value == 0 ? 0 : static_cast<uint8_t>(64 - __builtin_clzll(value));
+}
+
+/* Appends values of 0 to 64 bits, least significant bit first. */
+class BitWriter {
+   public:
+    void write(uint64_t value, unsigned bits) {
+        if (bits > 32) {
+            write(value & 0xffffffffu, 32);
+            write(value >> 32, bits - 32);
+            return;
+        }
+        if (bits == 0) return;
+        acc |= (value & ((1ull << bits) - 1)) << used;
+        used += bits;
+        while (used >= 8) {
+            bytes.push_back(static_cast<uint8_t>(acc));
+            acc >>= 8;
+            used -= 8;
+        }
+    }
+
+    /* Flushes the last partial byte and returns the stream. */
+    const std::vector<uint8_t>& finish() {
+        if (used > 0) bytes.push_back(static_cast<uint8_t>(acc));
+        acc = 0;
+        used = 0;
+        return bytes;
+    }
+
+   private:
+    std::vector<uint8_t> bytes;
+    uint64_t acc = 0;
+    unsigned used = 0;
+};
+
+/* Reads what BitWriter wrote. Reading past the end yields zero bits. */
+class BitReader {
+   public:
+    BitReader(const uint8_t* begin, const uint8_t* end) : pos(begin), end(end) {}
+
+    uint64_t read(unsigned bits) {
+        if (bits > 32) {
+            uint64_t low = read(32);
+            return low | (read(bits - 32) << 32);
+        }
+        if (bits == 0) return 0;
+        while (available < bits) {
+            acc |= static_cast<uint64_t>(pos < end ? *pos++ : 0) << available;
+            available += 8;
+        }
+        uint64_t value = acc & ((1ull << bits) - 1);
+        acc >>= bits;
+        available -= bits;
+        return value;
+    }
+
+   private:
+    const uint8_t* pos;
+    const uint8_t* end;
+    uint64_t acc = 0;
+    unsigned available = 0;
+};
+
+/* The prefix code of timestamp delta-of-deltas: 0, then 7, 12 and 20 bit buckets. */
+inline void writeDeltaOfDelta(BitWriter& writer, int64_t dod) {
+    if (dod == 0) {
+        writer.write(0, 1);
+        return;
+    }
+    uint64_t value = zigzag(dod);
+    if (value < (1u << 7)) {
+        writer.write(0b01, 2);
+        writer.write(value, 7);
+    } else if (value < (1u << 12)) {
+        writer.write(0b011, 3);
+        writer.write(value, 12);
+    } else if (value < (1u << 20)) {
+        writer.write(0b0111, 4);
+        writer.write(value, 20);
+    } else {
+        writer.write(0b1111, 4);
+        writer.write(value, 64);
+    }
+}
+
+inline int64_t readDeltaOfDelta(BitReader& reader) {
+    if (reader.read(1) == 0) return 0;
+    if (reader.read(1) == 0) return unzigzag(reader.read(7));
+    if (reader.read(1) == 0) return unzigzag(reader.read(12));
+    if (reader.read(1) == 0) return unzigzag(reader.read(20));
+    return unzigzag(reader.read(64));
+}
+}  // namespace detail
+
+/**
+ * Writes an order_log archive row by row, so that files of any size are
+ * converted with the memory of one block.
+ *
+ * The rows go to filePath + ".tmp", which close() renames to filePath. A
+ * writer that is destroyed without a successful close(), e.g. because append()
+ * threw, removes the temporary file, so filePath never holds a partial archive.
+ */
+class OrderArchiveWriter {
+   public:
+    explicit OrderArchiveWriter(const std::string& filePath, uint32_t block_records_ = 1 << 16)
+        : path(filePath),
+          temp_path(filePath + ".tmp"),
+          out(temp_path, std::ios::binary | std::ios::trunc),
+          block_records(block_records_) {
+        if (!out) throw std::runtime_error("Error opening file for writing: " + temp_path);
+        if (block_records == 0) {
+            abandon();
+            throw std::invalid_argument("block_records must be positive");
+        }
+        ArchiveHeader header{};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        offset = sizeof(header);
+        rows.reserve(block_records);
+    }
+
+    /* Without close() the archive is incomplete, so it is dropped rather than finalized. */
+    ~OrderArchiveWriter() {
+        if (!closed) abandon();
+    }
+
+    OrderArchiveWriter(const OrderArchiveWriter&) = delete;
+    OrderArchiveWriter& operator=(const OrderArchiveWriter&) = delete;
+
+    void append(const order_log& row) {
+        if (closed) throw std::logic_error("Append to a closed archive writer");
+        if (row.type < 0 || row.type > 7) {
+            failed = true;
+            throw std::runtime_error("Unsupported order type: " + std::to_string(row.type));
+        }
+        rows.push_back(row);
+        if (rows.size() == block_records) {
+            try {
+                flushBlock();
+            } catch (...) {
+                failed = true;
+                throw;
+            }
+        }
+    }
+
+    /**
+     * Writes the last block, the dictionary and the index, then moves the
+     * archive to its path. Throws, leaving nothing behind, if an append()
+     * failed or the archive can not be written.
+     */
+    void close() {
+        if (closed) return;
+        closed = true;
+        if (failed) {
+            abandon();
+            throw std::runtime_error("Archive not written after a failed append: " + path);
+        }
+        try {
+            finish();
+        } catch (...) {
+            abandon();
+            throw;
+        }
+    }
+
+    /* The bytes written so far. */
+    uint64_t bytes() const { return offset; }
+
+   private:
+    void finish() {
+        flushBlock();
+
+        ArchiveHeader header{};
+        std::memcpy(header.magic, kArchiveMagic, sizeof(header.magic));
+        header.version = kArchiveVersion;
+        header.block_records = block_records;
+        header.record_count = record_count;
+        header.dictionary_offset = offset;
+        header.dictionary_size = static_cast<uint32_t>(dictionary.size());
+        for (uint64_t key : dictionary) write(&key, sizeof(key));
+        header.block_count = static_cast<uint32_t>(index.size());
+        header.index_offset = offset;
+        write(index.data(), index.size() * sizeof(ArchiveBlockIndex));
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        if (!out) throw std::runtime_error("Error writing archive: " + temp_path);
+        if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Error renaming " + temp_path + " to " + path);
+        }
+    }
+
+    void abandon() noexcept {
+        closed = true;
+        out.close();
+        std::remove(temp_path.c_str());
+    }
+
+    void flushBlock() {
+        if (rows.empty()) return;
+        ArchiveBlockHeader header{};
+        header.first_timestamp = rows.front().timestamp;
+
+        std::vector<uint32_t> codes(rows.size());
+        std::vector<int32_t> ticks(rows.size());
+        uint32_t max_code = 0;
+        int64_t volume_min = rows.front().volume;
+        int32_t tick_min = 0, tick_max = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            codes[i] = code(rows[i].instrument_id);
+            max_code = std::max(max_code, codes[i]);
+            volume_min = std::min<int64_t>(volume_min, rows[i].volume);
+            ticks[i] = priceOffTicks(rows[i]);
+            if (i == 0 || ticks[i] < tick_min) tick_min = ticks[i];
+            if (i == 0 || ticks[i] > tick_max) tick_max = ticks[i];
+        }
+        uint64_t volume_gcd = 0;
+        uint64_t volume_max = 0;
+        for (const auto& row : rows) {
+            uint64_t volume = static_cast<uint64_t>(row.volume - volume_min);
+            volume_gcd = std::gcd(volume_gcd, volume);
+            volume_max = std::max(volume_max, volume);
+        }
+        if (volume_gcd == 0) volume_gcd = 1;
+        header.volume_min = volume_min;
+        header.volume_gcd = static_cast<uint32_t>(volume_gcd);
+        header.tick_min = tick_min;
+        header.code_width = detail::bitWidth(max_code);
+        header.volume_width = detail::bitWidth(volume_max / volume_gcd);
+        header.tick_width = detail::bitWidth(static_cast<uint64_t>(int64_t{tick_max} - tick_min));
+
+        detail::BitWriter columns[5];
+        int64_t prev_timestamp = header.first_timestamp;
+        int64_t prev_delta = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const auto& row = rows[i];
+            if (i > 0) {
+                int64_t delta = row.timestamp - prev_timestamp;
+                detail::writeDeltaOfDelta(columns[0], delta - prev_delta);
+                prev_delta = delta;
+                prev_timestamp = row.timestamp;
+            }
+            columns[1].write(codes[i], header.code_width);
+            columns[2].write(static_cast<uint64_t>(row.type) | (row.direction == 1 ? 8u : 0u), 4);
+            columns[3].write((row.volume - volume_min) / volume_gcd, header.volume_width);
+            columns[4].write(static_cast<uint64_t>(int64_t{ticks[i]} - tick_min), header.tick_width);
+        }
+
+        uint64_t block_offset = offset;
+        uint32_t block_bytes = sizeof(header);
+        for (int c = 0; c < 5; ++c) {
+            header.column_bytes[c] = static_cast<uint32_t>(columns[c].finish().size());
+            block_bytes += header.column_bytes[c];
+        }
+        write(&header, sizeof(header));
+        for (auto& column : columns) {
+            const auto& bytes = column.finish();
+            write(bytes.data(), bytes.size());
+        }
+        index.push_back({block_offset, static_cast<uint32_t>(rows.size()), block_bytes,
+                         rows.front().timestamp, rows.back().timestamp});
+        record_count += rows.size();
+        rows.clear();
+    }
+
+    uint32_t code(const char* instrument_id) {
+        uint64_t key = instrumentKey(instrument_id);
+        auto it = codes_of.find(key);
+        if (it != codes_of.end()) return it->second;
+        auto new_code = static_cast<uint32_t>(dictionary.size());
+        codes_of.emplace(key, new_code);
+        dictionary.push_back(key);
+        return new_code;
+    }
+
+    void write(const void* data, size_t size) {
+        out.write(static_cast<const char*>(data), size);
+        offset += size;
+    }
+
+    std::string path;
+    std::string temp_path;
+    std::ofstream out;
+    uint32_t block_records;
+    uint64_t offset = 0;
+    uint64_t record_count = 0;
+    bool closed = false;
+    bool failed = false;  // An append() threw, the rows on disk are incomplete.
+    std::vector<order_log> rows;
+    std::vector<ArchiveBlockIndex> index;
+    std::vector<uint64_t> dictionary;
+    robin_hood::unordered_map<uint64_t, uint32_t> codes_of;
+};
+
+/**
+ * A mapped order_log archive. Blocks are decoded independently, straight
+ * into order_events.
+ */
+class OrderArchive {
+   public:
+    explicit OrderArchive(const std::string& filePath) : file(filePath) {
+        if (file.size() < sizeof(ArchiveHeader)) {
+            throw std::runtime_error("Not an order_log archive: " + filePath);
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, kArchiveMagic, sizeof(header.magic)) != 0 ||
+            header.version != kArchiveVersion) {
+            throw std::runtime_error("Not an order_log archive: " + filePath);
+        }
+        if (header.dictionary_offset + uint64_t{header.dictionary_size} * 8 > file.size() ||
+            header.index_offset + uint64_t{header.block_count} * sizeof(ArchiveBlockIndex) >
+                file.size()) {
+            throw std::runtime_error("Truncated order_log archive: " + filePath);
+        }
+        dictionary.resize(header.dictionary_size);
+        for (uint32_t i = 0; i < header.dictionary_size; ++i) {
+            std::memcpy(dictionary[i].id, file.data() + header.dictionary_offset + i * 8, 8);
+            dictionary[i].id[8] = '\0';
+        }
+        index.resize(header.block_count);
+        std::memcpy(index.data(), file.data() + header.index_offset,
+                    index.size() * sizeof(ArchiveBlockIndex));
+        for (const auto& block : index) {
+            if (block.offset + block.bytes > file.size()) {
+                throw std::runtime_error("Truncated order_log archive: " + filePath);
+            }
+        }
+    }
+
+    /* The number of rows. */
+    size_t size() const { return header.record_count; }
+    size_t bytes() const { return file.size(); }
+    size_t blockCount() const { return index.size(); }
+    const ArchiveBlockIndex& block(size_t i) const { return index[i]; }
+    size_t dictionarySize() const { return dictionary.size(); }
+
+    /* The null terminated instrument id of a dictionary code. */
+    const char* instrumentId(uint32_t code) const { return dictionary[code].id; }
+
+    /**
+     * Decodes a block.
+     *
+     * @param i the block, require that it is less than blockCount().
+     * @param out receives `block(i).count` events.
+     */
+    void decodeBlock(size_t i, order_event* out) const {
+        const ArchiveBlockIndex& entry = index[i];
+        const uint8_t* data = file.data() + entry.offset;
+        ArchiveBlockHeader block_header;
+        std::memcpy(&block_header, data, sizeof(block_header));
+        const uint8_t* column = data + sizeof(block_header);
+        const uint8_t* end = data + entry.bytes;
+        const uint32_t count = entry.count;
+
+        detail::BitReader timestamps(column, std::min(end, column + block_header.column_bytes[0]));
+        column += block_header.column_bytes[0];
+        int64_t timestamp = block_header.first_timestamp;
+        int64_t delta = 0;
+        out[0].timestamp = timestamp;
+        for (uint32_t r = 1; r < count; ++r) {
+            delta += detail::readDeltaOfDelta(timestamps);
+            timestamp += delta;
+            out[r].timestamp = timestamp;
+        }
+
+        detail::BitReader codes(column, std::min(end, column + block_header.column_bytes[1]));
+        column += block_header.column_bytes[1];
+        for (uint32_t r = 0; r < count; ++r) {
+            out[r].instrument = static_cast<uint32_t>(codes.read(block_header.code_width));
+            if (out[r].instrument >= dictionary.size()) {
+                throw std::runtime_error("Corrupted order_log archive: bad instrument code");
+            }
+        }
+
+        detail::BitReader kinds(column, std::min(end, column + block_header.column_bytes[2]));
+        column += block_header.column_bytes[2];
+        for (uint32_t r = 0; r < count; ++r) {
+            auto bits = static_cast<uint32_t>(kinds.read(4));
+            out[r].type = static_cast<int32_t>(bits & 7);
+            out[r].direction = (bits & 8) ? 1 : -1;
+        }
+
+        detail::BitReader volumes(column, std::min(end, column + block_header.column_bytes[3]));
+        column += block_header.column_bytes[3];
+        for (uint32_t r = 0; r < count; ++r) {
+            out[r].volume = static_cast<int32_t>(
+                block_header.volume_min +
+                static_cast<int64_t>(volumes.read(block_header.volume_width) *
+                                     block_header.volume_gcd));
+        }
+
+        detail::BitReader ticks(column, std::min(end, column + block_header.column_bytes[4]));
+        for (uint32_t r = 0; r < count; ++r) {
+            out[r].price_off_ticks = static_cast<int32_t>(
+                block_header.tick_min + static_cast<int64_t>(ticks.read(block_header.tick_width)));
+        }
+    }
+
+   private:
+    struct InstrumentId {
+        char id[9];
+    };
+
+    RecordFile<uint8_t> file;
+    ArchiveHeader header;
+    std::vector<InstrumentId> dictionary;
+    std::vector<ArchiveBlockIndex> index;
+};
+
+/**
+ * A queue of order_events over an archive, decoding one block at a time.
+ * It has the same interface as VectorQueue plus `instrumentId(code)`. The
+ * reference returned by `front()` stays valid until the next call to
+ * `empty()` or `front()` after `pop()`.
+ */
+class ArchiveQueue {
+   public:
+    explicit ArchiveQueue(const std::string& filePath) : archive(filePath) {}
+
+    bool empty() {
+        if (pos < events.size()) return false;
+        while (next_block < archive.blockCount()) {
+            events.resize(archive.block(next_block).count);
+            archive.decodeBlock(next_block++, events.data());
+            pos = 0;
+            if (!events.empty()) return false;
+        }
+        return true;
+    }
+
+    const order_event& front() {
+        if (empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return events[pos];
+    }
+
+    void pop() {
+        if (pos >= events.size()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        ++pos;
+    }
+
+    // 归档中的总记录数
+    size_t size() const { return archive.size(); }
+
+    // 从头重新解码
+    void reset() {
+        events.clear();
+        pos = 0;
+        next_block = 0;
+    }
+
+    const char* instrumentId(uint32_t code) const { return archive.instrumentId(code); }
+
+    const OrderArchive& source() const { return archive; }
+
+   private:
+    OrderArchive archive;
+    std::vector<order_event> events;
+    size_t pos = 0;
+    size_t next_block = 0;
+};
+
+/**
+ * Converts a binary order_log file into an archive.
+ *
+ * @return the size of the archive in bytes.
+ */
+inline uint64_t convertOrderLog(const std::string& orderLogPath, const std::string& archivePath,
+                                uint32_t block_records = 1 << 16) {
+    RecordFile<order_log> rows(orderLogPath);
+    OrderArchiveWriter writer(archivePath, block_records);
+    for (const auto& row : rows) writer.append(row);
+    writer.close();
+    return writer.bytes();
+}
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_ARCHIVE_H
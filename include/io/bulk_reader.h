@@ -0,0 +1,381 @@
+#ifndef UBI_TRADER_IO_BULK_READER_H
+#define UBI_TRADER_IO_BULK_READER_H
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace UBIEngine::IO {
+/* Options of `readFiles`. */
+struct BulkReadOptions {
+    // Open the files with O_DIRECT to bypass the page cache. Falls back to buffered
+    // reads for a file whose filesystem refuses O_DIRECT.
+    bool direct = false;
+    // Use io_uring. Falls back to pread if the kernel does not provide it.
+    bool use_uring = true;
+    // The size of each read request, a multiple of kBulkAlignment.
+    size_t block_size = 1 << 20;
+    // The maximum number of reads in flight.
+    unsigned queue_depth = 32;
+};
+
+/* What `readFiles` achieved. */
+struct BulkReadStats {
+    size_t bytes = 0;
+    double seconds = 0;
+    bool used_uring = false;
+    bool used_direct = false;  // True if at least one file was read with O_DIRECT.
+
+    double gbps() const { return seconds > 0 ? bytes / seconds / 1e9 : 0; }
+};
+
+// The alignment of buffers, offsets and lengths, large enough for O_DIRECT on any device.
+inline constexpr size_t kBulkAlignment = 4096;
+
+/**
+ * An owning, kBulkAlignment aligned byte buffer. `capacity()` is rounded up
+ * to the alignment so O_DIRECT may read a whole last block into it.
+ */
+class AlignedBuffer {
+   public:
+    AlignedBuffer() = default;
+
+    explicit AlignedBuffer(size_t size) : length(size) {
+        size_t capacity = (size + kBulkAlignment - 1) / kBulkAlignment * kBulkAlignment;
+        if (capacity == 0) return;
+        void* ptr = std::aligned_alloc(kBulkAlignment, capacity);
+        if (ptr == nullptr) throw std::bad_alloc();
+        bytes.reset(static_cast<char*>(ptr));
+        allocated = capacity;
+    }
+
+    char* data() { return bytes.get(); }
+    const char* data() const { return bytes.get(); }
+    size_t size() const { return length; }
+    size_t capacity() const { return allocated; }
+
+   private:
+    struct FreeDeleter {
+        void operator()(char* ptr) const { std::free(ptr); }
+    };
+
+    std::unique_ptr<char, FreeDeleter> bytes;
+    size_t length = 0;
+    size_t allocated = 0;
+};
+
+/**
+ * A span-like view of packed records that owns the buffer they were read
+ * into. Like RecordFile, it can be fed to `VectorQueue<T, RecordBuffer<T>>`.
+ */
+template <typename T>
+class RecordBuffer {
+   public:
+    using value_type = T;
+    using const_iterator = const T*;
+
+    explicit RecordBuffer(AlignedBuffer&& buffer_)
+        : buffer(std::move(buffer_)), count(buffer.size() / sizeof(T)) {}
+
+    const T* data() const { return reinterpret_cast<const T*>(buffer.data()); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t index) const { return data()[index]; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + count; }
+
+   private:
+    AlignedBuffer buffer;
+    size_t count;
+};
+
+namespace detail {
+struct BulkFile {
+    int fd = -1;
+    bool direct = false;
+    size_t size = 0;
+    AlignedBuffer* buffer = nullptr;
+};
+
+/* One read request: [offset, offset + length) of a file into its buffer. */
+struct BulkRequest {
+    BulkFile* file;
+    size_t offset;
+    size_t length;
+};
+
+/* Splits every file into block_size requests. */
+inline std::deque<BulkRequest> splitRequests(std::vector<BulkFile>& files, size_t block_size) {
+    std::deque<BulkRequest> requests;
+    for (auto& file : files) {
+        for (size_t offset = 0; offset < file.size; offset += block_size) {
+            size_t length = std::min(block_size, file.size - offset);
+            // O_DIRECT lengths must be aligned, the kernel stops at the end of the file.
+            if (file.direct) {
+                length = (length + kBulkAlignment - 1) / kBulkAlignment * kBulkAlignment;
+            }
+            requests.push_back({&file, offset, length});
+        }
+    }
+    return requests;
+}
+
+/**
+ * Accounts for `n` bytes read by a request. Returns false if the request is
+ * complete, otherwise moves it past the bytes that were read.
+ */
+inline bool advanceRequest(BulkRequest& request, ssize_t n) {
+    if (n < 0) throw std::runtime_error(std::string("Error reading file: ") + strerror(-n));
+    size_t end = std::min(request.offset + request.length, request.file->size);
+    if (request.offset + n >= end) return false;
+    if (n == 0) throw std::runtime_error("Error reading file: unexpected end of file");
+    size_t offset = request.offset + n;
+    // A short O_DIRECT read must be resumed from an aligned offset.
+    if (request.file->direct) offset = offset / kBulkAlignment * kBulkAlignment;
+    request.length -= offset - request.offset;
+    request.offset = offset;
+    return true;
+}
+
+inline void preadAll(std::deque<BulkRequest>& requests) {
+    while (!requests.empty()) {
+        BulkRequest request = requests.front();
+        requests.pop_front();
+        do {
+            ssize_t n = pread(request.file->fd, request.file->buffer->data() + request.offset,
+                              request.length, request.offset);
+            if (n == -1 && errno == EINTR) continue;
+            if (!advanceRequest(request, n == -1 ? -errno : n)) break;
+        } while (true);
+    }
+}
+
+/**
+ * A minimal io_uring built on the raw system calls (liburing is not a
+ * dependency). readAll() issues IORING_OP_READ, other users pass their own
+ * requests to submitAll().
+ */
+class Uring {
+   public:
+    /* Returns false if the kernel does not provide io_uring. */
+    bool init(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd < 0) return false;
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED) return fail();
+        if (single_mmap) {
+            cq_ring = sq_ring;
+        } else {
+            cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) return fail();
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                                               MAP_SHARED | MAP_POPULATE, ring_fd,
+                                               IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return fail();
+
+        char* sq = static_cast<char*>(sq_ring);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cq_ring);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        capacity = params.sq_entries;
+        return true;
+    }
+
+    ~Uring() { release(); }
+
+    /* Reads every request, keeping up to `capacity` of them in flight. */
+    void readAll(std::deque<BulkRequest>& pending) {
+        submitAll(pending, [](const BulkRequest& request, io_uring_sqe& sqe) {
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = request.file->fd;
+            sqe.addr = reinterpret_cast<uint64_t>(request.file->buffer->data() + request.offset);
+            sqe.len = static_cast<uint32_t>(request.length);
+            sqe.off = request.offset;
+        });
+    }
+
+    /**
+     * Runs every request, keeping up to `capacity` of them in flight.
+     * `prepare(request, sqe)` fills a zeroed sqe; `advanceRequest(request, res)`
+     * returns true if the request must be resubmitted for what remains.
+     */
+    template <typename Request, typename Prepare>
+    void submitAll(std::deque<Request>& pending, Prepare prepare) {
+        std::vector<Request> slots(capacity);
+        std::vector<unsigned> free_slots;
+        for (unsigned i = 0; i < capacity; ++i) free_slots.push_back(i);
+        unsigned in_flight = 0;
+        unsigned to_submit = 0;  // Prepared but not yet consumed by the kernel.
+
+        while (!pending.empty() || in_flight > 0 || to_submit > 0) {
+            while (!pending.empty() && !free_slots.empty()) {
+                unsigned slot = free_slots.back();
+                free_slots.pop_back();
+                slots[slot] = pending.front();
+                pending.pop_front();
+                pushSqe(slot, [&](io_uring_sqe& sqe) { prepare(slots[slot], sqe); });
+                ++to_submit;
+            }
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, 1,
+                                               IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("io_uring_enter: ") + strerror(errno));
+            }
+            to_submit -= ret;
+            in_flight += ret;
+
+            unsigned head = *cq_head;
+            unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes[head & cq_mask];
+                auto slot = static_cast<unsigned>(cqe.user_data);
+                --in_flight;
+                // Interrupted and short transfers are resubmitted for the remaining bytes.
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN ||
+                    advanceRequest(slots[slot], cqe.res)) {
+                    pending.push_front(slots[slot]);
+                }
+                free_slots.push_back(slot);
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+    }
+
+   private:
+    template <typename Fill>
+    void pushSqe(unsigned slot, Fill fill) {
+        unsigned tail = *sq_tail;
+        unsigned index = tail & sq_mask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        fill(sqe);
+        sqe.user_data = slot;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    bool fail() {
+        release();
+        return false;
+    }
+
+    void release() {
+        if (sqes != nullptr && sqes != MAP_FAILED) munmap(sqes, sqes_size);
+        if (cq_ring != nullptr && cq_ring != MAP_FAILED && cq_ring != sq_ring)
+            munmap(cq_ring, cq_ring_size);
+        if (sq_ring != nullptr && sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+        if (ring_fd >= 0) close(ring_fd);
+        sqes = nullptr;
+        sq_ring = cq_ring = nullptr;
+        ring_fd = -1;
+    }
+
+    int ring_fd = -1;
+    unsigned capacity = 0;
+    void* sq_ring = nullptr;
+    void* cq_ring = nullptr;
+    size_t sq_ring_size = 0, cq_ring_size = 0, sqes_size = 0;
+    unsigned *sq_tail = nullptr, *sq_array = nullptr, sq_mask = 0;
+    unsigned *cq_head = nullptr, *cq_tail = nullptr, cq_mask = 0;
+    io_uring_sqe* sqes = nullptr;
+    io_uring_cqe* cqes = nullptr;
+};
+}  // namespace detail
+
+/**
+ * Reads whole files into aligned buffers. The reads of all files are split
+ * into `block_size` requests and submitted together, with up to
+ * `queue_depth` in flight on one io_uring, so a date's files are loaded at
+ * device bandwidth by a single thread. Without io_uring the same requests
+ * are served with pread.
+ *
+ * @param filePaths the files to read.
+ * @param stats if not null, receives the bytes read, the time and the path taken.
+ * @return one buffer per file, in the order of `filePaths`.
+ */
+inline std::vector<AlignedBuffer> readFiles(const std::vector<std::string>& filePaths,
+                                            const BulkReadOptions& options = BulkReadOptions(),
+                                            BulkReadStats* stats = nullptr) {
+    if (options.block_size == 0 || options.block_size % kBulkAlignment != 0) {
+        throw std::invalid_argument("block_size must be a positive multiple of 4096");
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<AlignedBuffer> buffers(filePaths.size());
+    std::vector<detail::BulkFile> files(filePaths.size());
+    struct FdCloser {
+        std::vector<detail::BulkFile>& files;
+        ~FdCloser() {
+            for (auto& file : files)
+                if (file.fd != -1) close(file.fd);
+        }
+    } closer{files};
+
+    BulkReadStats result;
+    for (size_t i = 0; i < filePaths.size(); ++i) {
+        auto& file = files[i];
+        if (options.direct) {
+            file.fd = open(filePaths[i].c_str(), O_RDONLY | O_DIRECT);
+            file.direct = file.fd != -1;
+        }
+        if (file.fd == -1) file.fd = open(filePaths[i].c_str(), O_RDONLY);
+        if (file.fd == -1) {
+            throw std::runtime_error("Error opening file for reading: " + filePaths[i]);
+        }
+        struct stat sb;
+        if (fstat(file.fd, &sb) == -1) {
+            throw std::runtime_error("Error getting file status: " + filePaths[i]);
+        }
+        file.size = sb.st_size;
+        buffers[i] = AlignedBuffer(file.size);
+        file.buffer = &buffers[i];
+        result.bytes += file.size;
+        result.used_direct |= file.direct;
+    }
+
+    auto requests = detail::splitRequests(files, options.block_size);
+    detail::Uring uring;
+    if (options.use_uring && uring.init(std::max(1u, options.queue_depth))) {
+        result.used_uring = true;
+        uring.readAll(requests);
+    } else {
+        detail::preadAll(requests);
+    }
+
+    result.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats != nullptr) *stats = result;
+    return buffers;
+}
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_BULK_READER_H
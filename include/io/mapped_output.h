@@ -0,0 +1,146 @@
+#ifndef UBI_TRADER_IO_MAPPED_OUTPUT_H
+#define UBI_TRADER_IO_MAPPED_OUTPUT_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "io/result_writer.h"
+
+namespace UBIEngine::IO {
+/**
+ * An output file that is filled in place through a shared mapping, with the
+ * part of the `std::vector` interface the replay uses (`reserve`,
+ * `push_back`, `insert`, `back`, ...). The file is preallocated with
+ * fallocate() to the reserved capacity, records are written straight into
+ * the page cache, and `close()` truncates it to the records written. No
+ * in-memory copy of the output exists besides the mapping.
+ *
+ * Growing past the capacity extends the file and remaps it, so pointers and
+ * iterators are invalidated like those of a vector.
+ */
+template <typename T>
+class MappedRecords {
+   public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    /**
+     * Creates (or truncates) the file. If it cannot be preallocated or mapped,
+     * the file is removed again and the constructor throws.
+     *
+     * @param path_ the output file.
+     * @param fsync_ how `close()` flushes the file to the device.
+     * @param initial_capacity the records the file is preallocated for.
+     */
+    explicit MappedRecords(const std::string& path_, FsyncPolicy fsync_ = FsyncPolicy::None,
+                           size_t initial_capacity = 1024)
+        : path(path_), fsync(fsync_) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) throw std::runtime_error("Error opening file for writing: " + path);
+        try {
+            grow(std::max<size_t>(1, initial_capacity));
+        } catch (...) {
+            // The destructor does not run, nothing of the file is worth keeping.
+            ::close(fd);
+            unlink(path.c_str());
+            throw;
+        }
+    }
+
+    MappedRecords(const MappedRecords&) = delete;
+    MappedRecords& operator=(const MappedRecords&) = delete;
+
+    /* Closes the file if `close()` was not called, errors only go to stderr. */
+    ~MappedRecords() {
+        try {
+            close();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return allocated; }
+
+    T* data() { return records; }
+    const T* data() const { return records; }
+    iterator begin() { return records; }
+    iterator end() { return records + count; }
+    const_iterator begin() const { return records; }
+    const_iterator end() const { return records + count; }
+    T& operator[](size_t index) { return records[index]; }
+    const T& operator[](size_t index) const { return records[index]; }
+    T& back() { return records[count - 1]; }
+    const T& back() const { return records[count - 1]; }
+
+    /* Preallocates the file for `n` records. */
+    void reserve(size_t n) {
+        if (n > allocated) grow(n);
+    }
+
+    void push_back(const T& value) {
+        if (count == allocated) grow(allocated * 2);
+        records[count++] = value;
+    }
+
+    void emplace_back(const T& value) { push_back(value); }
+
+    iterator insert(const_iterator pos, const T& value) {
+        size_t index = pos - records;
+        if (count == allocated) grow(allocated * 2);
+        std::memmove(records + index + 1, records + index, (count - index) * sizeof(T));
+        records[index] = value;
+        ++count;
+        return records + index;
+    }
+
+    /* Unmaps the file, truncates it to the records written and syncs it per the policy. */
+    void close() {
+        if (fd == -1) return;
+        munmap(records, allocated * sizeof(T));
+        records = nullptr;
+        allocated = 0;
+        int file = fd;
+        fd = -1;
+        bool ok = ftruncate(file, count * sizeof(T)) == 0;
+        if (ok && fsync == FsyncPolicy::Data) ok = fdatasync(file) == 0;
+        if (ok && fsync == FsyncPolicy::Full) ok = ::fsync(file) == 0;
+        ::close(file);
+        if (!ok) throw std::runtime_error("Error finishing file: " + path);
+    }
+
+   private:
+    void grow(size_t n) {
+        size_t bytes = n * sizeof(T);
+        // Reserve the blocks up front; fall back to a sparse file where fallocate is unsupported.
+        int ret = fallocate(fd, 0, 0, bytes);
+        if (ret != 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) ret = ftruncate(fd, bytes);
+        if (ret != 0) {
+            throw std::runtime_error("Error allocating file: " + path + ": " + strerror(errno));
+        }
+        void* mapping =
+            records == nullptr
+                ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                : mremap(records, allocated * sizeof(T), bytes, MREMAP_MAYMOVE);
+        if (mapping == MAP_FAILED) throw std::runtime_error("Error mapping file: " + path);
+        records = static_cast<T*>(mapping);
+        allocated = n;
+    }
+
+    std::string path;
+    FsyncPolicy fsync;
+    int fd = -1;
+    T* records = nullptr;
+    size_t count = 0;
+    size_t allocated = 0;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_MAPPED_OUTPUT_H
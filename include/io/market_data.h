@@ -0,0 +1,392 @@
+#ifndef UBI_TRADER_IO_MARKET_DATA_H
+#define UBI_TRADER_IO_MARKET_DATA_H
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "io/protocol.h"
+
+namespace UBIEngine::IO {
+/**
+ * The market-data protocol of MarketDataPublisher.
+ *
+ * Book changes go out over UDP as packets: a MarketDataPacketHeader with the
+ * sequence number of its first message, followed by `count` messages that
+ * are numbered consecutively. A packet without messages is a heartbeat that
+ * announces the next sequence number. Level updates carry the new total
+ * volume of a price level (0 removes it), so applying them is idempotent.
+ * Snapshots of the top levels of every symbol are sent periodically in the
+ * same stream; a receiver that misses a sequence number asks the recovery
+ * TCP port for full snapshots, which carry the last sequence they reflect.
+ * All fields are in host byte order.
+ */
+enum class MarketDataType : uint16_t {
+    Level = 1,
+    Trade = 2,
+    Snapshot = 3,
+    SnapshotRequest = 4,
+};
+
+struct MarketDataPacketHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint64_t sequence;
+} __attribute__((packed));
+
+struct MarketDataMessageHeader {
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t length;  // Of the whole message, including the snapshot levels.
+} __attribute__((packed));
+
+constexpr uint32_t kMarketDataMagic = 0x55424d44;  // "DMBU" on the wire.
+constexpr uint16_t kMarketDataVersion = 1;
+constexpr uint32_t kAllSymbols = UINT32_MAX;
+
+enum class BookSide : uint8_t { Bid = 0, Ask = 1 };
+
+struct LevelUpdateMessage {
+    MarketDataMessageHeader header;
+    uint32_t symbol_id;
+    uint8_t side;  // BookSide.
+    uint8_t reserved[3];
+    uint64_t price;
+    uint64_t volume;
+} __attribute__((packed));
+
+struct TradeMessage {
+    MarketDataMessageHeader header;
+    uint32_t symbol_id;
+    uint32_t reserved;
+    uint64_t price;
+    uint64_t quantity;
+} __attribute__((packed));
+
+/**
+ * Followed by `bid_count` bids, best first, then `ask_count` asks, best
+ * first. A truncated side only has the best levels of the book, the levels
+ * behind the worst one sent are left as they are.
+ */
+struct SnapshotMessage {
+    MarketDataMessageHeader header;
+    uint32_t symbol_id;
+    char instrument_id[8];
+    uint32_t bid_count;
+    uint32_t ask_count;
+    uint32_t flags;  // kSnapshotBidsTruncated | kSnapshotAsksTruncated.
+    uint32_t reserved;
+    uint64_t last_sequence;  // The last message the snapshot reflects.
+    uint64_t last_price;
+} __attribute__((packed));
+
+constexpr uint32_t kSnapshotBidsTruncated = 1;
+constexpr uint32_t kSnapshotAsksTruncated = 2;
+
+struct SnapshotLevel {
+    uint64_t price;
+    uint64_t volume;
+} __attribute__((packed));
+
+/* Sent to the recovery port, answered with the snapshots and end of file. */
+struct SnapshotRequestMessage {
+    MarketDataMessageHeader header;
+    uint32_t symbol_id;  // kAllSymbols for every symbol.
+    uint32_t reserved;
+} __attribute__((packed));
+
+template <typename Message>
+inline MarketDataMessageHeader marketDataHeader(MarketDataType type,
+                                                uint32_t length = sizeof(Message)) {
+    return {static_cast<uint16_t>(type), 0, length};
+}
+
+/* The price levels of one symbol as seen by a MarketDataFeed. */
+struct L2Book {
+    std::map<uint64_t, uint64_t, std::greater<uint64_t>> bids;  // Best (highest) first.
+    std::map<uint64_t, uint64_t> asks;                          // Best (lowest) first.
+    uint64_t last_price = 0;
+
+    void set(BookSide side, uint64_t price, uint64_t volume) {
+        if (side == BookSide::Bid) {
+            setLevel(bids, price, volume);
+        } else {
+            setLevel(asks, price, volume);
+        }
+    }
+
+   private:
+    template <typename Levels>
+    static void setLevel(Levels& levels, uint64_t price, uint64_t volume) {
+        if (volume == 0) {
+            levels.erase(price);
+        } else {
+            levels[price] = volume;
+        }
+    }
+};
+
+/* Options of MarketDataFeed. */
+struct FeedOptions {
+    // The UDP port to receive on, 0 picks a free one (see `MarketDataFeed::port()`).
+    uint16_t port = 0;
+    // A multicast group to join, empty to receive unicast packets.
+    std::string group;
+    // The recovery port of the publisher.
+    std::string recovery_host = "127.0.0.1";
+    uint16_t recovery_port = 0;
+};
+
+/**
+ * Keeps L2 books of the market-data stream of a MarketDataPublisher. It
+ * recovers from the TCP port when it starts in the middle of the stream or
+ * misses a packet, so the books always match the publisher's as of
+ * `nextSequence() - 1`. Single-threaded: call `poll()` in a loop.
+ */
+class MarketDataFeed {
+   public:
+    using TradeHandler = std::function<void(const TradeMessage&)>;
+
+    explicit MarketDataFeed(const FeedOptions& options_) : options(options_) {
+        fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) throw std::runtime_error("创建 socket 失败！");
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options.port);
+        addr.sin_addr.s_addr = INADDR_ANY;
+        socklen_t len = sizeof(addr);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+            getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1) {
+            close(fd);
+            throw std::runtime_error("Bind failed!");
+        }
+        bound_port = ntohs(addr.sin_port);
+        if (!options.group.empty()) {
+            ip_mreq membership{};
+            if (inet_pton(AF_INET, options.group.c_str(), &membership.imr_multiaddr) != 1 ||
+                setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership,
+                           sizeof(membership)) == -1) {
+                close(fd);
+                throw std::runtime_error("Cannot join multicast group " + options.group);
+            }
+        }
+    }
+
+    MarketDataFeed(const MarketDataFeed&) = delete;
+    MarketDataFeed& operator=(const MarketDataFeed&) = delete;
+
+    ~MarketDataFeed() { close(fd); }
+
+    uint16_t port() const { return bound_port; }
+
+    /* Where to recover from, when the publisher is created after the feed. */
+    void setRecoveryServer(const std::string& host, uint16_t port) {
+        options.recovery_host = host;
+        options.recovery_port = port;
+    }
+
+    /* Called with every trade applied in sequence (not with the ones a recovery skips). */
+    void onTrade(TradeHandler handler) { trade_handler = std::move(handler); }
+
+    /**
+     * Handles the next packet, waiting up to `timeout_ms` (-1 forever).
+     * Returns false on timeout.
+     */
+    bool poll(int timeout_ms) {
+        pollfd pfd{fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, timeout_ms);
+        if (ready == -1 && errno != EINTR)
+            throw std::runtime_error(std::string("poll failed: ") + strerror(errno));
+        if (ready <= 0) return false;
+        ssize_t n = recv(fd, packet, sizeof(packet), 0);
+        if (n == -1) {
+            if (errno == EINTR || errno == EAGAIN) return false;
+            throw std::runtime_error(std::string("Error receiving market data: ") +
+                                     strerror(errno));
+        }
+        handlePacket(static_cast<size_t>(n));
+        return true;
+    }
+
+    /* The book of `symbol_id`, nullptr if the feed has not seen the symbol. */
+    const L2Book* book(uint32_t symbol_id) const {
+        auto it = books.find(symbol_id);
+        return it == books.end() ? nullptr : &it->second;
+    }
+
+    /* The sequence number of the next message to apply, 0 before the first recovery. */
+    uint64_t nextSequence() const { return next_sequence; }
+    /* Missed sequence numbers detected, each followed by a recovery. */
+    uint64_t gaps() const { return gap_count; }
+    uint64_t recoveries() const { return recovery_count; }
+    uint64_t malformed() const { return malformed_count; }
+
+    /**
+     * Replaces every book with snapshots from the recovery port and continues
+     * after the last sequence they reflect.
+     */
+    void recover() {
+        int tcp = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (tcp == -1) throw std::runtime_error("创建 socket 失败！");
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options.recovery_port);
+        inet_pton(AF_INET, options.recovery_host.c_str(), &addr.sin_addr);
+        try {
+            if (connect(tcp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1)
+                throw std::runtime_error(std::string("Recovery connect failed: ") +
+                                         strerror(errno));
+            SnapshotRequestMessage request{
+                marketDataHeader<SnapshotRequestMessage>(MarketDataType::SnapshotRequest),
+                kAllSymbols, 0};
+            if (send(tcp, &request, sizeof(request), MSG_NOSIGNAL) != ssize_t(sizeof(request)))
+                throw std::runtime_error("Error sending snapshot request");
+            books.clear();
+            uint64_t last_sequence = 0;
+            SnapshotMessage snapshot;
+            std::vector<SnapshotLevel> levels;
+            while (readFully(tcp, {{&snapshot, sizeof(snapshot)}})) {
+                if (snapshot.header.type != uint16_t(MarketDataType::Snapshot))
+                    throw std::runtime_error("Bad recovery message");
+                levels.resize(snapshot.bid_count + snapshot.ask_count);
+                if (!readFully(tcp, {{levels.data(), levels.size() * sizeof(SnapshotLevel)}}) &&
+                    !levels.empty()) {
+                    throw std::runtime_error("Connection closed in the middle of a snapshot");
+                }
+                applySnapshot(snapshot, levels.data());
+                last_sequence = snapshot.last_sequence;
+            }
+            next_sequence = last_sequence + 1;
+        } catch (...) {
+            close(tcp);
+            throw;
+        }
+        close(tcp);
+        ++recovery_count;
+    }
+
+   private:
+    void handlePacket(size_t size) {
+        MarketDataPacketHeader header;
+        if (size < sizeof(header)) {
+            ++malformed_count;
+            return;
+        }
+        std::memcpy(&header, packet, sizeof(header));
+        if (header.magic != kMarketDataMagic || header.version != kMarketDataVersion) {
+            ++malformed_count;
+            return;
+        }
+        if (next_sequence == 0) {
+            recover();  // Joined in the middle of the stream.
+        } else if (header.sequence > next_sequence) {
+            ++gap_count;
+            recover();
+        }
+        size_t offset = sizeof(header);
+        for (uint16_t i = 0; i < header.count; ++i) {
+            MarketDataMessageHeader message;
+            if (size - offset < sizeof(message)) break;
+            std::memcpy(&message, packet + offset, sizeof(message));
+            if (message.length < sizeof(message) || message.length > size - offset) break;
+            uint64_t sequence = header.sequence + i;
+            if (sequence == next_sequence) {
+                apply(packet + offset, message);
+                ++next_sequence;
+            } else if (sequence > next_sequence) {
+                // Still missing messages the recovery did not cover.
+                ++gap_count;
+                recover();
+                if (sequence == next_sequence) {
+                    apply(packet + offset, message);
+                    ++next_sequence;
+                }
+            }
+            offset += message.length;
+        }
+    }
+
+    void apply(const char* data, const MarketDataMessageHeader& header) {
+        switch (static_cast<MarketDataType>(header.type)) {
+            case MarketDataType::Level: {
+                LevelUpdateMessage update;
+                std::memcpy(&update, data, sizeof(update));
+                books[update.symbol_id].set(static_cast<BookSide>(update.side), update.price,
+                                            update.volume);
+                break;
+            }
+            case MarketDataType::Trade: {
+                TradeMessage trade;
+                std::memcpy(&trade, data, sizeof(trade));
+                books[trade.symbol_id].last_price = trade.price;
+                if (trade_handler) trade_handler(trade);
+                break;
+            }
+            case MarketDataType::Snapshot: {
+                SnapshotMessage snapshot;
+                std::memcpy(&snapshot, data, sizeof(snapshot));
+                size_t count = snapshot.bid_count + snapshot.ask_count;
+                if (header.length != sizeof(snapshot) + count * sizeof(SnapshotLevel)) {
+                    ++malformed_count;
+                    break;
+                }
+                std::vector<SnapshotLevel> levels(count);
+                std::memcpy(levels.data(), data + sizeof(snapshot), count * sizeof(SnapshotLevel));
+                applySnapshot(snapshot, levels.data());
+                break;
+            }
+            default:
+                ++malformed_count;
+        }
+    }
+
+    void applySnapshot(const SnapshotMessage& snapshot, const SnapshotLevel* levels) {
+        L2Book& book = books[snapshot.symbol_id];
+        if ((snapshot.flags & kSnapshotBidsTruncated) && snapshot.bid_count != 0) {
+            book.bids.erase(book.bids.begin(),
+                            book.bids.upper_bound(levels[snapshot.bid_count - 1].price));
+        } else {
+            book.bids.clear();
+        }
+        if ((snapshot.flags & kSnapshotAsksTruncated) && snapshot.ask_count != 0) {
+            book.asks.erase(book.asks.begin(),
+                            book.asks.upper_bound(levels[snapshot.bid_count + snapshot.ask_count -
+                                                         1].price));
+        } else {
+            book.asks.clear();
+        }
+        for (uint32_t i = 0; i < snapshot.bid_count; ++i)
+            book.bids[levels[i].price] = levels[i].volume;
+        for (uint32_t i = 0; i < snapshot.ask_count; ++i)
+            book.asks[levels[snapshot.bid_count + i].price] =
+                levels[snapshot.bid_count + i].volume;
+        book.last_price = snapshot.last_price;
+    }
+
+    FeedOptions options;
+    int fd = -1;
+    uint16_t bound_port = 0;
+    char packet[65536];
+    std::unordered_map<uint32_t, L2Book> books;
+    uint64_t next_sequence = 0;
+    uint64_t gap_count = 0;
+    uint64_t recovery_count = 0;
+    uint64_t malformed_count = 0;
+    TradeHandler trade_handler;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_MARKET_DATA_H
@@ -0,0 +1,265 @@
+#ifndef UBI_TRADER_IO_ORDER_DECODER_H
+#define UBI_TRADER_IO_ORDER_DECODER_H
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "io/order_event.h"
+#include "io/type.h"
+#include "io/validate.h"
+#include "utils/robin_hood.h"
+
+namespace UBIEngine::IO {
+/**
+ * The per-order fields the replay derives from a batch of order_log rows,
+ * as structure of arrays.
+ */
+struct OrderColumns {
+    std::vector<int32_t> side;             // 1 for bid, -1 for ask (`direction == 1`).
+    std::vector<int32_t> type;             // The raw order type.
+    std::vector<int32_t> price_off_ticks;  // Rounded like priceOffTicks(), 0 unless LIMIT.
+    std::vector<int32_t> volume;
+
+    void resize(size_t count) {
+        side.resize(count);
+        type.resize(count);
+        price_off_ticks.resize(count);
+        volume.resize(count);
+    }
+};
+
+/* The reference decoder, one row at a time. */
+inline void decodeOrdersScalar(const order_log* rows, size_t count, OrderColumns& out,
+                               size_t offset = 0) {
+    for (size_t i = 0; i < count; ++i) {
+        const order_log& row = rows[i];
+        out.side[offset + i] = row.direction == 1 ? 1 : -1;
+        out.type[offset + i] = row.type;
+        out.price_off_ticks[offset + i] = priceOffTicks(row);
+        out.volume[offset + i] = row.volume;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * Decodes 8 rows per iteration with AVX2 gathers over the packed 36-byte rows.
+ * The rounding is the scalar one step by step (multiply, add or subtract 0.5
+ * by sign, truncate), so the result is bit-exact with priceOffTicks().
+ *
+ * Only call it if the CPU supports AVX2, see decodeOrders().
+ */
+__attribute__((target("avx2"))) inline void decodeOrdersAvx2(const order_log* rows, size_t count,
+                                                             OrderColumns& out) {
+    static_assert(sizeof(order_log) == 36, "order_log must be packed");
+    const __m256i row_offsets = _mm256_setr_epi32(0, 36, 72, 108, 144, 180, 216, 252);
+    const __m128i price_offsets = _mm_setr_epi32(0, 36, 72, 108);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256d hundred = _mm256_set1_pd(100);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d zero_pd = _mm256_setzero_pd();
+    // The masked gathers with a zero source, the unmasked ones trip -Wmaybe-uninitialized.
+    const __m256i all_rows = _mm256_set1_epi32(-1);
+    const __m256d all_prices = _mm256_castsi256_pd(all_rows);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const char* base = reinterpret_cast<const char*>(rows + i);
+        __m256i type = _mm256_mask_i32gather_epi32(
+            zero, reinterpret_cast<const int*>(base + 16), row_offsets, all_rows, 1);
+        __m256i direction = _mm256_mask_i32gather_epi32(
+            zero, reinterpret_cast<const int*>(base + 20), row_offsets, all_rows, 1);
+        __m256i volume = _mm256_mask_i32gather_epi32(
+            zero, reinterpret_cast<const int*>(base + 24), row_offsets, all_rows, 1);
+
+        __m128i ticks_lo, ticks_hi;
+        for (int h = 0; h < 2; ++h) {
+            __m256d price_off = _mm256_mask_i32gather_pd(
+                zero_pd, reinterpret_cast<const double*>(base + 28 + h * 144), price_offsets,
+                all_prices, 1);
+            __m256d price_off_100 = _mm256_mul_pd(price_off, hundred);
+            __m256d positive = _mm256_cmp_pd(price_off_100, zero_pd, _CMP_GT_OQ);
+            __m256d rounded = _mm256_blendv_pd(_mm256_sub_pd(price_off_100, half),
+                                               _mm256_add_pd(price_off_100, half), positive);
+            (h == 0 ? ticks_lo : ticks_hi) = _mm256_cvttpd_epi32(rounded);
+        }
+        __m256i ticks = _mm256_inserti128_si256(_mm256_castsi128_si256(ticks_lo), ticks_hi, 1);
+        // Only LIMIT orders (type 0) have a price offset.
+        ticks = _mm256_and_si256(ticks, _mm256_cmpeq_epi32(type, zero));
+        // (direction == 1 ? 2 : 0) - 1.
+        __m256i side = _mm256_sub_epi32(_mm256_and_si256(_mm256_cmpeq_epi32(direction, one), two),
+                                        one);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.side.data() + i), side);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.type.data() + i), type);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.price_off_ticks.data() + i), ticks);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.volume.data() + i), volume);
+    }
+    decodeOrdersScalar(rows + i, count - i, out, i);
+}
+#else
+/* No AVX2 off x86: hasAvx2Decoder() is false, and this is the scalar decoder. */
+inline void decodeOrdersAvx2(const order_log* rows, size_t count, OrderColumns& out) {
+    decodeOrdersScalar(rows, count, out);
+}
+#endif
+
+/* True if decodeOrders() uses the AVX2 kernel on this CPU. */
+inline bool hasAvx2Decoder() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Decodes a batch of rows into `out`, which is resized to `count`. Uses AVX2
+ * when the CPU has it, the scalar decoder otherwise.
+ */
+inline void decodeOrders(const order_log* rows, size_t count, OrderColumns& out) {
+    out.resize(count);
+    if (hasAvx2Decoder()) {
+        decodeOrdersAvx2(rows, count, out);
+    } else {
+        decodeOrdersScalar(rows, count, out);
+    }
+}
+
+/**
+ * A queue of order_events over order_log rows that are already in memory
+ * (`std::vector`, RecordFile or RecordBuffer). Rows are decoded a batch at a
+ * time with decodeOrders(), and instrument ids are dictionary coded on the
+ * way, so the replay does no per-row rounding or string hashing.
+ *
+ * Rows set in `rejects` (see validateOrders()) are dropped while a batch is
+ * built, so the replay never sees them.
+ *
+ * It has the same interface as VectorQueue plus `instrumentId(code)`. The
+ * reference returned by `front()` stays valid until the next call to
+ * `empty()` or `front()` after `pop()`.
+ */
+template <typename Rows>
+class DecodedOrderQueue {
+   public:
+    explicit DecodedOrderQueue(Rows&& rows_, size_t batch_records = 1024,
+                               RejectBitmap rejects_ = RejectBitmap())
+        : rows(std::move(rows_)), batch_size(batch_records), rejects(std::move(rejects_)) {
+        if (batch_size == 0) throw std::invalid_argument("batch_records must be positive");
+        if (rejects.size() != 0 && rejects.size() != rows.size())
+            throw std::invalid_argument("rejects must cover every row");
+        events.reserve(batch_size);
+    }
+
+    bool empty() {
+        // A batch can be empty if all of its rows are rejected.
+        while (pos >= events.size()) {
+            if (next_row >= rows.size()) return true;
+            decodeBatch();
+        }
+        return false;
+    }
+
+    const order_event& front() {
+        if (empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return events[pos];
+    }
+
+    void pop() {
+        if (pos >= events.size()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        ++pos;
+    }
+
+    // 总记录数，包括被拒绝的行
+    size_t size() const { return rows.size(); }
+
+    // 从头重新解码，字典保留
+    void reset() {
+        events.clear();
+        pos = 0;
+        next_row = 0;
+    }
+
+    const char* instrumentId(uint32_t code) const { return dictionary[code].id; }
+
+   private:
+    struct InstrumentId {
+        char id[9];
+    };
+
+    void decodeBatch() {
+        size_t count = std::min(batch_size, rows.size() - next_row);
+        const order_log* batch = rows.data() + next_row;
+        decodeOrders(batch, count, columns);
+        events.resize(count);
+        size_t kept = 0;
+        auto keep = [&](size_t i) {
+            order_event& event = events[kept++];
+            event.timestamp = batch[i].timestamp;
+            event.instrument = code(batch[i].instrument_id);
+            event.type = columns.type[i];
+            event.direction = columns.side[i];
+            event.volume = columns.volume[i];
+            event.price_off_ticks = columns.price_off_ticks[i];
+        };
+        // A word of the bitmap at a time: rejects are rare, most words are clean.
+        for (size_t i = 0; i < count;) {
+            size_t row = next_row + i;
+            size_t span = std::min<size_t>(count - i, 64 - (row & 63));
+            uint64_t word = rejects.size() != 0 ? rejects.word(row >> 6) >> (row & 63) : 0;
+            if (word == 0) {
+                for (size_t j = 0; j < span; ++j) keep(i + j);
+            } else {
+                for (size_t j = 0; j < span; ++j)
+                    if (!((word >> j) & 1)) keep(i + j);
+            }
+            i += span;
+        }
+        events.resize(kept);
+        next_row += count;
+        pos = 0;
+    }
+
+    uint32_t code(const char* instrument_id) {
+        uint64_t key = instrumentKey(instrument_id);
+        // Consecutive rows often share the instrument.
+        if (key == last_key && !dictionary.empty()) return last_code;
+        auto it = codes_of.find(key);
+        if (it == codes_of.end()) {
+            InstrumentId id{};
+            std::memcpy(id.id, &key, sizeof(key));
+            it = codes_of.emplace(key, static_cast<uint32_t>(dictionary.size())).first;
+            dictionary.push_back(id);
+        }
+        last_key = key;
+        last_code = it->second;
+        return last_code;
+    }
+
+    Rows rows;
+    size_t batch_size;
+    RejectBitmap rejects;  // Empty if nothing is rejected.
+    size_t next_row = 0;
+    OrderColumns columns;
+    std::vector<order_event> events;
+    size_t pos = 0;
+
+    robin_hood::unordered_map<uint64_t, uint32_t> codes_of;
+    std::vector<InstrumentId> dictionary;
+    uint64_t last_key = 0;
+    uint32_t last_code = 0;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_ORDER_DECODER_H
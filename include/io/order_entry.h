@@ -0,0 +1,214 @@
+#ifndef UBI_TRADER_IO_ORDER_ENTRY_H
+#define UBI_TRADER_IO_ORDER_ENTRY_H
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "io/type.h"
+
+namespace UBIEngine::IO {
+/**
+ * The order-entry protocol of OrderGateway. Every message starts with an
+ * OrderEntryHeader whose `length` is the size of the whole message; all
+ * fields are in host byte order, like the data files. A client sends
+ * NewOrder and CancelOrder, the gateway answers each with an Ack and, if
+ * accepted, an ExecutionReport.
+ */
+enum class OrderEntryType : uint16_t {
+    NewOrder = 1,
+    CancelOrder = 2,
+    Ack = 3,
+    ExecutionReport = 4,
+};
+
+struct OrderEntryHeader {
+    uint16_t type;
+    uint16_t length;
+} __attribute__((packed));
+
+/* A new order, `order` is interpreted exactly like an order_log record of the replay. */
+struct NewOrderMessage {
+    OrderEntryHeader header;
+    uint64_t client_order_id;
+    order_log order;
+} __attribute__((packed));
+
+/* Cancels the open quantity of an order of the gateway (see AckMessage::order_id). */
+struct CancelOrderMessage {
+    OrderEntryHeader header;
+    uint64_t client_order_id;
+    uint64_t order_id;
+    char instrument_id[8];
+} __attribute__((packed));
+
+/* Why a request is rejected. The first four mirror RejectReason of io/validate.h. */
+enum class OrderEntryReject : uint8_t {
+    None = 0,
+    UnknownType = 1,
+    BadDirection = 2,
+    NonPositiveVolume = 3,
+    UnknownSymbol = 4,
+    PriceOutOfRange = 5,  // A negative price_off below the base price.
+    UnknownOrder = 6,     // Cancel of an order that is not open.
+};
+
+struct AckMessage {
+    OrderEntryHeader header;
+    uint64_t client_order_id;
+    uint64_t order_id;  // Assigned by the gateway, 0 if rejected.
+    uint8_t accepted;
+    uint8_t reason;  // OrderEntryReject.
+    uint16_t reserved;
+} __attribute__((packed));
+
+enum class ExecutionStatus : uint8_t {
+    New = 0,              // Resting, nothing executed.
+    PartiallyFilled = 1,  // Resting, partly executed.
+    Filled = 2,
+    Expired = 3,          // A market order whose remainder was not kept.
+    Cancelled = 4,
+};
+
+/* The state of an order right after a request was matched. */
+struct ExecutionReportMessage {
+    OrderEntryHeader header;
+    uint64_t client_order_id;
+    uint64_t order_id;
+    uint8_t status;  // ExecutionStatus.
+    uint8_t reserved[3];
+    uint32_t executed_quantity;
+    uint32_t open_quantity;
+} __attribute__((packed));
+
+/* Any message, to read into before the type is known. */
+union OrderEntryMessage {
+    OrderEntryHeader header;
+    NewOrderMessage new_order;
+    CancelOrderMessage cancel;
+    AckMessage ack;
+    ExecutionReportMessage report;
+};
+
+/* The size of messages of `type`, 0 if the type is unknown. */
+inline uint16_t orderEntryLength(uint16_t type) {
+    switch (static_cast<OrderEntryType>(type)) {
+        case OrderEntryType::NewOrder: return sizeof(NewOrderMessage);
+        case OrderEntryType::CancelOrder: return sizeof(CancelOrderMessage);
+        case OrderEntryType::Ack: return sizeof(AckMessage);
+        case OrderEntryType::ExecutionReport: return sizeof(ExecutionReportMessage);
+        default: return 0;
+    }
+}
+
+inline OrderEntryHeader orderEntryHeader(OrderEntryType type) {
+    return {static_cast<uint16_t>(type), orderEntryLength(static_cast<uint16_t>(type))};
+}
+
+/**
+ * A blocking order-entry connection for strategy processes and tests.
+ * Nagle is disabled, every request goes out with one send().
+ */
+class OrderEntryClient {
+   public:
+    OrderEntryClient(const std::string& host, uint16_t port) {
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) throw std::runtime_error("创建 socket 失败！");
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            close(fd);
+            throw std::invalid_argument("Bad IPv4 address: " + host);
+        }
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+            close(fd);
+            throw std::runtime_error(std::string("Connect failed: ") + strerror(errno));
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    OrderEntryClient(const OrderEntryClient&) = delete;
+    OrderEntryClient& operator=(const OrderEntryClient&) = delete;
+
+    ~OrderEntryClient() { close(fd); }
+
+    void sendNewOrder(uint64_t client_order_id, const order_log& order) {
+        NewOrderMessage message{orderEntryHeader(OrderEntryType::NewOrder), client_order_id, order};
+        sendAll(&message, sizeof(message));
+    }
+
+    void sendCancel(uint64_t client_order_id, uint64_t order_id, const char* instrument_id) {
+        CancelOrderMessage message{orderEntryHeader(OrderEntryType::CancelOrder), client_order_id,
+                                   order_id, {}};
+        std::memcpy(message.instrument_id, instrument_id, strnlen(instrument_id, 8));
+        sendAll(&message, sizeof(message));
+    }
+
+    /**
+     * Reads the next message, buffered so an ack and its execution report
+     * usually arrive with one recv(). Returns false if the gateway closed the
+     * connection, throws on a message of unknown type.
+     */
+    bool receive(OrderEntryMessage& message) {
+        while (true) {
+            size_t available = end - begin;
+            if (available >= sizeof(OrderEntryHeader)) {
+                OrderEntryHeader header;
+                std::memcpy(&header, buffer + begin, sizeof(header));
+                uint16_t length = orderEntryLength(header.type);
+                if (length == 0 || header.length != length)
+                    throw std::runtime_error("Bad order-entry message");
+                if (available >= length) {
+                    std::memcpy(&message, buffer + begin, length);
+                    begin += length;
+                    return true;
+                }
+            }
+            std::memmove(buffer, buffer + begin, available);
+            begin = 0;
+            end = available;
+            ssize_t n = recv(fd, buffer + end, sizeof(buffer) - end, 0);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("Error receiving: ") + strerror(errno));
+            }
+            if (n == 0) {
+                if (available == 0) return false;
+                throw std::runtime_error("Connection closed in the middle of a message");
+            }
+            end += n;
+        }
+    }
+
+    int socket() const { return fd; }
+
+   private:
+    void sendAll(const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size != 0) {
+            ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("Error sending order: ") + strerror(errno));
+            }
+            p += n;
+            size -= n;
+        }
+    }
+
+    int fd = -1;
+    char buffer[4096];
+    size_t begin = 0, end = 0;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_ORDER_ENTRY_H
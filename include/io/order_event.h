@@ -0,0 +1,47 @@
+#ifndef UBI_TRADER_IO_ORDER_EVENT_H
+#define UBI_TRADER_IO_ORDER_EVENT_H
+#include <cstdint>
+#include <cstring>
+
+#include "io/type.h"
+
+namespace UBIEngine::IO {
+/**
+ * A decoded order_log row, in the form the replay consumes: the instrument is
+ * a code in the dictionary of the source queue (`instrumentId(code)`), and the
+ * price offset is already rounded to ticks (0.01).
+ */
+struct order_event {
+    long timestamp;
+    uint32_t instrument;
+    int32_t type;
+    int32_t direction;      // 1 for bid and -1 for ask.
+    int32_t volume;
+    int32_t price_off_ticks;  // 0 unless the order is a LIMIT order.
+};
+
+/**
+ * Rounds a price offset in yuan to ticks, half away from zero. This is the
+ * rounding of the replay loop, every decoder must match it bit for bit.
+ */
+inline int32_t priceOffToTicks(double price_off) {
+    double price_off_100 = price_off * 100;
+    if (price_off_100 > 0) return static_cast<int32_t>(price_off_100 + 0.5);
+    return static_cast<int32_t>(price_off_100 - 0.5);
+}
+
+/* The tick offset the replay applies to a raw row, only LIMIT orders have one. */
+inline int32_t priceOffTicks(const order_log& row) {
+    return row.type != 0 ? 0 : priceOffToTicks(row.price_off);
+}
+
+inline int32_t priceOffTicks(const order_event& event) { return event.price_off_ticks; }
+
+/* The dictionary key of an instrument id: its first 8 bytes up to the terminator. */
+inline uint64_t instrumentKey(const char* instrument_id) {
+    uint64_t key = 0;
+    std::memcpy(&key, instrument_id, strnlen(instrument_id, 8));
+    return key;
+}
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_ORDER_EVENT_H
@@ -0,0 +1,296 @@
+#ifndef UBI_TRADER_IO_PROTOCOL_H
+#define UBI_TRADER_IO_PROTOCOL_H
+#include <linux/errqueue.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "io/result_codec.h"
+#include "io/type.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+namespace UBIEngine::IO {
+/**
+ * The header of a result frame. A frame is the header followed by
+ * `pnl_count` pnl_and_pos and `twap_count` twap_order records, all in host
+ * byte order (the records are the raw output file formats).
+ *
+ * In frames of kEncodedResultFrameVersion the header is followed by a
+ * ResultFrameCodec, and the twap_order records are `twap_bytes` bytes of the
+ * wire codec of io/result_codec.h. Receivers that only know version 1 reject
+ * such frames instead of misreading them.
+ */
+struct ResultFrameHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_bytes;  // sizeof(ResultFrameHeader), to skip unknown extensions.
+    int32_t year;
+    int32_t month;
+    int32_t day;
+    uint32_t session_num;
+    uint32_t session_length;
+    uint64_t pnl_count;
+    uint64_t twap_count;
+} __attribute__((packed));
+
+constexpr uint32_t kResultFrameMagic = 0x55424952;  // "RIBU" on the wire.
+constexpr uint16_t kResultFrameVersion = 1;
+constexpr uint16_t kEncodedResultFrameVersion = 2;
+// Default limit of the record bytes of one frame, to reject corrupted or hostile headers
+// before allocating.
+constexpr uint64_t kDefaultMaxFrameBytes = uint64_t(1) << 30;
+
+/* The extension of the header of an encoded frame, counted in `header_bytes`. */
+struct ResultFrameCodec {
+    uint64_t twap_bytes;
+} __attribute__((packed));
+
+/**
+ * The header of the results of a session named like the output files,
+ * `YYYYMMDD_<session_num>_<session_length>`.
+ */
+inline ResultFrameHeader makeResultHeader(const std::string& session_name, uint64_t pnl_count,
+                                          uint64_t twap_count) {
+    ResultFrameHeader header{};
+    header.magic = kResultFrameMagic;
+    header.version = kResultFrameVersion;
+    header.header_bytes = sizeof(ResultFrameHeader);
+    if (std::sscanf(session_name.c_str(), "%4d%2d%2d_%u_%u", &header.year, &header.month,
+                    &header.day, &header.session_num, &header.session_length) != 5) {
+        throw std::invalid_argument("Bad session name: " + session_name);
+    }
+    header.pnl_count = pnl_count;
+    header.twap_count = twap_count;
+    return header;
+}
+
+/**
+ * Throws if `header` is not the header of a frame this version can read, or
+ * if its decoded records take more than `max_frame_bytes`.
+ */
+inline void checkResultHeader(const ResultFrameHeader& header,
+                              uint64_t max_frame_bytes = kDefaultMaxFrameBytes) {
+    size_t min_bytes = sizeof(header);
+    if (header.version == kEncodedResultFrameVersion) min_bytes += sizeof(ResultFrameCodec);
+    if (header.magic != kResultFrameMagic ||
+        (header.version != kResultFrameVersion && header.version != kEncodedResultFrameVersion) ||
+        header.header_bytes < min_bytes) {
+        throw std::runtime_error("Bad result frame header");
+    }
+    // Each count is bounded first, so the sum of the bytes can not overflow.
+    if (header.pnl_count > max_frame_bytes / sizeof(pnl_and_pos) ||
+        header.twap_count > max_frame_bytes / sizeof(twap_order) ||
+        header.pnl_count * sizeof(pnl_and_pos) + header.twap_count * sizeof(twap_order) >
+            max_frame_bytes)
+        throw std::runtime_error("Result frame too large");
+}
+
+/* Throws if the encoded records of a frame cannot be `header.twap_count` records. */
+inline void checkResultCodec(const ResultFrameHeader& header, const ResultFrameCodec& codec) {
+    if (codec.twap_bytes > header.twap_count * kMaxEncodedTwapBytes)
+        throw std::runtime_error("Bad result frame codec");
+}
+
+/* The inverse of makeResultHeader(). */
+inline std::string sessionName(const ResultFrameHeader& header) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%04d%02d%02d_%u_%u", header.year, header.month, header.day,
+                  header.session_num, header.session_length);
+    return name;
+}
+
+/* Options of sendResultFrame(). */
+struct FrameSendOptions {
+    // Send payloads of at least `zerocopy_threshold` bytes with MSG_ZEROCOPY. Falls back to
+    // copying sends if the socket does not support it.
+    bool zerocopy = false;
+    size_t zerocopy_threshold = 1 << 20;
+    // Encode the twap_order records with this encoder (see io/result_codec.h) when that makes
+    // the frame smaller. The receivers must know kEncodedResultFrameVersion.
+    TwapEncoder* encoder = nullptr;
+};
+
+namespace detail {
+/* Drops the first `n` bytes of `iov`, returns the first iovec that is left. */
+inline size_t advanceIovecs(std::vector<iovec>& iov, size_t first, size_t n) {
+    while (first < iov.size() && n >= iov[first].iov_len) n -= iov[first++].iov_len;
+    if (first < iov.size()) {
+        iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + n;
+        iov[first].iov_len -= n;
+    }
+    return first;
+}
+
+/**
+ * Waits for the completions of the last `sends` MSG_ZEROCOPY sends, after
+ * which the kernel no longer references the buffers. Earlier sends of the
+ * socket must have completed already.
+ */
+inline void awaitZerocopy(int fd, uint32_t sends) {
+    uint32_t completed = 0;  // Completions are reported as ranges [ee_info, ee_data] of sends.
+    while (completed < sends) {
+        pollfd pfd{fd, 0, 0};  // POLLERR is always reported.
+        if (poll(&pfd, 1, -1) == -1) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Error polling socket: ") + strerror(errno));
+        }
+        char control[128];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE) == -1) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            throw std::runtime_error(std::string("Error reading completions: ") + strerror(errno));
+        }
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            auto* error = reinterpret_cast<sock_extended_err*>(CMSG_DATA(cm));
+            if (error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+            completed += error->ee_data - error->ee_info + 1;
+        }
+    }
+}
+}  // namespace detail
+
+/**
+ * Sends one frame with scatter-gather writes straight from the vectors:
+ * one sendmsg() per call unless the socket buffer fills up. With zerocopy
+ * the function returns after the kernel released the buffers, so they can be
+ * reused right away. With an encoder the twap_order records are sent encoded,
+ * unless the encoding is not smaller.
+ */
+inline void sendResultFrame(int fd, const ResultFrameHeader& header,
+                            const std::vector<pnl_and_pos>& pnls,
+                            const std::vector<twap_order>& ans,
+                            const FrameSendOptions& options = FrameSendOptions()) {
+    if (header.pnl_count != pnls.size() || header.twap_count != ans.size())
+        throw std::invalid_argument("The frame header does not match the records");
+    std::vector<iovec> iov = {
+        {const_cast<ResultFrameHeader*>(&header), sizeof(header)},
+        {const_cast<pnl_and_pos*>(pnls.data()), pnls.size() * sizeof(pnl_and_pos)},
+        {const_cast<twap_order*>(ans.data()), ans.size() * sizeof(twap_order)},
+    };
+    ResultFrameHeader encoded_header;
+    ResultFrameCodec codec;
+    if (options.encoder != nullptr && !ans.empty()) {
+        const std::vector<uint8_t>& bytes = options.encoder->encode(ans);
+        if (bytes.size() < iov[2].iov_len) {
+            encoded_header = header;
+            encoded_header.version = kEncodedResultFrameVersion;
+            encoded_header.header_bytes = sizeof(header) + sizeof(codec);
+            codec.twap_bytes = bytes.size();
+            iov = {{&encoded_header, sizeof(header)},
+                   {&codec, sizeof(codec)},
+                   iov[1],
+                   {const_cast<uint8_t*>(bytes.data()), bytes.size()}};
+        }
+    }
+    size_t total = 0;
+    for (const iovec& part : iov) total += part.iov_len;
+
+    int flags = MSG_NOSIGNAL;
+    if (options.zerocopy && total >= options.zerocopy_threshold) {
+        int one = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0)
+            flags |= MSG_ZEROCOPY;
+    }
+    uint32_t zerocopy_sends = 0;
+    size_t first = 0;
+    while (first < iov.size()) {
+        msghdr msg{};
+        msg.msg_iov = iov.data() + first;
+        msg.msg_iovlen = iov.size() - first;
+        ssize_t n = sendmsg(fd, &msg, flags);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+                flags &= ~MSG_ZEROCOPY;  // Out of pinned memory, copy the rest.
+                continue;
+            }
+            throw std::runtime_error(std::string("Error sending frame: ") + strerror(errno));
+        }
+        if (flags & MSG_ZEROCOPY) ++zerocopy_sends;
+        first = detail::advanceIovecs(iov, first, n);
+    }
+    if (zerocopy_sends != 0) detail::awaitZerocopy(fd, zerocopy_sends);
+}
+
+/**
+ * Reads exactly `iov`'s bytes with readv(). Returns false on end of file
+ * before the first byte, throws on end of file in the middle.
+ */
+inline bool readFully(int fd, std::vector<iovec> iov) {
+    size_t first = 0, received = 0;
+    while (first < iov.size()) {
+        if (iov[first].iov_len == 0) {
+            ++first;
+            continue;
+        }
+        ssize_t n = readv(fd, iov.data() + first, static_cast<int>(iov.size() - first));
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Error receiving frame: ") + strerror(errno));
+        }
+        if (n == 0) {
+            if (received == 0) return false;
+            throw std::runtime_error("Connection closed in the middle of a frame");
+        }
+        received += n;
+        first = detail::advanceIovecs(iov, first, n);
+    }
+    return true;
+}
+
+/**
+ * Receives one frame: the header, then the records with readv() straight
+ * into `pnls` and `ans`, which are resized to the counts of the header.
+ * Encoded records are decoded into `ans`. Returns false if the peer closed
+ * the connection between frames, throws on frames of more than
+ * `max_frame_bytes` record bytes.
+ */
+inline bool receiveResultFrame(int fd, ResultFrameHeader& header, std::vector<pnl_and_pos>& pnls,
+                               std::vector<twap_order>& ans,
+                               uint64_t max_frame_bytes = kDefaultMaxFrameBytes) {
+    if (!readFully(fd, {{&header, sizeof(header)}})) return false;
+    checkResultHeader(header, max_frame_bytes);
+    // Skip the extension of a newer header.
+    std::vector<char> extension(header.header_bytes - sizeof(header));
+    if (!readFully(fd, {{extension.data(), extension.size()}}) && !extension.empty())
+        throw std::runtime_error("Connection closed in the middle of a frame");
+    std::vector<uint8_t> encoded;
+    pnls.resize(header.pnl_count);
+    iovec twap_iov;
+    if (header.version == kEncodedResultFrameVersion) {
+        ResultFrameCodec codec;
+        std::memcpy(&codec, extension.data(), sizeof(codec));
+        checkResultCodec(header, codec);
+        encoded.resize(codec.twap_bytes);
+        twap_iov = {encoded.data(), encoded.size()};
+    } else {
+        ans.resize(header.twap_count);
+        twap_iov = {ans.data(), ans.size() * sizeof(twap_order)};
+    }
+    if (!readFully(fd, {{pnls.data(), pnls.size() * sizeof(pnl_and_pos)}, twap_iov}) &&
+        (pnls.size() + twap_iov.iov_len) != 0) {
+        throw std::runtime_error("Connection closed in the middle of a frame");
+    }
+    if (header.version == kEncodedResultFrameVersion)
+        decodeTwapOrders(encoded.data(), encoded.size(), header.twap_count, ans);
+    return true;
+}
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_PROTOCOL_H
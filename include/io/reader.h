@@ -6,9 +6,12 @@
 #include <sys/stat.h>  // 包含获取文件状态的函数定义。
 #include <unistd.h>
 
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <queue>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 
@@ -103,7 +106,7 @@ class MappedFile {
    public:
     MappedFile(const std::string& filePath) {
         // Open the file in read-only mode.
-        int fd = open(filePath.c_str(), O_RDONLY);
+        fd = open(filePath.c_str(), O_RDONLY);
         if (fd == -1) {
             throw std::runtime_error("Error opening file for reading: " + filePath);
         }
@@ -114,6 +117,7 @@ class MappedFile {
         struct stat sb;  // sb means status buffer.
         if (fstat(fd, &sb) == -1) {
             close(fd);
+            fd = -1;
             throw std::runtime_error("Error getting file status: " + filePath);
         }
 
@@ -124,6 +128,7 @@ class MappedFile {
         addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
         if (addr == MAP_FAILED) {
             close(fd);
+            fd = -1;
             throw std::runtime_error("Error mapping file into memory: " + filePath);
         }
     }
@@ -178,6 +183,105 @@ std::pair<std::unique_ptr<T, MunmapDeleter<T>>, size_t> reader_mmap(const std::s
     return std::make_pair(std::unique_ptr<T, MunmapDeleter<T>>(dataPtr, deleter), numElements);
 }
 
+/* Hints for how a RecordFile is mapped. */
+struct MapOptions {
+    // madvise(SEQUENTIAL | WILLNEED): aggressive readahead, pages are dropped after use.
+    bool sequential = true;
+    // MAP_POPULATE: fault in the whole file up front instead of during the replay.
+    bool populate = false;
+    // madvise(HUGEPAGE): only takes effect if the kernel supports huge pages for file mappings.
+    bool huge_pages = false;
+};
+
+/**
+ * A read-only view of a binary file of packed records, backed by mmap.
+ *
+ * Loading a file only costs page faults instead of a copy into a vector, and
+ * the view can be iterated like a span (`begin()`/`end()`/`operator[]`) or fed
+ * to `VectorQueue<T, RecordFile<T>>`. The mapping lives as long as the object.
+ */
+template <typename T>
+class RecordFile {
+   public:
+    using value_type = T;
+    using const_iterator = const T*;
+
+    explicit RecordFile(const std::string& filePath, const MapOptions& options = MapOptions()) {
+        int fd = open(filePath.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("Error opening file for reading: " + filePath);
+        }
+        struct stat sb;
+        if (fstat(fd, &sb) == -1) {
+            close(fd);
+            throw std::runtime_error("Error getting file status: " + filePath);
+        }
+        length = sb.st_size;
+        count = length / sizeof(T);
+
+        // mmap() rejects empty mappings, an empty file is an empty view.
+        if (length > 0) {
+            int flags = MAP_PRIVATE | (options.populate ? MAP_POPULATE : 0);
+            void* addr = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+            if (addr == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Error mapping file into memory: " + filePath);
+            }
+            records = static_cast<const T*>(addr);
+            // The hints are best effort: a kernel that does not support one still maps the file.
+            if (options.sequential) {
+                madvise(addr, length, MADV_SEQUENTIAL);
+                madvise(addr, length, MADV_WILLNEED);
+            }
+#ifdef MADV_HUGEPAGE
+            if (options.huge_pages) madvise(addr, length, MADV_HUGEPAGE);
+#endif
+        }
+        // The mapping keeps its own reference to the file.
+        close(fd);
+    }
+
+    ~RecordFile() { unmap(); }
+
+    RecordFile(RecordFile&& other) noexcept
+        : records(other.records), count(other.count), length(other.length) {
+        other.records = nullptr;
+        other.count = other.length = 0;
+    }
+
+    RecordFile& operator=(RecordFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            records = other.records;
+            count = other.count;
+            length = other.length;
+            other.records = nullptr;
+            other.count = other.length = 0;
+        }
+        return *this;
+    }
+
+    RecordFile(const RecordFile&) = delete;
+    RecordFile& operator=(const RecordFile&) = delete;
+
+    const T* data() const { return records; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t index) const { return records[index]; }
+    const_iterator begin() const { return records; }
+    const_iterator end() const { return records + count; }
+
+   private:
+    void unmap() {
+        if (records != nullptr) munmap(const_cast<T*>(records), length);
+        records = nullptr;
+    }
+
+    const T* records = nullptr;
+    size_t count = 0;
+    size_t length = 0;
+};
+
 template <typename T>
 std::vector<T> reader(const std::string& filePath,
                       int thread_count = std::thread::hardware_concurrency()) {
@@ -212,17 +316,17 @@ std::vector<T> reader(const std::string& filePath,
     return combined_data;
 }
 
-std::vector<UBIEngine::IO::prev_trade_info> read_prev_trade_info(
+inline std::vector<UBIEngine::IO::prev_trade_info> read_prev_trade_info(
     const std::string& filePath, int thread_count = std::thread::hardware_concurrency()) {
     return reader<UBIEngine::IO::prev_trade_info>(filePath, thread_count);
 }
 
-std::vector<UBIEngine::IO::order_log> read_order_log(
+inline std::vector<UBIEngine::IO::order_log> read_order_log(
     const std::string& filePath, int thread_count = std::thread::hardware_concurrency()) {
     return reader<UBIEngine::IO::order_log>(filePath, thread_count);
 }
 
-std::vector<UBIEngine::IO::alpha> read_alpha(
+inline std::vector<UBIEngine::IO::alpha> read_alpha(
     const std::string& filePath, int thread_count = std::thread::hardware_concurrency()) {
     return reader<UBIEngine::IO::alpha>(filePath, thread_count);
 }
@@ -234,7 +338,7 @@ struct priority_cmp {
     }
 };
 
-void emplaceTwapOrder_queue(
+inline void emplaceTwapOrder_queue(
     std::priority_queue<twap_order, std::vector<twap_order>, priority_cmp>& queue,
     const char* instrument_id, long timestamp, int32_t direction, int32_t volume, double price) {
     IO::twap_order order;
@@ -246,8 +350,8 @@ void emplaceTwapOrder_queue(
     queue.emplace(order);
 }
 
-void emplaceTwapOrder_vec(std::vector<twap_order>& vec, const char* instrument_id, long timestamp,
-                          int32_t direction, int32_t volume, double price) {
+inline void emplaceTwapOrder_vec(std::vector<twap_order>& vec, const char* instrument_id,
+                                 long timestamp, int32_t direction, int32_t volume, double price) {
     IO::twap_order order;
     std::memcpy(order.instrument_id, instrument_id, sizeof(order.instrument_id));
     order.timestamp = timestamp;
@@ -257,8 +361,8 @@ void emplaceTwapOrder_vec(std::vector<twap_order>& vec, const char* instrument_i
     vec.emplace_back(order);
 }
 
-void emplacePnlAndPos_vec(std::vector<pnl_and_pos>& vec, const char* instrument_id,
-                          int32_t position, double pnl) {
+inline void emplacePnlAndPos_vec(std::vector<pnl_and_pos>& vec, const char* instrument_id,
+                                 int32_t position, double pnl) {
     IO::pnl_and_pos pnl_and_pos;
     std::memcpy(pnl_and_pos.instrument_id, instrument_id, sizeof(pnl_and_pos.instrument_id));
     pnl_and_pos.position = position;
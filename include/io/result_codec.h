@@ -0,0 +1,143 @@
+#ifndef UBI_TRADER_IO_RESULT_CODEC_H
+#define UBI_TRADER_IO_RESULT_CODEC_H
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "io/type.h"
+#include "io/varint.h"
+#include "utils/robin_hood.h"
+
+namespace UBIEngine::IO {
+/**
+ * Wire codec of twap_order
+ * ========================
+ *
+ * The records of a result frame are sorted by timestamp and repeat a few
+ * instrument ids, so each row is encoded against the rows before it:
+ *
+ * - `varint(code << 1 | raw_price)`: the code of the instrument in the
+ *   dictionary of the frame. The next free code introduces an instrument, its
+ *   8 raw bytes follow.
+ * - the timestamp as the zig-zag varint of the delta to the previous row.
+ * - direction and volume as zig-zag varints.
+ * - the price as the zig-zag varint of its tick (0.01) delta to the previous
+ *   row of the same instrument (0 before the first one), or, with
+ *   `raw_price`, as the 8 raw bytes of the double if ticks / 100 does not give
+ *   it back bit for bit.
+ *
+ * Decoding gives exactly the records that were encoded, byte for byte. An
+ * encoder keeps its buffers between calls, so encoding a frame after the
+ * first allocates nothing.
+ */
+// More than the longest encoding of a record (43 bytes), to bound corrupted sizes.
+constexpr uint64_t kMaxEncodedTwapBytes = 48;
+
+class TwapEncoder {
+   public:
+    /* The encoding of `ans`, valid until the next call. */
+    const std::vector<uint8_t>& encode(const std::vector<twap_order>& ans) {
+        std::vector<uint8_t>& out = bytes;
+        out.clear();
+        codes_of.clear();
+        last_ticks.clear();
+        long last_timestamp = 0;
+        for (const twap_order& order : ans) {
+            uint64_t key;
+            std::memcpy(&key, order.instrument_id, sizeof(key));
+            auto new_code = static_cast<uint32_t>(last_ticks.size());
+            auto [it, inserted] = codes_of.emplace(key, new_code);
+            uint32_t code = it->second;
+            if (inserted) last_ticks.push_back(0);
+
+            int64_t ticks = 0;
+            bool raw_price = !exactTicks(order.price, ticks);
+            detail::putVarint(out, uint64_t(code) << 1 | uint64_t(raw_price));
+            if (inserted) append(out, &key, sizeof(key));
+            detail::putVarint(out, detail::zigzag(delta(order.timestamp, last_timestamp)));
+            detail::putVarint(out, detail::zigzag(order.direction));
+            detail::putVarint(out, detail::zigzag(order.volume));
+            if (raw_price) {
+                append(out, &order.price, sizeof(order.price));
+            } else {
+                detail::putVarint(out, detail::zigzag(ticks - last_ticks[code]));
+                last_ticks[code] = ticks;
+            }
+            last_timestamp = order.timestamp;
+        }
+        return out;
+    }
+
+   private:
+    /* Sets `ticks` and returns true if the decoder's `ticks / 100.0` is `price`, bit for bit. */
+    static bool exactTicks(double price, int64_t& ticks) {
+        if (!std::isfinite(price) || std::fabs(price) > 1e15) return false;
+        ticks = std::llround(price * 100);
+        double decoded = static_cast<double>(ticks) / 100;
+        return std::memcmp(&decoded, &price, sizeof(price)) == 0;
+    }
+
+    static void append(std::vector<uint8_t>& out, const void* data, size_t size) {
+        auto p = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), p, p + size);
+    }
+
+    /* Wraps around instead of overflowing, the decoder wraps back. */
+    static int64_t delta(long value, long previous) {
+        return static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(previous));
+    }
+
+    std::vector<uint8_t> bytes;
+    robin_hood::unordered_map<uint64_t, uint32_t> codes_of;
+    std::vector<int64_t> last_ticks;  // By code.
+};
+
+/**
+ * Decodes `count` records encoded by TwapEncoder into `ans`. Throws if the
+ * input is corrupted or does not hold exactly `count` records.
+ */
+inline void decodeTwapOrders(const uint8_t* data, size_t size, uint64_t count,
+                             std::vector<twap_order>& ans) {
+    // Every record takes at least 5 bytes, which bounds the allocation of a corrupted count.
+    if (count > size / 5) throw std::runtime_error("Bad encoded twap_order records");
+    ans.resize(count);
+    std::vector<uint64_t> keys;
+    std::vector<int64_t> last_ticks;
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    long last_timestamp = 0;
+    for (twap_order& order : ans) {
+        uint64_t tag = detail::getVarint(p, end);
+        uint64_t code = tag >> 1;
+        if (code == keys.size()) {
+            if (end - p < 8) throw std::runtime_error("Bad encoded twap_order records");
+            uint64_t key;
+            std::memcpy(&key, p, sizeof(key));
+            p += sizeof(key);
+            keys.push_back(key);
+            last_ticks.push_back(0);
+        } else if (code > keys.size()) {
+            throw std::runtime_error("Bad encoded twap_order records");
+        }
+        std::memcpy(order.instrument_id, &keys[code], sizeof(order.instrument_id));
+        uint64_t timestamp_delta = detail::unzigzag(detail::getVarint(p, end));
+        order.timestamp =
+            static_cast<long>(static_cast<uint64_t>(last_timestamp) + timestamp_delta);
+        order.direction = static_cast<int>(detail::unzigzag(detail::getVarint(p, end)));
+        order.volume = static_cast<int>(detail::unzigzag(detail::getVarint(p, end)));
+        if (tag & 1) {
+            if (end - p < 8) throw std::runtime_error("Bad encoded twap_order records");
+            std::memcpy(&order.price, p, sizeof(order.price));
+            p += sizeof(order.price);
+        } else {
+            last_ticks[code] += detail::unzigzag(detail::getVarint(p, end));
+            order.price = static_cast<double>(last_ticks[code]) / 100;
+        }
+        last_timestamp = order.timestamp;
+    }
+    if (p != end) throw std::runtime_error("Bad encoded twap_order records");
+}
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_RESULT_CODEC_H
@@ -0,0 +1,429 @@
+#ifndef UBI_TRADER_IO_RESULT_SERVER_H
+#define UBI_TRADER_IO_RESULT_SERVER_H
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "io/protocol.h"
+#include "io/result_writer.h"
+#include "utils/thread_pool.h"
+
+namespace UBIEngine::IO {
+/* One received result frame. */
+struct ReceivedResults {
+    ResultFrameHeader header;
+    std::vector<pnl_and_pos> pnls;
+    std::vector<twap_order> ans;
+};
+
+/* Options of ResultServer. */
+struct ResultServerOptions {
+    // The TCP port to listen on, 0 picks a free one (see `ResultServer::port()`).
+    uint16_t port = 0;
+    // The frames of a connection go to the same writer, so they are handled in order.
+    uint32_t write_threads = 2;
+    int backlog = 128;
+    // Connections announcing a frame of more record bytes are closed before allocating.
+    uint64_t max_frame_bytes = kDefaultMaxFrameBytes;
+    // A connection with this many frames waiting for its writer is not read until half of
+    // them are handled, so a slow disk pushes back on the senders instead of queueing.
+    uint32_t max_pending_frames = 16;
+};
+
+namespace detail {
+/**
+ * The receive state of one connection: reading a frame header, its extension,
+ * or the records it announced, which are read straight into the presized
+ * vectors (encoded records into a buffer, decoded once complete). The socket
+ * is non-blocking, `receive()` reads until it would block.
+ */
+class FrameConnection {
+   public:
+    explicit FrameConnection(int fd_, uint64_t max_frame_bytes_ = kDefaultMaxFrameBytes)
+        : fd(fd_), max_frame_bytes(max_frame_bytes_) {
+        reset();
+    }
+
+    /**
+     * Reads what is available and passes every completed frame to
+     * `on_frame`, which returns false to stop reading for now. Returns false
+     * once the peer closed the connection, throws on errors and bad frames.
+     */
+    template <typename OnFrame>
+    bool receive(OnFrame&& on_frame) {
+        while (true) {
+            ssize_t n = readv(fd, iov.data() + first, static_cast<int>(iov.size() - first));
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+                throw std::runtime_error(std::string("Error receiving frame: ") + strerror(errno));
+            }
+            if (n == 0) {
+                if (state == State::Header && first == 0 &&
+                    iov[0].iov_len == sizeof(ResultFrameHeader))
+                    return false;
+                throw std::runtime_error("Connection closed in the middle of a frame");
+            }
+            first = advanceIovecs(iov, first, n);
+            skipEmpty();
+            if (first < iov.size()) continue;
+            if (state == State::Header) {
+                startExtension();
+                if (first < iov.size()) continue;
+            }
+            if (state == State::Extension) {
+                startRecords();
+                if (first < iov.size()) continue;
+            }
+            if (frame->header.version == kEncodedResultFrameVersion)
+                decodeTwapOrders(encoded.data(), encoded.size(), frame->header.twap_count,
+                                 frame->ans);
+            bool more = on_frame(std::move(frame));
+            reset();
+            if (!more) return true;
+        }
+    }
+
+    int socket() const { return fd; }
+
+   private:
+    enum class State { Header, Extension, Records };
+
+    void reset() {
+        frame = std::make_unique<ReceivedResults>();
+        state = State::Header;
+        iov = {{&frame->header, sizeof(ResultFrameHeader)}};
+        first = 0;
+    }
+
+    void startExtension() {
+        checkResultHeader(frame->header, max_frame_bytes);
+        state = State::Extension;
+        extension.resize(frame->header.header_bytes - sizeof(ResultFrameHeader));
+        iov = {{extension.data(), extension.size()}};
+        first = 0;
+        skipEmpty();
+    }
+
+    void startRecords() {
+        state = State::Records;
+        frame->pnls.resize(frame->header.pnl_count);
+        iov = {{frame->pnls.data(), frame->pnls.size() * sizeof(pnl_and_pos)}};
+        if (frame->header.version == kEncodedResultFrameVersion) {
+            ResultFrameCodec codec;
+            std::memcpy(&codec, extension.data(), sizeof(codec));
+            checkResultCodec(frame->header, codec);
+            encoded.resize(codec.twap_bytes);
+            iov.push_back({encoded.data(), encoded.size()});
+        } else {
+            frame->ans.resize(frame->header.twap_count);
+            iov.push_back({frame->ans.data(), frame->ans.size() * sizeof(twap_order)});
+        }
+        first = 0;
+        skipEmpty();
+    }
+
+    void skipEmpty() {
+        while (first < iov.size() && iov[first].iov_len == 0) ++first;
+    }
+
+    int fd;
+    uint64_t max_frame_bytes;
+    std::unique_ptr<ReceivedResults> frame;
+    State state = State::Header;
+    std::vector<char> extension;
+    std::vector<uint8_t> encoded;
+    std::vector<iovec> iov;
+    size_t first = 0;
+};
+}  // namespace detail
+
+/**
+ * Receives result frames (see sendResultFrame()) from many engine processes
+ * at once. One thread runs an edge-triggered epoll loop over non-blocking
+ * sockets, each connection with its own receive state, and hands the
+ * completed frames to a small thread pool, so file writes never stall the
+ * sockets. A connection whose writer falls `max_pending_frames` behind is no
+ * longer read, so its sender blocks in TCP flow control, until the writer
+ * has caught up with half of them.
+ *
+ * `run()` serves until `stop()` is called, from any thread.
+ */
+class ResultServer {
+   public:
+    using Handler = std::function<void(ReceivedResults&)>;
+
+    /**
+     * Listens on `options.port`.
+     *
+     * @param handler called with every frame on a pool thread, the frames of
+     *                a connection in order. See `fileHandler()`.
+     */
+    ResultServer(Handler handler_, const ResultServerOptions& options = ResultServerOptions())
+        : handler(std::move(handler_)),
+          max_frame_bytes(options.max_frame_bytes),
+          max_pending_frames(std::max(1u, options.max_pending_frames)),
+          pool(std::max(1u, options.write_threads)) {
+        listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (listen_fd == -1 || epoll_fd == -1 || wake_fd == -1) {
+            closeAll();
+            throw std::runtime_error("创建 socket 失败！");
+        }
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options.port);
+        addr.sin_addr.s_addr = INADDR_ANY;
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+            listen(listen_fd, options.backlog) == -1 ||
+            getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1) {
+            closeAll();
+            throw std::runtime_error("Bind failed!");
+        }
+        bound_port = ntohs(addr.sin_port);
+        watch(listen_fd, EPOLLIN);
+        watch(wake_fd, EPOLLIN);
+    }
+
+    ResultServer(const ResultServer&) = delete;
+    ResultServer& operator=(const ResultServer&) = delete;
+
+    /* Closes the sockets, the frames already received are still handled. */
+    ~ResultServer() { closeAll(); }
+
+    /* The port the server listens on. */
+    uint16_t port() const { return bound_port; }
+
+    /* Serves until `stop()`. */
+    void run() {
+        std::vector<epoll_event> events(64);
+        while (!stopping) {
+            int n = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("epoll_wait failed: ") + strerror(errno));
+            }
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listen_fd) {
+                    acceptAll();
+                } else if (fd == wake_fd) {
+                    resumeCaughtUp();
+                } else {
+                    serve(fd);
+                }
+            }
+        }
+    }
+
+    /* Makes `run()` return. Thread-safe. */
+    void stop() {
+        stopping = true;
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    /* The number of frames received. */
+    uint64_t frames() const { return frame_count; }
+    /* The number of open connections. */
+    size_t connections() const { return open_connections; }
+    /* The number of times a connection stopped being read because its writer fell behind. */
+    uint64_t pauses() const { return pause_count; }
+
+    /**
+     * The handler that writes each frame to
+     * `<output_dir>/twap_order/<session>` and `<output_dir>/pnl_and_pos/<session>`.
+     */
+    static Handler fileHandler(const std::string& output_dir, bool verbose = false) {
+        return [output_dir, verbose](ReceivedResults& results) {
+            std::string name = sessionName(results.header);
+            std::string twap_path = output_dir + "/twap_order/" + name;
+            std::string pnl_path = output_dir + "/pnl_and_pos/" + name;
+            WriteOptions options;
+            options.use_uring = false;  // Small writes from several threads.
+            writeFiles({{twap_path, reinterpret_cast<const char*>(results.ans.data()),
+                         results.ans.size() * sizeof(twap_order)},
+                        {pnl_path, reinterpret_cast<const char*>(results.pnls.data()),
+                         results.pnls.size() * sizeof(pnl_and_pos)}},
+                       options);
+            if (verbose) std::cout << "Finish writing to: " << twap_path << std::endl;
+        };
+    }
+
+   private:
+    /* The frames of a connection handed to its writer and not handled yet. */
+    struct Backlog {
+        std::atomic<uint32_t> pending{0};
+    };
+
+    struct Connection {
+        std::unique_ptr<detail::FrameConnection> receiver;
+        std::shared_ptr<Backlog> backlog;  // Shared with the writer tasks of its frames.
+        uint32_t writer;                   // The pool queue of its frames.
+        bool paused = false;               // Not watched for EPOLLIN, see pause().
+    };
+
+    void watch(int fd, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+            throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd == -1) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    std::cerr << "Accept failed: " << strerror(errno) << std::endl;
+                return;
+            }
+            connections_by_fd.emplace(
+                fd, Connection{std::make_unique<detail::FrameConnection>(fd, max_frame_bytes),
+                               std::make_shared<Backlog>(), next_writer++});
+            watch(fd, EPOLLIN | EPOLLRDHUP | EPOLLET);
+            ++open_connections;
+        }
+    }
+
+    void serve(int fd) {
+        auto it = connections_by_fd.find(fd);
+        if (it == connections_by_fd.end() || it->second.paused) return;
+        Connection& connection = it->second;
+        uint32_t writer = connection.writer % pool.numberOfThreads();
+        std::shared_ptr<Backlog> backlog = connection.backlog;
+        bool open;
+        try {
+            open = connection.receiver->receive([&](std::unique_ptr<ReceivedResults> frame) {
+                ++frame_count;
+                // std::function 需要可拷贝，帧放在 shared_ptr 里交给写线程。
+                std::shared_ptr<ReceivedResults> results(std::move(frame));
+                uint32_t pending = ++backlog->pending;
+                pool.submitTask(writer, [this, results, backlog] {
+                    try {
+                        handler(*results);
+                    } catch (const std::exception& e) {
+                        std::cerr << "Error handling " << sessionName(results->header) << ": "
+                                  << e.what() << std::endl;
+                    }
+                    if (--backlog->pending == max_pending_frames / 2) wakeCaughtUp(backlog);
+                });
+                if (pending < max_pending_frames) return true;
+                pause(fd, connection);
+                return false;
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "Error handling client: " << e.what() << std::endl;
+            open = false;
+        }
+        if (!open) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            connections_by_fd.erase(it);
+            --open_connections;
+        }
+    }
+
+    /* Stops reading `connection` until its writer has caught up, see resumeCaughtUp(). */
+    void pause(int fd, Connection& connection) {
+        connection.paused = true;
+        ++pause_count;
+        epoll_event event{};
+        event.events = EPOLLET;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    /* Called by a writer thread when `backlog` has drained to the resume point. */
+    void wakeCaughtUp(const std::shared_ptr<Backlog>& backlog) {
+        std::lock_guard<std::mutex> lock(caught_up_mutex);  // closeAll() closes wake_fd.
+        caught_up.push_back(backlog);
+        if (wake_fd == -1) return;
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    /* Reads the paused connections whose writers have caught up again. */
+    void resumeCaughtUp() {
+        uint64_t count;
+        ssize_t ignored = read(wake_fd, &count, sizeof(count));
+        (void)ignored;
+        std::vector<std::shared_ptr<Backlog>> backlogs;
+        {
+            std::lock_guard<std::mutex> lock(caught_up_mutex);
+            backlogs.swap(caught_up);
+        }
+        for (const auto& backlog : backlogs) {
+            // The connection may be closed, or its fd reused, since the writer woke us.
+            auto it = std::find_if(
+                connections_by_fd.begin(), connections_by_fd.end(),
+                [&](const auto& entry) { return entry.second.backlog == backlog; });
+            if (it == connections_by_fd.end() || !it->second.paused ||
+                backlog->pending > max_pending_frames / 2)
+                continue;
+            it->second.paused = false;
+            int fd = it->first;
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+            event.data.fd = fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+            // Edge-triggered: the bytes that arrived while paused raise no new event.
+            serve(fd);
+        }
+    }
+
+    void closeAll() {
+        for (auto& entry : connections_by_fd) close(entry.first);
+        connections_by_fd.clear();
+        std::lock_guard<std::mutex> lock(caught_up_mutex);
+        for (int fd : {listen_fd, epoll_fd, wake_fd})
+            if (fd != -1) close(fd);
+        listen_fd = epoll_fd = wake_fd = -1;
+    }
+
+    Handler handler;
+    uint64_t max_frame_bytes;
+    uint32_t max_pending_frames;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    uint16_t bound_port = 0;
+    std::atomic_bool stopping{false};
+    std::atomic<uint64_t> frame_count{0};
+    std::atomic<size_t> open_connections{0};
+    std::atomic<uint64_t> pause_count{0};
+    uint32_t next_writer = 0;
+    std::unordered_map<int, Connection> connections_by_fd;
+    std::mutex caught_up_mutex;
+    std::vector<std::shared_ptr<Backlog>> caught_up;  // Guarded by caught_up_mutex.
+    // Declared last: destroyed first, so queued frames are handled while the rest is alive.
+    Concurrent::ThreadPool pool;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_RESULT_SERVER_H
@@ -0,0 +1,219 @@
+#ifndef UBI_TRADER_IO_RESULT_SHIPPER_H
+#define UBI_TRADER_IO_RESULT_SHIPPER_H
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "io/protocol.h"
+#include "io/sender.h"
+#include "utils/latency_histogram.h"
+
+namespace UBIEngine::IO {
+/* The results of one session to ship, named like the output files (YYYYMMDD_x_y). */
+struct ShippedResults {
+    std::string session_name;
+    std::vector<pnl_and_pos> pnls;
+    std::vector<twap_order> ans;
+};
+
+/* Options of ResultShipper. */
+struct ShipperOptions {
+    // The IPv4 address and port of the receiver (see ResultServer).
+    std::string host = "127.0.0.1";
+    uint16_t port = 8081;
+    // The sessions that may wait for the network, `submit()` blocks beyond it.
+    size_t capacity = 4;
+    // The delay before reconnecting, doubled after every failure up to `retry_max`.
+    std::chrono::milliseconds retry_initial{10};
+    std::chrono::milliseconds retry_max{1000};
+    // Send large frames with MSG_ZEROCOPY.
+    bool zerocopy = true;
+    // Send twap_order records with the wire codec of io/result_codec.h, for links where
+    // bandwidth is scarcer than CPU. The receiver must support encoded frames.
+    bool compress = false;
+};
+
+/* Counters of a ResultShipper. Latencies are from `submit()` until the frame is sent. */
+struct ShipperStats {
+    uint64_t submitted = 0;
+    uint64_t sent = 0;
+    uint64_t dropped = 0;     // Given up on by `close()` while disconnected.
+    uint64_t reconnects = 0;  // Connections lost or not established.
+    size_t queued = 0;
+    uint64_t p50_us = 0;
+    uint64_t p99_us = 0;
+    uint64_t max_us = 0;
+};
+
+/**
+ * Ships session results to a receiver on a background thread, so the
+ * replay never waits for the network.
+ *
+ * Producers `submit()` results into a bounded queue (any number of threads),
+ * one I/O thread drains it over a persistent connection as result frames.
+ * When the queue is full `submit()` waits (backpressure, so memory stays
+ * bounded) and `trySubmit()` fails. A failed send drops the connection, the
+ * thread reconnects with exponential backoff and resends the whole frame;
+ * the receiver discards the partial frame of the lost connection.
+ */
+class ResultShipper {
+   public:
+    explicit ResultShipper(const ShipperOptions& options_ = ShipperOptions())
+        : options(options_) {
+        worker = std::thread([this] { run(); });
+    }
+
+    ResultShipper(const ResultShipper&) = delete;
+    ResultShipper& operator=(const ResultShipper&) = delete;
+
+    ~ResultShipper() { close(); }
+
+    /* Queues `results`, waits while the queue is full. */
+    void submit(ShippedResults&& results) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return closing || queue.size() < options.capacity; });
+        if (closing) throw std::logic_error("The shipper is closed");
+        push(std::move(results));
+        lock.unlock();
+        changed.notify_all();
+    }
+
+    /* Queues `results` unless the queue is full, then `results` is left as is. */
+    bool trySubmit(ShippedResults& results) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closing || queue.size() >= options.capacity) return false;
+            push(std::move(results));
+        }
+        changed.notify_all();
+        return true;
+    }
+
+    /* Waits until everything submitted is sent. */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return queue.empty() && !sending; });
+    }
+
+    /**
+     * Sends what is queued and stops the I/O thread. Results that cannot be
+     * sent because the receiver is unreachable are dropped.
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closing && !worker.joinable()) return;
+            closing = true;
+        }
+        changed.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    ShipperStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        ShipperStats result = counters;
+        result.queued = queue.size();
+        if (latencies.size() != 0) {
+            result.p50_us = latencies.percentile(0.5) / 1000;
+            result.p99_us = latencies.percentile(0.99) / 1000;
+        }
+        return result;
+    }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Message {
+        ShippedResults results;
+        Clock::time_point submitted;
+    };
+
+    void push(ShippedResults&& results) {
+        queue.push_back({std::move(results), Clock::now()});
+        ++counters.submitted;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto backoff = options.retry_initial;
+        while (true) {
+            changed.wait(lock, [&] { return closing || !queue.empty(); });
+            if (queue.empty()) return;
+            Message message = std::move(queue.front());
+            queue.pop_front();
+            sending = true;
+            lock.unlock();
+            changed.notify_all();  // Room for a producer.
+
+            bool sent = false, given_up = false;
+            while (!sent && !given_up) {
+                try {
+                    if (!socket) socket = std::make_unique<GlobalSocket>(options.host.c_str(),
+                                                                         options.port);
+                    const ShippedResults& results = message.results;
+                    FrameSendOptions send_options;
+                    send_options.zerocopy = options.zerocopy;
+                    if (options.compress) send_options.encoder = &encoder;
+                    sendResultFrame(socket->getSocket(),
+                                    makeResultHeader(results.session_name, results.pnls.size(),
+                                                     results.ans.size()),
+                                    results.pnls, results.ans, send_options);
+                    sent = true;
+                    backoff = options.retry_initial;
+                } catch (const std::invalid_argument& e) {
+                    // Not a network error, retrying cannot help.
+                    std::cerr << "[Ship]: " << e.what() << std::endl;
+                    given_up = true;
+                } catch (const std::exception& e) {
+                    socket.reset();
+                    lock.lock();
+                    ++counters.reconnects;
+                    // While closing, a receiver that is down is not waited for.
+                    given_up = closing;
+                    if (!given_up) changed.wait_for(lock, backoff);
+                    lock.unlock();
+                    backoff = std::min(backoff * 2, options.retry_max);
+                }
+            }
+
+            auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               Clock::now() - message.submitted)
+                               .count();
+            lock.lock();
+            sending = false;
+            if (sent) {
+                ++counters.sent;
+                latencies.add(latency);
+                counters.max_us = std::max<uint64_t>(counters.max_us, latency / 1000);
+            } else {
+                ++counters.dropped;
+            }
+            changed.notify_all();
+        }
+    }
+
+    ShipperOptions options;
+    std::unique_ptr<GlobalSocket> socket;  // Only used by the I/O thread.
+    TwapEncoder encoder;                   // Only used by the I/O thread.
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Message> queue;
+    bool sending = false;
+    bool closing = false;
+    ShipperStats counters;
+    Utils::LatencyHistogram latencies;
+    std::thread worker;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_RESULT_SHIPPER_H
@@ -0,0 +1,275 @@
+#ifndef UBI_TRADER_IO_RESULT_WRITER_H
+#define UBI_TRADER_IO_RESULT_WRITER_H
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "io/bulk_reader.h"
+#include "io/type.h"
+
+namespace UBIEngine::IO {
+/* When the written files are flushed to the device. */
+enum class FsyncPolicy {
+    None,  // Leave it to the page cache.
+    Data,  // fdatasync() every file before it counts as written.
+    Full,  // fsync() every file, metadata included.
+};
+
+/* Options of `writeFiles` and ResultWriter. */
+struct WriteOptions {
+    // Use io_uring. Falls back to pwrite if the kernel does not provide it.
+    bool use_uring = true;
+    FsyncPolicy fsync = FsyncPolicy::None;
+    // The size of each write request.
+    size_t block_size = 1 << 20;
+    // The maximum number of writes in flight.
+    unsigned queue_depth = 16;
+};
+
+/* A file to write: `bytes` bytes from `data`, which must stay valid until written. */
+struct OutputFile {
+    std::string path;
+    const char* data;
+    size_t bytes;
+};
+
+namespace detail {
+/* One write request: [offset, offset + length) of a file from its data. */
+struct WriteRequest {
+    int fd;
+    const char* data;
+    size_t offset;
+    size_t length;
+};
+
+/**
+ * Accounts for `n` bytes written by a request. Returns false if the request
+ * is complete, otherwise moves it past the bytes that were written.
+ */
+inline bool advanceRequest(WriteRequest& request, ssize_t n) {
+    if (n < 0) throw std::runtime_error(std::string("Error writing file: ") + strerror(-n));
+    if (static_cast<size_t>(n) >= request.length) return false;
+    if (n == 0) throw std::runtime_error("Error writing file: no progress");
+    request.offset += n;
+    request.length -= n;
+    return true;
+}
+
+inline void pwriteAll(std::deque<WriteRequest>& requests) {
+    while (!requests.empty()) {
+        WriteRequest request = requests.front();
+        requests.pop_front();
+        do {
+            ssize_t n = pwrite(request.fd, request.data + request.offset, request.length,
+                               request.offset);
+            if (n == -1 && errno == EINTR) continue;
+            if (!advanceRequest(request, n == -1 ? -errno : n)) break;
+        } while (true);
+    }
+}
+
+/* Writes the files together, through `uring` if it is not null. */
+inline void writeFiles(const std::vector<OutputFile>& outputs, const WriteOptions& options,
+                       Uring* uring) {
+    if (options.block_size == 0) throw std::invalid_argument("block_size must be positive");
+    std::vector<int> fds;
+    struct FdCloser {
+        std::vector<int>& fds;
+        ~FdCloser() {
+            for (int fd : fds) close(fd);
+        }
+    } closer{fds};
+
+    std::deque<WriteRequest> requests;
+    for (const auto& output : outputs) {
+        int fd = open(output.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) throw std::runtime_error("Error opening file for writing: " + output.path);
+        fds.push_back(fd);
+        for (size_t offset = 0; offset < output.bytes; offset += options.block_size) {
+            size_t length = std::min(options.block_size, output.bytes - offset);
+            // The request keeps the file's base pointer, offsets index both file and data.
+            requests.push_back({fd, output.data, offset, length});
+        }
+    }
+
+    if (uring != nullptr) {
+        uring->submitAll(requests, [](const WriteRequest& request, io_uring_sqe& sqe) {
+            sqe.opcode = IORING_OP_WRITE;
+            sqe.fd = request.fd;
+            sqe.addr = reinterpret_cast<uint64_t>(request.data + request.offset);
+            sqe.len = static_cast<uint32_t>(request.length);
+            sqe.off = request.offset;
+        });
+    } else {
+        pwriteAll(requests);
+    }
+
+    if (options.fsync == FsyncPolicy::None) return;
+    for (size_t i = 0; i < fds.size(); ++i) {
+        int ret = options.fsync == FsyncPolicy::Data ? fdatasync(fds[i]) : fsync(fds[i]);
+        if (ret == -1) throw std::runtime_error("Error syncing file: " + outputs[i].path);
+    }
+}
+}  // namespace detail
+
+/**
+ * Writes whole files synchronously, all of them in one batch of io_uring
+ * writes (pwrite where io_uring is unavailable). Existing files are truncated.
+ */
+inline void writeFiles(const std::vector<OutputFile>& outputs,
+                       const WriteOptions& options = WriteOptions()) {
+    detail::Uring uring;
+    bool ring = options.use_uring && uring.init(std::max(1u, options.queue_depth));
+    detail::writeFiles(outputs, options, ring ? &uring : nullptr);
+}
+
+/* The results of one session and the files they go to. */
+struct SessionResults {
+    std::string twap_path;
+    std::string pnl_path;
+    std::vector<twap_order> twap_orders;
+    std::vector<pnl_and_pos> pnls;
+};
+
+/**
+ * Writes session results on a background thread, so the next session can be
+ * replayed while the previous one is written.
+ *
+ * It is double buffered: `acquire()` hands out one of two SessionResults,
+ * which the caller fills and passes back with `submit()`. The writer thread
+ * writes both files of a submitted session, then the buffer can be acquired
+ * again. The vectors keep their capacity, so after the first sessions no
+ * allocation happens and nothing is copied. `acquire()` only waits if both
+ * buffers are still being written.
+ *
+ * Errors of the writer thread are rethrown by the next `acquire()` or
+ * `flush()`.
+ */
+class ResultWriter {
+   public:
+    explicit ResultWriter(const WriteOptions& options_ = WriteOptions(), bool verbose_ = false)
+        : options(options_), verbose(verbose_) {
+        ring_ready = options.use_uring && uring.init(std::max(1u, options.queue_depth));
+        worker = std::thread([this] { run(); });
+    }
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    /* Waits until every submitted session is written. */
+    ~ResultWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        worker.join();
+    }
+
+    /* An empty buffer to fill, require that the previous one was submitted. */
+    SessionResults& acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (acquired) throw std::logic_error("The acquired results were not submitted");
+        changed.wait(lock, [&] { return !busy[next]; });
+        rethrow();
+        acquired = true;
+        SessionResults& results = slots[next];
+        results.twap_orders.clear();
+        results.pnls.clear();
+        return results;
+    }
+
+    /* Queues the acquired buffer for writing. */
+    void submit() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!acquired) throw std::logic_error("No results were acquired");
+            acquired = false;
+            busy[next] = true;
+            queue.push_back(next);
+            next ^= 1;
+        }
+        changed.notify_all();
+    }
+
+    /* Waits until every submitted session is written. */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return !busy[0] && !busy[1]; });
+        rethrow();
+    }
+
+    /* True if the writes go through io_uring. */
+    bool usesUring() const { return ring_ready; }
+
+   private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            size_t slot = queue.front();
+            lock.unlock();
+
+            const SessionResults& results = slots[slot];
+            std::exception_ptr failure;
+            try {
+                detail::writeFiles(
+                    {{results.twap_path, reinterpret_cast<const char*>(results.twap_orders.data()),
+                      results.twap_orders.size() * sizeof(twap_order)},
+                     {results.pnl_path, reinterpret_cast<const char*>(results.pnls.data()),
+                      results.pnls.size() * sizeof(pnl_and_pos)}},
+                    options, ring_ready ? &uring : nullptr);
+                if (verbose) {
+                    std::cout << "Finish writing to: " << results.twap_path << "\n"
+                              << "Finish writing to: " << results.pnl_path << std::endl;
+                }
+            } catch (...) {
+                failure = std::current_exception();
+            }
+
+            lock.lock();
+            if (failure && !error) error = failure;
+            queue.pop_front();
+            busy[slot] = false;
+            changed.notify_all();
+        }
+    }
+
+    void rethrow() {
+        if (error) std::rethrow_exception(std::exchange(error, nullptr));
+    }
+
+    WriteOptions options;
+    bool verbose;
+    detail::Uring uring;  // Only used by the writer thread.
+    bool ring_ready = false;
+
+    std::array<SessionResults, 2> slots;
+    std::array<bool, 2> busy{};
+    size_t next = 0;  // The slot `acquire()` hands out.
+    bool acquired = false;
+    std::deque<size_t> queue;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread worker;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_RESULT_WRITER_H
@@ -0,0 +1,363 @@
+#ifndef UBI_TRADER_IO_SHM_TRANSPORT_H
+#define UBI_TRADER_IO_SHM_TRANSPORT_H
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "io/protocol.h"
+
+namespace UBIEngine::IO {
+/**
+ * A vector-like view of a fixed block of memory, for the replay to write
+ * records in place (see SortedTwapOutput). `reserve()` beyond the block
+ * throws instead of reallocating.
+ */
+template <typename T>
+class FixedRecords {
+   public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    FixedRecords() = default;
+    FixedRecords(T* records_, size_t capacity_) : records(records_), allocated(capacity_) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return allocated; }
+
+    T* data() { return records; }
+    const T* data() const { return records; }
+    iterator begin() { return records; }
+    iterator end() { return records + count; }
+    const_iterator begin() const { return records; }
+    const_iterator end() const { return records + count; }
+    T& operator[](size_t index) { return records[index]; }
+    const T& operator[](size_t index) const { return records[index]; }
+    T& back() { return records[count - 1]; }
+    const T& back() const { return records[count - 1]; }
+
+    void reserve(size_t n) {
+        if (n > allocated) throw std::length_error("FixedRecords: capacity exceeded");
+    }
+
+    void push_back(const T& value) {
+        reserve(count + 1);
+        records[count++] = value;
+    }
+
+    void emplace_back(const T& value) { push_back(value); }
+
+    iterator insert(const_iterator pos, const T& value) {
+        size_t index = pos - records;
+        reserve(count + 1);
+        std::memmove(records + index + 1, records + index, (count - index) * sizeof(T));
+        records[index] = value;
+        ++count;
+        return records + index;
+    }
+
+   private:
+    T* records = nullptr;
+    size_t count = 0;
+    size_t allocated = 0;
+};
+
+namespace detail {
+constexpr uint64_t kShmRingMagic = 0x55424953484d5247;  // "UBISHMRG"
+constexpr size_t kShmAlign = 64;
+
+/* The control block at the start of the shared region, followed by the ring. */
+struct ShmRingHeader {
+    uint64_t magic;
+    uint64_t capacity;  // Bytes of the ring, a multiple of kShmAlign.
+    alignas(64) std::atomic<uint64_t> head;  // Bytes ever committed by the sender.
+    alignas(64) std::atomic<uint64_t> tail;  // Bytes ever released by the receiver.
+    // Doorbells: bumped after every commit/release, futex-waited on by the other side.
+    alignas(64) std::atomic<uint32_t> data_bell;
+    alignas(64) std::atomic<uint32_t> space_bell;
+    std::atomic<uint32_t> sender_closed;
+    std::atomic<uint32_t> receiver_closed;
+    // Set by the one sender of the ring, for good: the receiver stops after it closes.
+    std::atomic<uint32_t> sender_attached;
+};
+
+/* An entry of the ring. Entries never wrap; the rest of the ring is padding then. */
+struct ShmEntry {
+    uint64_t bytes;  // The entry, this header included, aligned to kShmAlign.
+    uint32_t padding;
+    uint32_t reserved;
+    ResultFrameHeader header;
+};
+static_assert(sizeof(ShmEntry) <= kShmAlign, "The entry header must fit in one line");
+
+inline size_t alignShm(size_t bytes) { return (bytes + kShmAlign - 1) & ~(kShmAlign - 1); }
+
+inline void futexWait(std::atomic<uint32_t>& word, uint32_t seen, long timeout_ms) {
+    timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, seen, &timeout, nullptr,
+            0);
+}
+
+inline void futexWake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT32_MAX, nullptr,
+            nullptr, 0);
+}
+
+/* A mapping of the shared region `name` (see shm_open()). */
+class ShmRegion {
+   public:
+    ShmRegion(const std::string& name_, size_t capacity, bool create) : name(name_) {
+        int fd = shm_open(name.c_str(), O_RDWR | (create ? O_CREAT | O_EXCL : 0), 0600);
+        if (fd == -1) throw std::runtime_error("Error opening shared memory: " + name);
+        if (create) {
+            bytes = sizeof(ShmRingHeader) + alignShm(capacity);
+            if (ftruncate(fd, bytes) == -1) {
+                close(fd);
+                shm_unlink(name.c_str());
+                throw std::runtime_error("Error sizing shared memory: " + name);
+            }
+        } else {
+            uint64_t probe[2];  // magic and capacity.
+            if (pread(fd, probe, sizeof(probe), 0) != sizeof(probe) || probe[0] != kShmRingMagic) {
+                close(fd);
+                throw std::runtime_error("Not a result ring: " + name);
+            }
+            bytes = sizeof(ShmRingHeader) + probe[1];
+        }
+        void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            if (create) shm_unlink(name.c_str());
+            throw std::runtime_error("Error mapping shared memory: " + name);
+        }
+        base = static_cast<char*>(mapping);
+        owner = create;
+        if (create) {
+            ShmRingHeader* ring = new (base) ShmRingHeader();
+            ring->capacity = alignShm(capacity);
+            ring->magic = kShmRingMagic;
+        }
+    }
+
+    ShmRegion(const ShmRegion&) = delete;
+    ShmRegion& operator=(const ShmRegion&) = delete;
+
+    ~ShmRegion() {
+        munmap(base, bytes);
+        if (owner) shm_unlink(name.c_str());
+    }
+
+    ShmRingHeader& header() { return *reinterpret_cast<ShmRingHeader*>(base); }
+    char* ring() { return base + sizeof(ShmRingHeader); }
+
+   private:
+    std::string name;
+    char* base = nullptr;
+    size_t bytes = 0;
+    bool owner = false;
+};
+}  // namespace detail
+
+/**
+ * The engine side of a shared-memory result ring created by a
+ * ShmResultReceiver on the same host.
+ *
+ * A session reserves its worst-case frame with `beginFrame()`, the replay
+ * writes the TWAP orders straight into the ring through `ShmFrame::ans`, and
+ * `commit()` appends the pnls after them and publishes the frame with the
+ * actual size; the unused part of the reservation is not consumed. Waiting
+ * for space and for frames uses futex doorbells in the shared region.
+ *
+ * A ring has exactly one sender: `head` is written without synchronization
+ * and the receiver stops once that sender closes. Attaching a second sender
+ * throws, so every engine process needs a ring (and a receiver) of its own.
+ */
+class ShmResultSender {
+   public:
+    /* A frame being written. */
+    struct ShmFrame {
+        FixedRecords<twap_order> ans;
+        std::string session_name;
+        uint64_t offset = 0;  // The position of the entry in the ring.
+        size_t max_pnls = 0;
+    };
+
+    /* Throws if the ring has had a sender already. */
+    explicit ShmResultSender(const std::string& name) : region(name, 0, false) {
+        uint32_t free = 0;
+        if (!region.header().sender_attached.compare_exchange_strong(free, 1))
+            throw std::runtime_error("The result ring " + name + " has a sender already");
+        region.header().sender_closed.store(0);
+    }
+
+    ShmResultSender(const ShmResultSender&) = delete;
+    ShmResultSender& operator=(const ShmResultSender&) = delete;
+
+    /* Tells the receiver that no more frames follow. */
+    ~ShmResultSender() {
+        region.header().sender_closed.store(1);
+        region.header().data_bell.fetch_add(1);
+        detail::futexWake(region.header().data_bell);
+    }
+
+    /**
+     * Reserves room for a frame of up to `max_twaps` orders and `max_pnls`
+     * pnls, waiting while the receiver has not released enough of the ring.
+     * Throws if the frame can never fit or the receiver is gone.
+     */
+    ShmFrame beginFrame(const std::string& session_name, size_t max_twaps, size_t max_pnls) {
+        detail::ShmRingHeader& ring = region.header();
+        size_t bytes = detail::alignShm(sizeof(detail::ShmEntry) + max_twaps * sizeof(twap_order) +
+                                        max_pnls * sizeof(pnl_and_pos));
+        if (bytes > ring.capacity)
+            throw std::length_error("The frame of " + session_name + " does not fit the ring");
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        // Entries do not wrap: skip the end of the ring if the frame does not fit there.
+        uint64_t skip = ring.capacity - head % ring.capacity < bytes
+                            ? ring.capacity - head % ring.capacity
+                            : 0;
+        while (true) {
+            uint32_t seen = ring.space_bell.load();
+            if (ring.receiver_closed.load()) throw std::runtime_error("The receiver is gone");
+            if (head + skip + bytes - ring.tail.load(std::memory_order_acquire) <= ring.capacity)
+                break;
+            detail::futexWait(ring.space_bell, seen, 100);
+        }
+        if (skip != 0) {
+            auto* padding = reinterpret_cast<detail::ShmEntry*>(region.ring() +
+                                                                head % ring.capacity);
+            padding->bytes = skip;
+            padding->padding = 1;
+            head += skip;
+            ring.head.store(head, std::memory_order_release);
+        }
+        ShmFrame frame;
+        frame.session_name = session_name;
+        frame.offset = head;
+        frame.max_pnls = max_pnls;
+        frame.ans = FixedRecords<twap_order>(
+            reinterpret_cast<twap_order*>(entry(head) + 1), max_twaps);
+        return frame;
+    }
+
+    /* Appends `pnls` after the orders and publishes the frame. */
+    void commit(ShmFrame& frame, const std::vector<pnl_and_pos>& pnls) {
+        if (pnls.size() > frame.max_pnls) throw std::length_error("Too many pnls for the frame");
+        detail::ShmEntry* target = entry(frame.offset);
+        target->header = makeResultHeader(frame.session_name, pnls.size(), frame.ans.size());
+        std::memcpy(reinterpret_cast<char*>(frame.ans.data() + frame.ans.size()), pnls.data(),
+                    pnls.size() * sizeof(pnl_and_pos));
+        target->bytes = detail::alignShm(sizeof(detail::ShmEntry) +
+                                         frame.ans.size() * sizeof(twap_order) +
+                                         pnls.size() * sizeof(pnl_and_pos));
+        target->padding = 0;
+        detail::ShmRingHeader& ring = region.header();
+        ring.head.store(frame.offset + target->bytes, std::memory_order_release);
+        ring.data_bell.fetch_add(1);
+        detail::futexWake(ring.data_bell);
+    }
+
+    /* Copies a whole frame into the ring. */
+    void send(const std::string& session_name, const std::vector<pnl_and_pos>& pnls,
+              const std::vector<twap_order>& ans) {
+        ShmFrame frame = beginFrame(session_name, ans.size(), pnls.size());
+        for (const auto& order : ans) frame.ans.push_back(order);
+        commit(frame, pnls);
+    }
+
+   private:
+    detail::ShmEntry* entry(uint64_t offset) {
+        return reinterpret_cast<detail::ShmEntry*>(region.ring() +
+                                                   offset % region.header().capacity);
+    }
+
+    detail::ShmRegion region;
+};
+
+/* A frame in the ring, valid until it is released. */
+struct ShmFrameView {
+    ResultFrameHeader header;
+    const twap_order* ans = nullptr;
+    const pnl_and_pos* pnls = nullptr;
+    uint64_t end = 0;  // The ring position after the frame.
+};
+
+/**
+ * The receiver side: creates the shared region `name` (removed again by the
+ * destructor) and hands out the frames in place, so they can be written to
+ * disk or forwarded straight from shared memory.
+ */
+class ShmResultReceiver {
+   public:
+    ShmResultReceiver(const std::string& name, size_t capacity = size_t(256) << 20)
+        : region(name, capacity, true) {}
+
+    ShmResultReceiver(const ShmResultReceiver&) = delete;
+    ShmResultReceiver& operator=(const ShmResultReceiver&) = delete;
+
+    ~ShmResultReceiver() {
+        region.header().receiver_closed.store(1);
+        region.header().space_bell.fetch_add(1);
+        detail::futexWake(region.header().space_bell);
+    }
+
+    /**
+     * Waits up to `timeout_ms` (forever if negative) for the oldest frame
+     * that is not released yet.
+     * Returns false on timeout and once the sender is closed and the ring is
+     * drained.
+     */
+    bool receive(ShmFrameView& view, long timeout_ms = -1) {
+        detail::ShmRingHeader& ring = region.header();
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t seen = ring.data_bell.load();
+            uint64_t head = ring.head.load(std::memory_order_acquire);
+            if (tail != head) {
+                auto* entry =
+                    reinterpret_cast<detail::ShmEntry*>(region.ring() + tail % ring.capacity);
+                if (entry->padding) {
+                    tail += entry->bytes;
+                    ring.tail.store(tail, std::memory_order_release);
+                    continue;
+                }
+                view.header = entry->header;
+                view.ans = reinterpret_cast<const twap_order*>(entry + 1);
+                view.pnls =
+                    reinterpret_cast<const pnl_and_pos*>(view.ans + entry->header.twap_count);
+                view.end = tail + entry->bytes;
+                return true;
+            }
+            if (ring.sender_closed.load()) return false;
+            if (timeout_ms == 0) return false;
+            detail::futexWait(ring.data_bell, seen, timeout_ms < 0 ? 100 : timeout_ms);
+            if (timeout_ms > 0) timeout_ms = 0;  // One wait, then a last check.
+        }
+    }
+
+    /* Gives the space of `view` (and all frames before it) back to the sender. */
+    void release(const ShmFrameView& view) {
+        detail::ShmRingHeader& ring = region.header();
+        ring.tail.store(view.end, std::memory_order_release);
+        ring.space_bell.fetch_add(1);
+        detail::futexWake(ring.space_bell);
+    }
+
+   private:
+    detail::ShmRegion region;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_SHM_TRANSPORT_H
@@ -0,0 +1,205 @@
+#ifndef UBI_TRADER_IO_STREAM_READER_H
+#define UBI_TRADER_IO_STREAM_READER_H
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace UBIEngine::IO {
+/**
+ * A queue over a binary file of packed records that is filled by a background
+ * I/O thread, so that the replay can start before the file is loaded.
+ *
+ * Two chunk buffers are used: while the consumer walks one chunk, the I/O
+ * thread `pread`s the next one into the other. Memory is bounded by two
+ * chunks whatever the size of the file.
+ *
+ * It has the same interface as VectorQueue. The reference returned by
+ * `front()` stays valid until the next call to `empty()` or `front()`
+ * after `pop()`, which is when the consumed chunk is handed back to the
+ * I/O thread.
+ */
+template <typename T>
+class StreamQueue {
+   public:
+    /**
+     * @param filePath the file to stream.
+     * @param chunk_records the number of records per chunk, require that it is positive.
+     */
+    explicit StreamQueue(const std::string& filePath, size_t chunk_records = 1 << 18)
+        : chunk_size(chunk_records) {
+        fd = open(filePath.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("Error opening file for reading: " + filePath);
+        }
+        struct stat sb;
+        if (fstat(fd, &sb) == -1) {
+            close(fd);
+            throw std::runtime_error("Error getting file status: " + filePath);
+        }
+        total = sb.st_size / sizeof(T);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        for (auto& buffer : buffers) buffer.resize(chunk_size);
+        startReader();
+    }
+
+    ~StreamQueue() {
+        stopReader();
+        close(fd);
+    }
+
+    StreamQueue(const StreamQueue&) = delete;
+    StreamQueue& operator=(const StreamQueue&) = delete;
+
+    bool empty() {
+        if (pos < end) return false;
+        return !refill();
+    }
+
+    const T& front() {
+        if (empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return *pos;
+    }
+
+    void pop() {
+        if (pos >= end) {
+            throw std::runtime_error("Queue is empty");
+        }
+        ++pos;
+    }
+
+    // 文件中的总记录数
+    size_t size() const { return total; }
+
+    // 从文件头重新开始读
+    void reset() {
+        stopReader();
+        startReader();
+    }
+
+   private:
+    struct Chunk {
+        int buffer;
+        size_t count;
+    };
+
+    /**
+     * Hands the consumed chunk back to the I/O thread and waits for the next one.
+     *
+     * @return false if the whole file has been consumed.
+     */
+    bool refill() {
+        std::unique_lock<std::mutex> lk(m);
+        if (current != -1) {
+            free_buffers.push_back(current);
+            current = -1;
+            c.notify_all();
+        }
+        if (consumed == total) return false;
+        c.wait(lk, [this] { return !ready.empty() || error; });
+        if (error) std::rethrow_exception(error);
+        Chunk chunk = ready.front();
+        ready.pop_front();
+        current = chunk.buffer;
+        consumed += chunk.count;
+        pos = buffers[current].data();
+        end = pos + chunk.count;
+        return true;
+    }
+
+    void readerThread() {
+        try {
+            for (size_t offset = 0; offset < total; offset += chunk_size) {
+                int buffer;
+                {
+                    std::unique_lock<std::mutex> lk(m);
+                    c.wait(lk, [this] { return !free_buffers.empty() || stopping; });
+                    if (stopping) return;
+                    buffer = free_buffers.front();
+                    free_buffers.pop_front();
+                }
+                size_t count = std::min(chunk_size, total - offset);
+                readFully(reinterpret_cast<char*>(buffers[buffer].data()), count * sizeof(T),
+                          offset * sizeof(T));
+                std::lock_guard<std::mutex> lk(m);
+                ready.push_back({buffer, count});
+                c.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(m);
+            error = std::current_exception();
+            c.notify_all();
+        }
+    }
+
+    void readFully(char* dst, size_t bytes, off_t offset) {
+        while (bytes > 0) {
+            ssize_t n = pread(fd, dst, bytes, offset);
+            if (n == -1 && errno == EINTR) continue;
+            if (n <= 0) {
+                throw std::runtime_error(std::string("Error reading file: ") +
+                                         (n == 0 ? "unexpected end of file" : strerror(errno)));
+            }
+            dst += n;
+            bytes -= n;
+            offset += n;
+        }
+    }
+
+    void startReader() {
+        free_buffers = {0, 1};
+        ready.clear();
+        current = -1;
+        consumed = 0;
+        pos = end = nullptr;
+        stopping = false;
+        error = nullptr;
+        reader = std::thread(&StreamQueue::readerThread, this);
+    }
+
+    void stopReader() {
+        {
+            std::lock_guard<std::mutex> lk(m);
+            stopping = true;
+            c.notify_all();
+        }
+        if (reader.joinable()) reader.join();
+    }
+
+    int fd = -1;
+    size_t chunk_size;
+    size_t total = 0;
+    // The records of the chunk that is being consumed.
+    const T* pos = nullptr;
+    const T* end = nullptr;
+
+    // The chunk buffers. A buffer is owned by the consumer (`current`), by the I/O
+    // thread, or sits in `free_buffers`/`ready`.
+    std::vector<T> buffers[2];
+
+    // The members below are guarded by `m`.
+    std::mutex m;
+    std::condition_variable c;
+    std::deque<int> free_buffers;
+    std::deque<Chunk> ready;
+    int current = -1;
+    size_t consumed = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread reader;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_STREAM_READER_H
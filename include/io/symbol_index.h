@@ -0,0 +1,150 @@
+#ifndef UBI_TRADER_IO_SYMBOL_INDEX_H
+#define UBI_TRADER_IO_SYMBOL_INDEX_H
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "io/order_event.h"
+#include "utils/robin_hood.h"
+
+namespace UBIEngine::IO {
+/**
+ * Maps instrument ids to symbol ids the way the replay does: the i-th
+ * prev_trade_info gets symbol id i. Instruments that are not in
+ * prev_trade_info get `unknown()`.
+ */
+class SymbolTable {
+   public:
+    template <typename PrevInfos>
+    explicit SymbolTable(const PrevInfos& prev_trade_infos) {
+        for (const auto& prev_info : prev_trade_infos) {
+            // The first occurrence wins, like SymbolManager.
+            ids.emplace(instrumentKey(prev_info.instrument_id), static_cast<uint32_t>(ids.size()));
+        }
+    }
+
+    /* The number of known symbols. */
+    uint32_t size() const { return static_cast<uint32_t>(ids.size()); }
+
+    /* The id of instruments that are not in prev_trade_info. */
+    uint32_t unknown() const { return size(); }
+
+    uint32_t symbolId(const char* instrument_id) const {
+        auto it = ids.find(instrumentKey(instrument_id));
+        return it == ids.end() ? unknown() : it->second;
+    }
+
+   private:
+    robin_hood::unordered_map<uint64_t, uint32_t> ids;
+};
+
+/**
+ * A symbol-partitioned index over time-ordered records (order_log or alpha):
+ * the positions of the records of each symbol, in time order, stored
+ * contiguously (a counting sort permutation).
+ *
+ * It is built in one parallel pass: every thread maps its chunk of records
+ * to symbol ids and counts them, the counts are prefix-summed per symbol and
+ * thread, and every thread scatters its positions. The permutation is stable,
+ * so each symbol's records keep the input order.
+ */
+class SymbolIndex {
+   public:
+    /**
+     * @param records a random access range of records with an `instrument_id`,
+     *                require that it has less than 2^32 records.
+     * @param symbols the symbol table of the date.
+     * @param thread_count the number of threads, require that it is positive.
+     */
+    template <typename Records>
+    SymbolIndex(const Records& records, const SymbolTable& symbols,
+                unsigned thread_count = std::max(1u, std::thread::hardware_concurrency()))
+        : symbol_count(symbols.size()) {
+        const size_t n = records.size();
+        if (n > UINT32_MAX) throw std::length_error("SymbolIndex supports up to 2^32 records");
+        const size_t buckets = symbol_count + 1;  // The last one holds unknown instruments.
+        thread_count = static_cast<unsigned>(
+            std::max<size_t>(1, std::min<size_t>(thread_count, n / kMinChunk + 1)));
+
+        symbol_of.resize(n);
+        positions.resize(n);
+        std::vector<std::vector<uint32_t>> counts(thread_count,
+                                                  std::vector<uint32_t>(buckets, 0));
+        auto chunkBegin = [&](unsigned t) { return n * t / thread_count; };
+
+        // Pass 1: map the records to symbols and count them per thread.
+        parallelFor(thread_count, [&](unsigned t) {
+            auto& count = counts[t];
+            for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i) {
+                uint32_t symbol = symbols.symbolId(records[i].instrument_id);
+                symbol_of[i] = symbol;
+                ++count[symbol];
+            }
+        });
+
+        // Exclusive prefix sum, symbol major and thread minor, so the scatter is stable.
+        offsets.resize(buckets + 1);
+        uint32_t offset = 0;
+        for (size_t s = 0; s < buckets; ++s) {
+            offsets[s] = offset;
+            for (unsigned t = 0; t < thread_count; ++t) {
+                uint32_t count = counts[t][s];
+                counts[t][s] = offset;
+                offset += count;
+            }
+        }
+        offsets[buckets] = offset;
+
+        // Pass 2: scatter the positions.
+        parallelFor(thread_count, [&](unsigned t) {
+            auto& next = counts[t];
+            for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i) {
+                positions[next[symbol_of[i]]++] = static_cast<uint32_t>(i);
+            }
+        });
+    }
+
+    /* The number of known symbols, `unknown()` is one past the last. */
+    uint32_t symbolCount() const { return symbol_count; }
+    uint32_t unknown() const { return symbol_count; }
+
+    /* The number of records of a symbol (or of unknown instruments). */
+    uint32_t count(uint32_t symbol_id) const {
+        return offsets[symbol_id + 1] - offsets[symbol_id];
+    }
+
+    /* The positions of a symbol's records, in input order. */
+    const uint32_t* begin(uint32_t symbol_id) const {
+        return positions.data() + offsets[symbol_id];
+    }
+    const uint32_t* end(uint32_t symbol_id) const {
+        return positions.data() + offsets[symbol_id + 1];
+    }
+
+    /* The symbol id of the record at a position. */
+    uint32_t symbolOf(size_t position) const { return symbol_of[position]; }
+
+    /* The symbol id of every record, in input order. */
+    const std::vector<uint32_t>& symbols() const { return symbol_of; }
+
+   private:
+    // Chunks smaller than this are not worth a thread.
+    static constexpr size_t kMinChunk = 1 << 16;
+
+    template <typename F>
+    static void parallelFor(unsigned thread_count, F&& body) {
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < thread_count; ++t) threads.emplace_back(body, t);
+        body(0u);
+        for (auto& thread : threads) thread.join();
+    }
+
+    uint32_t symbol_count;
+    std::vector<uint32_t> symbol_of;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> positions;
+};
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_SYMBOL_INDEX_H
@@ -0,0 +1,165 @@
+#ifndef UBI_TRADER_IO_SYNTHETIC_H
+#define UBI_TRADER_IO_SYNTHETIC_H
+#include <io/type.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace UBIEngine::IO {
+/**
+ * Parameters of a synthetic dataset. The same config and seed always produce
+ * the same files, so the output can be used to compare runs of the engine.
+ */
+struct SyntheticConfig {
+    // The number of instruments in prev_trade_info.
+    uint32_t symbol_count = 100;
+    // The number of rows in order_log.
+    uint64_t order_count = 1000000;
+    // The number of rows in alpha.
+    uint64_t alpha_count = 10000;
+    // Zipf exponent of the per-symbol activity, 0 means every symbol is equally active.
+    double symbol_skew = 0.0;
+    // Relative weights of order types 0..5 (LIMIT, CPBP, SBP, TOP5_IOC_CANCEL, IOC_CANCEL, FOK).
+    std::array<double, 6> type_mix = {0.80, 0.05, 0.05, 0.03, 0.04, 0.03};
+    // Share of orders whose unfilled part is cancelled (types 3, 4 and 5). The weights of
+    // these types are rescaled to match it, a negative value keeps `type_mix` as it is.
+    double cancel_ratio = -1.0;
+    // Standard deviation of the LIMIT order price offsets, in ticks (0.01).
+    double price_off_sigma = 5.0;
+    // LIMIT order price offsets are clamped to [-max_price_off, max_price_off] ticks.
+    int32_t max_price_off = 50;
+    // Order volumes are multiples of 100 in [100, 100 * max_lots].
+    int32_t max_lots = 10;
+    // Alpha target volumes are the previous position of the symbol plus a multiple of 100
+    // in [-100 * max_target_lots, 100 * max_target_lots].
+    int32_t max_target_lots = 50;
+    // Trading starts at 09:30:00.000 (milliseconds since midnight) and lasts `duration_ms`.
+    long start_timestamp = 34200000;
+    long duration_ms = 4 * 3600 * 1000;
+    uint64_t seed = 42;
+};
+
+/**
+ * Fills the instrument id of the i-th synthetic symbol, a 6-digit code padded with '\0'.
+ */
+inline void syntheticInstrumentId(uint32_t index, char (&instrument_id)[8]) {
+    std::memset(instrument_id, 0, sizeof(instrument_id));
+    std::snprintf(instrument_id, sizeof(instrument_id), "%06u", 600000 + index % 400000);
+}
+
+/**
+ * Writes `order_log`, `alpha` and `prev_trade_info` into `dir_path` (which must exist).
+ * Rows are generated and written one by one, memory does not grow with the dataset.
+ */
+inline void writeSyntheticDataset(const std::string& dir_path, const SyntheticConfig& config) {
+    if (config.symbol_count == 0) {
+        throw std::invalid_argument("Synthetic dataset requires at least one symbol");
+    }
+    std::mt19937_64 rng(config.seed);
+
+    // TWAP sells that are still resting in the book are not subtracted from the position
+    // when the next alpha arrives, so the holdings start far above the total alpha swing
+    // to make sure the strategy never sells more than it has.
+    const int64_t max_swing = 200ll * std::max(config.max_target_lots, 0);
+    const int64_t base_position =
+        std::min<int64_t>(1000000000, max_swing * config.alpha_count + 1000000);
+
+    std::vector<prev_trade_info> prev_infos(config.symbol_count);
+    {
+        std::uniform_int_distribution<int> price_cents(500, 10000);
+        std::uniform_int_distribution<int> position_lots(0, 100);
+        for (uint32_t i = 0; i < config.symbol_count; ++i) {
+            syntheticInstrumentId(i, prev_infos[i].instrument_id);
+            prev_infos[i].prev_close_price = price_cents(rng) / 100.0;
+            prev_infos[i].prev_position = static_cast<int>(base_position + position_lots(rng) * 100);
+        }
+        std::ofstream file(dir_path + "/prev_trade_info", std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Error opening file for writing: " + dir_path);
+        }
+        file.write(reinterpret_cast<const char*>(prev_infos.data()),
+                   prev_infos.size() * sizeof(prev_trade_info));
+    }
+
+    std::vector<double> symbol_weights(config.symbol_count);
+    for (uint32_t i = 0; i < config.symbol_count; ++i) {
+        symbol_weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), config.symbol_skew);
+    }
+    // Shuffle so that the most active symbols are not always the first ones.
+    std::shuffle(symbol_weights.begin(), symbol_weights.end(), rng);
+    std::discrete_distribution<uint32_t> symbol_dist(symbol_weights.begin(),
+                                                     symbol_weights.end());
+
+    std::array<double, 6> type_mix = config.type_mix;
+    if (config.cancel_ratio >= 0) {
+        double keep = type_mix[0] + type_mix[1] + type_mix[2];
+        double cancel = type_mix[3] + type_mix[4] + type_mix[5];
+        double ratio = std::min(config.cancel_ratio, 1.0);
+        for (int t = 0; t < 3; ++t) {
+            type_mix[t] = keep > 0 ? type_mix[t] / keep * (1 - ratio) : (1 - ratio) / 3;
+        }
+        for (int t = 3; t < 6; ++t) {
+            type_mix[t] = cancel > 0 ? type_mix[t] / cancel * ratio : ratio / 3;
+        }
+    }
+    std::discrete_distribution<int> type_dist(type_mix.begin(), type_mix.end());
+    std::normal_distribution<double> price_off_dist(0.0, config.price_off_sigma);
+    std::uniform_int_distribution<int> lots_dist(1, std::max(config.max_lots, 1));
+    std::bernoulli_distribution bid_dist(0.5);
+
+    // Both files are time-ordered, arrivals are spread uniformly over the trading period.
+    auto timestamp_at = [&config](uint64_t index, uint64_t count) {
+        return config.start_timestamp +
+               static_cast<long>(static_cast<double>(index) * config.duration_ms / count);
+    };
+
+    {
+        std::ofstream file(dir_path + "/order_log", std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Error opening file for writing: " + dir_path);
+        }
+        for (uint64_t i = 0; i < config.order_count; ++i) {
+            order_log row;
+            std::memcpy(row.instrument_id, prev_infos[symbol_dist(rng)].instrument_id,
+                        sizeof(row.instrument_id));
+            row.timestamp = timestamp_at(i, config.order_count);
+            row.type = type_dist(rng);
+            row.direction = bid_dist(rng) ? 1 : -1;
+            row.volume = lots_dist(rng) * 100;
+            row.price_off = 0;
+            if (row.type == 0) {
+                auto ticks = static_cast<int32_t>(std::lround(price_off_dist(rng)));
+                ticks = std::clamp(ticks, -config.max_price_off, config.max_price_off);
+                row.price_off = ticks / 100.0;
+            }
+            file.write(reinterpret_cast<const char*>(&row), sizeof(row));
+        }
+    }
+
+    {
+        std::ofstream file(dir_path + "/alpha", std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Error opening file for writing: " + dir_path);
+        }
+        const int32_t max_target_lots = std::max(config.max_target_lots, 0);
+        std::uniform_int_distribution<int> target_dist(-max_target_lots, max_target_lots);
+        for (uint64_t i = 0; i < config.alpha_count; ++i) {
+            alpha row;
+            const auto& prev_info = prev_infos[symbol_dist(rng)];
+            std::memcpy(row.instrument_id, prev_info.instrument_id, sizeof(row.instrument_id));
+            row.timestamp = timestamp_at(i, config.alpha_count);
+            row.target_volume = prev_info.prev_position + target_dist(rng) * 100;
+            file.write(reinterpret_cast<const char*>(&row), sizeof(row));
+        }
+    }
+}
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_SYNTHETIC_H
@@ -0,0 +1,267 @@
+#ifndef UBI_TRADER_IO_TRANSPORT_H
+#define UBI_TRADER_IO_TRANSPORT_H
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "utils/cpu.h"
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
+namespace UBIEngine::IO {
+/**
+ * How a Transport waits for the network:
+ *
+ * - Epoll: sleeps in epoll_wait() until the interrupt-driven stack has data,
+ *   costs no CPU while idle.
+ * - BusyPoll: spins on a non-blocking recv() and asks the kernel to poll the
+ *   device queue from the syscall (SO_BUSY_POLL), so neither the interrupt
+ *   nor the wakeup is on the path. Burns a core, best on a pinned thread.
+ * - UserSpace: reserved for a kernel-bypass stack (DPDK, OpenOnload, ...),
+ *   not part of this build.
+ */
+enum class TransportKind { Epoll, BusyPoll, UserSpace };
+
+/* Options of makeTransport(). */
+struct TransportOptions {
+    TransportKind kind = TransportKind::Epoll;
+    // BusyPoll: the microseconds a recv() polls the device, raising it above
+    // net.core.busy_read needs CAP_NET_ADMIN. Without it the spin still avoids the wakeup.
+    int busy_poll_us = 50;
+    // BusyPoll: pin the thread that first sends or receives to this CPU, -1 leaves it alone.
+    int cpu = -1;
+};
+
+/**
+ * A connected byte stream for one I/O thread. The interface is what a
+ * kernel-bypass stack can offer as well, so callers do not depend on fds.
+ */
+class Transport {
+   public:
+    virtual ~Transport() = default;
+
+    /* Sends all `size` bytes. Throws on errors. */
+    virtual void send(const void* data, size_t size) = 0;
+
+    /**
+     * Receives up to `size` bytes, waits until at least one is there. Returns
+     * 0 once the peer closed the connection, throws on errors.
+     */
+    virtual size_t receive(void* data, size_t size) = 0;
+
+    /* Receives exactly `size` bytes. Returns false on end of stream before the first byte. */
+    bool receiveFully(void* data, size_t size) {
+        char* p = static_cast<char*>(data);
+        size_t received = 0;
+        while (received < size) {
+            size_t n = receive(p + received, size - received);
+            if (n == 0) {
+                if (received == 0) return false;
+                throw std::runtime_error("Connection closed in the middle of a message");
+            }
+            received += n;
+        }
+        return true;
+    }
+
+    virtual const char* name() const = 0;
+};
+
+namespace detail {
+/* Owns a connected, non-blocking TCP socket with Nagle disabled. */
+class SocketTransport : public Transport {
+   public:
+    explicit SocketTransport(int fd_) : fd(fd_) {
+        int flags = fcntl(fd, F_GETFL);
+        if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+            close(fd);
+            throw std::runtime_error(std::string("fcntl failed: ") + strerror(errno));
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    SocketTransport(const SocketTransport&) = delete;
+    SocketTransport& operator=(const SocketTransport&) = delete;
+
+    ~SocketTransport() override { close(fd); }
+
+    void send(const void* data, size_t size) override {
+        const char* p = static_cast<const char*>(data);
+        while (size != 0) {
+            ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    throw std::runtime_error(std::string("Error sending: ") + strerror(errno));
+                waitWritable();
+                continue;
+            }
+            p += n;
+            size -= n;
+        }
+    }
+
+    size_t receive(void* data, size_t size) override {
+        while (true) {
+            ssize_t n = recv(fd, data, size, 0);
+            if (n >= 0) return static_cast<size_t>(n);
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                throw std::runtime_error(std::string("Error receiving: ") + strerror(errno));
+            waitReadable();
+        }
+    }
+
+   protected:
+    virtual void waitReadable() = 0;
+    virtual void waitWritable() = 0;
+
+    int fd;
+};
+
+class EpollTransport : public SocketTransport {
+   public:
+    explicit EpollTransport(int fd_) : SocketTransport(fd_) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd == -1)
+            throw std::runtime_error(std::string("epoll_create1 failed: ") + strerror(errno));
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            close(epoll_fd);
+            throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+        }
+    }
+
+    ~EpollTransport() override { close(epoll_fd); }
+
+    const char* name() const override { return "epoll"; }
+
+   protected:
+    void waitReadable() override { wait(EPOLLIN); }
+    void waitWritable() override { wait(EPOLLOUT); }
+
+   private:
+    void wait(uint32_t events) {
+        if (events != watched) {
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = fd;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == -1)
+                throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+            watched = events;
+        }
+        epoll_event event;
+        // Errors and hangups are reported as readiness, the next call sees them.
+        while (epoll_wait(epoll_fd, &event, 1, -1) == -1) {
+            if (errno != EINTR)
+                throw std::runtime_error(std::string("epoll_wait failed: ") + strerror(errno));
+        }
+    }
+
+    int epoll_fd = -1;
+    uint32_t watched = EPOLLIN;
+};
+
+class BusyPollTransport : public SocketTransport {
+   public:
+    BusyPollTransport(int fd_, const TransportOptions& options)
+        : SocketTransport(fd_), cpu(options.cpu) {
+        int usec = options.busy_poll_us;
+        busy_poll = setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) == 0;
+    }
+
+    const char* name() const override { return busy_poll ? "busy-poll" : "busy-poll (spin only)"; }
+
+    void send(const void* data, size_t size) override {
+        pin();
+        SocketTransport::send(data, size);
+    }
+
+    size_t receive(void* data, size_t size) override {
+        pin();
+        return SocketTransport::receive(data, size);
+    }
+
+   protected:
+    void waitReadable() override { Utils::cpuRelax(); }
+    void waitWritable() override { Utils::cpuRelax(); }
+
+   private:
+    void pin() {
+        if (pinned) return;
+        pinned = true;
+        if (cpu >= 0) Utils::pinCurrentThread(cpu);
+    }
+
+    int cpu;
+    bool busy_poll;
+    bool pinned = false;
+};
+}  // namespace detail
+
+/**
+ * Wraps the connected TCP socket `fd`, which the transport owns from now on
+ * (it is closed if this throws).
+ */
+inline std::unique_ptr<Transport> makeTransport(
+    int fd, const TransportOptions& options = TransportOptions()) {
+    switch (options.kind) {
+        case TransportKind::Epoll: return std::make_unique<detail::EpollTransport>(fd);
+        case TransportKind::BusyPoll:
+            return std::make_unique<detail::BusyPollTransport>(fd, options);
+        case TransportKind::UserSpace:
+            // A user-space stack cannot adopt a kernel socket: it would open its own connection
+            // in a connectTransport() of its own and implement Transport on its queues.
+            break;
+    }
+    close(fd);
+    throw std::runtime_error("No user-space network stack in this build");
+}
+
+/* Connects to `host:port` over TCP. */
+inline std::unique_ptr<Transport> connectTransport(
+    const std::string& host, uint16_t port, const TransportOptions& options = TransportOptions()) {
+    if (options.kind == TransportKind::UserSpace)
+        throw std::runtime_error("No user-space network stack in this build");
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) throw std::runtime_error("创建 socket 失败！");
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        close(fd);
+        throw std::invalid_argument("Bad IPv4 address: " + host);
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        close(fd);
+        throw std::runtime_error(std::string("Connect failed: ") + strerror(errno));
+    }
+    return makeTransport(fd, options);
+}
+
+/* Parses "epoll", "busy-poll" or "user-space". */
+inline TransportKind parseTransportKind(const std::string& name) {
+    if (name == "epoll") return TransportKind::Epoll;
+    if (name == "busy-poll") return TransportKind::BusyPoll;
+    if (name == "user-space") return TransportKind::UserSpace;
+    throw std::invalid_argument("Unknown transport: " + name);
+}
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_TRANSPORT_H
@@ -1,5 +1,6 @@
 #ifndef UBI_TRADER_IO_TYPE_H
 #define UBI_TRADER_IO_TYPE_H
+#include <stdexcept>
 #include <vector>
 
 namespace UBIEngine::IO {
@@ -38,20 +39,28 @@ struct pnl_and_pos {
     double pnl;
 } __attribute__((packed));
 
-template <typename T>
+/**
+ * A queue over records that are already in memory. `Container` is a
+ * `std::vector<T>` or a read-only view such as `RecordFile<T>`, which lets
+ * the replay consume a mapped file directly.
+ */
+template <typename T, typename Container = std::vector<T>>
 class VectorQueue {
    public:
-    std::vector<T> data;
+    Container data;
     size_t frontIndex = 0;  // 这是队列的“头部”
 
-    // 使用已存在的vector来构造
-    VectorQueue(std::vector<T>&& vec) : data(std::move(vec)) {}
+    // 使用已存在的vector（或 RecordFile）来构造
+    VectorQueue(Container&& vec) : data(std::move(vec)) {}
 
     // 判断队列是否为空
     bool empty() const { return frontIndex >= data.size(); }
 
-    // 获取队列的头部元素
-    T& front() {
+    // 队列中的总元素个数（包括已经出队的部分）
+    size_t size() const { return data.size(); }
+
+    // 获取队列的头部元素（RecordFile 上为只读引用）
+    auto& front() {
         if (empty()) {
             throw std::runtime_error("Queue is empty");
         }
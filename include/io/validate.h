@@ -0,0 +1,270 @@
+#ifndef UBI_TRADER_IO_VALIDATE_H
+#define UBI_TRADER_IO_VALIDATE_H
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "io/symbol_index.h"
+#include "io/type.h"
+
+namespace UBIEngine::IO {
+/**
+ * Why a record is rejected. Only the first failed check of a record is counted.
+ */
+enum class RejectReason : uint8_t {
+    TimestampBackwards = 0,  // Earlier than the last accepted record, or a spike.
+    UnknownType = 1,         // order_log type outside 0..5, would replay as LIMIT.
+    BadDirection = 2,        // order_log direction other than 1 and -1.
+    NonPositiveVolume = 3,   // order_log volume <= 0.
+    UnknownSymbol = 4,       // Instrument missing from prev_trade_info.
+    Count = 5
+};
+
+inline const char* rejectReasonName(RejectReason reason) {
+    switch (reason) {
+        case RejectReason::TimestampBackwards: return "timestamp backwards";
+        case RejectReason::UnknownType: return "unknown type";
+        case RejectReason::BadDirection: return "bad direction";
+        case RejectReason::NonPositiveVolume: return "non-positive volume";
+        case RejectReason::UnknownSymbol: return "unknown symbol";
+        default: return "unknown";
+    }
+}
+
+/* One bit per record, set if the record is rejected. */
+class RejectBitmap {
+   public:
+    RejectBitmap() = default;
+    explicit RejectBitmap(size_t size_) : words((size_ + 63) / 64, 0), length(size_) {}
+
+    bool rejected(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    void reject(size_t i) { words[i >> 6] |= uint64_t{1} << (i & 63); }
+    void flip(size_t i) { words[i >> 6] ^= uint64_t{1} << (i & 63); }
+
+    /* The rejects of records [64 * w, 64 * w + 64), to skip clean words at once. */
+    uint64_t word(size_t w) const { return words[w]; }
+
+    size_t size() const { return length; }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t w : words) total += __builtin_popcountll(w);
+        return total;
+    }
+
+   private:
+    std::vector<uint64_t> words;
+    size_t length = 0;
+};
+
+/* What a validation pass found. */
+struct ValidationReport {
+    uint64_t checked = 0;
+    uint64_t rejected = 0;
+    std::array<uint64_t, static_cast<size_t>(RejectReason::Count)> by_reason{};
+
+    /* e.g. "2 of 1000 rejected (unknown type: 1, unknown symbol: 1)". */
+    std::string summary() const {
+        std::string text = std::to_string(rejected) + " of " + std::to_string(checked) +
+                           " rejected";
+        std::string reasons;
+        for (size_t r = 0; r < by_reason.size(); ++r) {
+            if (by_reason[r] == 0) continue;
+            if (!reasons.empty()) reasons += ", ";
+            reasons += std::string(rejectReasonName(static_cast<RejectReason>(r))) + ": " +
+                       std::to_string(by_reason[r]);
+        }
+        return reasons.empty() ? text : text + " (" + reasons + ")";
+    }
+};
+
+namespace detail {
+inline bool rejectOrder(const order_log& row, const SymbolTable& symbols, RejectReason& reason) {
+    if (row.type < 0 || row.type > 5) {
+        reason = RejectReason::UnknownType;
+    } else if (row.direction != 1 && row.direction != -1) {
+        reason = RejectReason::BadDirection;
+    } else if (row.volume <= 0) {
+        reason = RejectReason::NonPositiveVolume;
+    } else if (symbols.symbolId(row.instrument_id) == symbols.unknown()) {
+        reason = RejectReason::UnknownSymbol;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline bool rejectAlpha(const alpha& row, const SymbolTable& symbols, RejectReason& reason) {
+    if (symbols.symbolId(row.instrument_id) == symbols.unknown()) {
+        reason = RejectReason::UnknownSymbol;
+        return true;
+    }
+    return false;
+}
+
+// The timestamp of the last accepted record before the first one.
+constexpr long kNoTimestamp = std::numeric_limits<long>::min();
+
+/**
+ * Decides record `i` given `last`, the timestamp of the last accepted record,
+ * which is updated if the record is accepted. The accepted records never go
+ * backwards:
+ *
+ * - a record earlier than `last` is rejected;
+ * - a record ahead of the next one, when the next one is not earlier than
+ *   `last`, is a spike and rejected, so it does not reject the records after it
+ *   (10, 99, 11, 12 keeps 10, 11, 12);
+ * - otherwise `check(row, reason)` decides.
+ */
+template <typename Records, typename Check>
+bool rejectRecord(const Records& records, size_t i, long& last, Check& check,
+                  RejectReason& reason) {
+    long timestamp = records[i].timestamp;
+    if (timestamp < last) {
+        reason = RejectReason::TimestampBackwards;
+        return true;
+    }
+    if (i + 1 < records.size()) {
+        long next = records[i + 1].timestamp;
+        if (next < timestamp && next >= last) {
+            reason = RejectReason::TimestampBackwards;
+            return true;
+        }
+    }
+    if (check(records[i], reason)) return true;
+    last = timestamp;
+    return false;
+}
+
+/**
+ * Runs `check(row, reason)` over the records in parallel. Threads own whole
+ * 64-record words of the bitmap, so they never write the same word.
+ *
+ * Whether a record is accepted depends on the last accepted timestamp, so a
+ * chunk is first validated as if the record before it was accepted. Then, in
+ * order, each chunk whose guess was wrong is validated again from its start
+ * with the real timestamp, until both runs accept the same record: from there
+ * on they decide alike. Clean inputs never redo a record.
+ */
+template <typename Records, typename Check>
+RejectBitmap validate(const Records& records, unsigned thread_count, ValidationReport* report,
+                      Check check) {
+    const size_t n = records.size();
+    RejectBitmap rejects(n);
+    const size_t word_count = (n + 63) / 64;
+    // Chunks smaller than this are not worth a thread.
+    constexpr size_t kMinWords = 1 << 10;
+    thread_count = static_cast<unsigned>(
+        std::max<size_t>(1, std::min<size_t>(thread_count, word_count / kMinWords + 1)));
+    std::vector<ValidationReport> reports(thread_count);
+    // The last accepted timestamp guessed before each chunk and found after it.
+    std::vector<long> guessed(thread_count), found(thread_count);
+    auto chunkBegin = [&](unsigned t) { return std::min(n, word_count * t / thread_count * 64); };
+
+    auto body = [&](unsigned t) {
+        size_t begin = chunkBegin(t);
+        size_t end = chunkBegin(t + 1);
+        ValidationReport& local = reports[t];
+        long last = guessed[t] = begin == 0 ? kNoTimestamp : records[begin - 1].timestamp;
+        for (size_t i = begin; i < end; ++i) {
+            RejectReason reason;
+            if (rejectRecord(records, i, last, check, reason)) {
+                rejects.reject(i);
+                ++local.by_reason[static_cast<size_t>(reason)];
+                ++local.rejected;
+            }
+        }
+        local.checked = end - begin;
+        found[t] = last;
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < thread_count; ++t) threads.emplace_back(body, t);
+    body(0);
+    for (auto& thread : threads) thread.join();
+
+    for (unsigned t = 1; t < thread_count; ++t) {
+        long last = found[t - 1];
+        if (last == guessed[t]) continue;
+        ValidationReport& local = reports[t];
+        long guess = guessed[t];
+        size_t end = chunkBegin(t + 1);
+        for (size_t i = chunkBegin(t); i < end && last != guess; ++i) {
+            RejectReason reason, guessed_reason;
+            bool rejected = rejectRecord(records, i, last, check, reason);
+            bool guessed_rejected = rejectRecord(records, i, guess, check, guessed_reason);
+            if (guessed_rejected) {
+                --local.by_reason[static_cast<size_t>(guessed_reason)];
+                --local.rejected;
+            }
+            if (rejected) {
+                ++local.by_reason[static_cast<size_t>(reason)];
+                ++local.rejected;
+            }
+            if (rejected != guessed_rejected) rejects.flip(i);
+        }
+        // Unchanged if the runs met, else the chunk ended before they did.
+        if (last != guess) found[t] = last;
+    }
+
+    if (report != nullptr) {
+        *report = ValidationReport();
+        for (const auto& local : reports) {
+            report->checked += local.checked;
+            report->rejected += local.rejected;
+            for (size_t r = 0; r < local.by_reason.size(); ++r)
+                report->by_reason[r] += local.by_reason[r];
+        }
+    }
+    return rejects;
+}
+}  // namespace detail
+
+/**
+ * Validates order_log records before the replay: non-decreasing timestamps,
+ * known types and directions, positive volumes and symbols that are in
+ * prev_trade_info. The replay can then skip the rejected rows instead of
+ * discovering them one field at a time.
+ *
+ * @param records a random access range of order_log.
+ * @param symbols the symbol table of the date.
+ * @param report if not null, receives the counts by reason.
+ * @param thread_count the number of threads, require that it is positive.
+ * @return the rejected rows.
+ */
+template <typename Records>
+RejectBitmap validateOrders(
+    const Records& records, const SymbolTable& symbols, ValidationReport* report = nullptr,
+    unsigned thread_count = std::max(1u, std::thread::hardware_concurrency())) {
+    auto check = [&](const order_log& row, RejectReason& reason) {
+        return detail::rejectOrder(row, symbols, reason);
+    };
+    return detail::validate(records, thread_count, report, check);
+}
+
+/* Validates alpha records: non-decreasing timestamps and symbols in prev_trade_info. */
+template <typename Records>
+RejectBitmap validateAlphas(
+    const Records& records, const SymbolTable& symbols, ValidationReport* report = nullptr,
+    unsigned thread_count = std::max(1u, std::thread::hardware_concurrency())) {
+    auto check = [&](const alpha& row, RejectReason& reason) {
+        return detail::rejectAlpha(row, symbols, reason);
+    };
+    return detail::validate(records, thread_count, report, check);
+}
+
+/* Copies the records that are not rejected, for small inputs such as alpha. */
+template <typename T, typename Records>
+std::vector<T> acceptedRecords(const Records& records, const RejectBitmap& rejects) {
+    std::vector<T> accepted;
+    accepted.reserve(records.size() - rejects.count());
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (!rejects.rejected(i)) accepted.push_back(records[i]);
+    }
+    return accepted;
+}
+}  // namespace UBIEngine::IO
+#endif  // UBI_TRADER_IO_VALIDATE_H
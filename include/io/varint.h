@@ -0,0 +1,38 @@
+#ifndef UBI_TRADER_IO_VARINT_H
+#define UBI_TRADER_IO_VARINT_H
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace UBIEngine::IO::detail {
+/* Maps 0, -1, 1, -2, ... to 0, 1, 2, 3, ..., so small magnitudes stay small. */
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/* Appends `value` as a LEB128 varint: 7 bits per byte, the high bit set on all but the last. */
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+/* Reads a varint at `p`, which must end before `end`. Throws on truncated or too long input. */
+inline uint64_t getVarint(const uint8_t*& p, const uint8_t* end) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (p == end) throw std::runtime_error("Truncated varint");
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return value;
+    }
+    throw std::runtime_error("Varint too long");
+}
+}  // namespace UBIEngine::IO::detail
+#endif  // UBI_TRADER_IO_VARINT_H
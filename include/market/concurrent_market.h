@@ -1,10 +1,15 @@
 #ifndef UBI_TRADER_CONCURRENT_MARKET_H
 #define UBI_TRADER_CONCURRENT_MARKET_H
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <thread>
 #include "robin_hood.h"
-#include "thread_pool.h"
+#include "spsc_queue.h"
+#include "thread_joiner.h"
+#include "market_command.h"
 #include "order.h"
 #include "orderbook.h"
 #include "symbol.h"
@@ -15,6 +20,9 @@ namespace UBIEngine {
 using namespace Concurrent;
 class OrderBookHandler;
 
+// The expected (or measured) load of each symbol ID, in any unit.
+using SymbolLoads = robin_hood::unordered_map<uint32_t, uint64_t>;
+
 class ConcurrentMarket
 {
 public:
@@ -29,6 +37,11 @@ public:
      */
     explicit ConcurrentMarket(uint8_t num_threads = 1);
 
+    /**
+     * Lets the worker threads apply the commands submitted so far, then stops them.
+     */
+    ~ConcurrentMarket();
+
     /**
      * Adds a new symbol to market asynchronously.
      *
@@ -84,20 +97,88 @@ public:
      */
     void executeOrder(uint32_t symbol_id, uint64_t order_id, uint64_t quantity);
 
+    /*
+     * The queries below read the snapshot that the worker thread of the symbol
+     * published after the last command it applied, so they neither wait for the
+     * worker nor race with it. Commands still in its ring are not reflected,
+     * call sync() first to see all of them.
+     */
+
+    /**
+     * @param symbol_id the symbol ID, require that the symbol exists.
+     * @return the prices and the account of the symbol as of one applied command.
+     */
+    [[nodiscard]] SymbolSnapshot snapshot(uint32_t symbol_id) const;
+
     /**
      * @param symbol_id the symbol ID to get base price for.
      * @param side the side to get base price for.
      * @return the base price for the symbol ID and side.
      */
-    const uint64_t getBasePrice(uint32_t symbol_id, OrderSide side);
+    const uint64_t getBasePrice(uint32_t symbol_id, OrderSide side) const;
+
+    const uint64_t getUpLimit(uint32_t symbol_id, OrderSide side) const;
+
+    const uint64_t getDownLimit(uint32_t symbol_id, OrderSide side) const;
+
+    // A copy, the worker thread keeps changing its own.
+    PnlHelper getPnlHelper(uint32_t symbol_id) const;
 
-    const uint64_t getUpLimit(uint32_t symbol_id, OrderSide side);
+    const int64_t calculatePnl(uint32_t symbol_id) const;
+
+    /**
+     * Waits until the worker threads have applied every command submitted so far.
+     */
+    void sync() const;
+
+    /*
+     * A symbol stays on the worker thread it was added to, so its commands are
+     * applied in the order they were submitted. Without a plan the symbols are
+     * dealt out round robin, which can put the few busy ones on one worker;
+     * placeSymbols() spreads them by their load instead.
+     */
+
+    /**
+     * Plans the workers of the symbols that are added from now on, see
+     * packSymbols(). Symbols in the market keep their workers, unplanned ones
+     * are still dealt out round robin.
+     *
+     * @param loads the expected load of each symbol, e.g. its number of events in
+     *              order_log (see engine/symbol_loads.h) or measuredLoads() of the
+     *              previous session.
+     */
+    void placeSymbols(const SymbolLoads &loads);
+
+    /**
+     * Greedy bin packing, longest processing time first: each symbol, heaviest
+     * first, goes to the least loaded worker so far. The busiest worker gets at
+     * most 4/3 of the optimal load. Ties go to the lower symbol ID and worker, so
+     * the plan does not depend on the order of `loads`.
+     *
+     * @return the worker of each symbol of `loads`.
+     */
+    static robin_hood::unordered_map<uint32_t, uint32_t> packSymbols(
+        const SymbolLoads &loads, uint32_t num_workers);
 
-    const uint64_t getDownLimit(uint32_t symbol_id, OrderSide side);
+    /**
+     * @param symbol_id the symbol ID, require that the symbol exists.
+     * @return the index of the worker thread that applies the commands of the symbol.
+     */
+    [[nodiscard]] uint32_t getWorker(uint32_t symbol_id) const;
 
-    const PnlHelper& getPnlHelper(uint32_t symbol_id) const ;
+    /**
+     * @return the nanoseconds each worker thread has spent applying commands.
+     */
+    [[nodiscard]] std::vector<uint64_t> busyNanoseconds() const;
 
-    const int64_t calculatePnl(uint32_t symbol_id) const ;
+    /**
+     * Splits the busy time of each worker over its symbols by their numbers of
+     * commands. Call sync() first, then pass the loads to placeSymbols() of the
+     * market of the next session.
+     *
+     * @return the estimated nanoseconds of each symbol in the market.
+     */
+    [[nodiscard]] SymbolLoads measuredLoads() const;
 
     /**
      * @return the string representation of the market.
@@ -115,37 +196,101 @@ public:
     friend std::ostream &operator<<(std::ostream &os, ConcurrentMarket &concurrent_market);
 
 private:
+    // The worker of a symbol and the number of commands submitted for it.
+    struct SymbolRoute
+    {
+        uint32_t submission_index;
+        uint64_t commands;
+    };
+
     /**
-     * Gets the index that that corresponds to the queue in the thread pool
-     * that the new task should be submitted to as well the index of the orderbook
-     * handler that the task should use.
+     * Gets the index that that corresponds to the command ring that the next
+     * command of the symbol should be submitted to as well the index of the
+     * orderbook handler that the command will use, and counts the command.
      *
      * @param symbol_id the symbol ID to get the submission index for
      * @return the submission index associated with the symbol ID.
      */
-    uint32_t getSubmissionIndex(uint32_t symbol_id);
+    uint32_t route(uint32_t symbol_id);
 
-    const uint32_t getSubmissionIndex(uint32_t symbol_id) const;
+    /**
+     * Writes a command straight into the ring of a worker thread, waits while the ring is full.
+     *
+     * @param submission_index the worker thread that applies the command.
+     * @param fill sets the fields of the command after `type` and `symbol_id`.
+     */
+    template<typename Fill>
+    void submit(uint32_t submission_index, MarketCommandType type, uint32_t symbol_id, Fill &&fill)
+    {
+        command_queues[submission_index]->pushWith([&](MarketCommand &command) {
+            command.type = type;
+            command.symbol_id = symbol_id;
+            fill(command);
+        });
+    }
+
+    /**
+     * Applies the commands of a worker's ring to its orderbook handler.
+     *
+     * @param submission_index the index of the ring and the orderbook handler.
+     */
+    void workerThread(uint32_t submission_index);
+
+    const SymbolSnapshotSlot &getSnapshotSlot(uint32_t symbol_id) const;
+
+    /**
+     * @return the planned worker of the symbol, else the next one round robin.
+     */
+    uint32_t newSymbolSubmissionIndex(uint32_t symbol_id);
 
     /**
      * Increments the symbol submission index modulo the number of orderbook handlers.
      */
     void updateSymbolSubmissionIndex();
 
-    // The number of orderbook handlers is equivalent to the number of worker threads in the thread pool.
+    // The number of orderbook handlers is equivalent to the number of worker threads.
     std::vector<std::unique_ptr<OrderBookHandler>> orderbook_handlers;
     // Maps symbol IDs to symbols.
     robin_hood::unordered_map<uint32_t, std::unique_ptr<Symbol>> id_to_symbol;
     // Maps symbol IDs to the submission indices. A submission index
-    // corresponds to the thread pool queue that a task (that is associated with the symbol ID)
+    // corresponds to the command ring that a command (that is associated with the symbol ID)
     // should be submitted to. Additionally, the submission index corresponds to the orderbook
     // handler that is associated with the symbol ID.
-    robin_hood::unordered_map<uint32_t, uint32_t> id_to_submission_index;
-    // The thread pool that order operations will be submitted to.
-    ThreadPool thread_pool;
-    // The index of the thread pool queue and orderbook handler that will be associated
-    // with a newly added symbol.
+    robin_hood::unordered_map<uint32_t, SymbolRoute> id_to_route;
+    // The index of the command ring and orderbook handler that will be associated
+    // with a newly added symbol that has no planned worker.
     uint32_t symbol_submission_index;
+    // The workers planned by placeSymbols() for symbols not added yet.
+    robin_hood::unordered_map<uint32_t, uint32_t> planned_submission_index;
+    // The commands submitted to each worker, including the ones of deleted symbols.
+    std::vector<uint64_t> worker_commands;
+    // The snapshot each worker thread publishes for a symbol, see `snapshot()`.
+    robin_hood::unordered_map<uint32_t, std::unique_ptr<SymbolSnapshotSlot>> id_to_snapshot;
+    // The snapshots of deleted symbols, their workers may still write them.
+    std::vector<std::unique_ptr<SymbolSnapshotSlot>> retired_snapshots;
+
+    // IMPORTANT: The running flag and the command rings must be declared before the
+    // worker threads, so they outlive the threads (see ThreadPool).
+
+    // The most commands a worker takes from its ring at once.
+    static constexpr size_t kCommandBatch = 64;
+    // The commands in flight per worker, submitting waits beyond it.
+    static constexpr size_t kCommandCapacity = 1 << 14;
+    // Indicates whether the worker threads are running.
+    std::atomic_bool running;
+    // The command ring of each worker thread. Only the thread calling the market writes to
+    // them, so each one is a lock-free SPSC ring.
+    std::vector<std::unique_ptr<SpscQueue<MarketCommand>>> command_queues;
+    // Written by one worker each, on its own cache line.
+    struct alignas(64) WorkerStats
+    {
+        std::atomic<uint64_t> busy_ns{0};
+    };
+    std::unique_ptr<WorkerStats[]> worker_stats;
+    // The worker threads, one per orderbook handler.
+    std::vector<std::thread> workers;
+    // Joins the worker threads when the market is destroyed.
+    ThreadJoiner worker_joiner;
 };
 } // namespace UBIEngine
 #endif // UBI_TRADER_CONCURRENT_MARKET_H
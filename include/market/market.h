@@ -34,11 +34,15 @@ struct OrderBookHandler
 
     std::unique_ptr<MapOrderBook> &getOrderBook(uint32_t symbol_id);
 
+    void setListener(BookListener *listener_);
+
     std::string toString();
 
 private:
     // Maps symbol IDs to order books.
     robin_hood::unordered_map<uint32_t, std::unique_ptr<MapOrderBook>> id_to_book;
+    // Set on every book, including the ones added later.
+    BookListener *listener = nullptr;
 };
 
 class Market
@@ -96,6 +100,28 @@ public:
      */
     void deleteOrder(uint32_t symbol_id, uint64_t order_id);
 
+    /**
+     * @param symbol_id the symbol ID associated with the order, require that the symbol exists.
+     * @param order_id the ID associated with the order.
+     * @return the order if it rests in the book and nullptr otherwise.
+     */
+    [[nodiscard]] const Order *findOrder(uint32_t symbol_id, uint64_t order_id) const;
+
+    /**
+     * @param symbol_id the symbol ID to check, require that the symbol exists.
+     * @return the quantity of the last order added to the symbol that was
+     *         executed on arrival.
+     */
+    [[nodiscard]] uint64_t lastAddedExecutedQuantity(uint32_t symbol_id) const;
+
+    /**
+     * Reports the level changes and trades of every book to `listener`, on
+     * the thread that changes the market.
+     *
+     * @param listener the listener, not owned, nullptr to stop reporting.
+     */
+    void setBookListener(BookListener *listener);
+
     /**
      * Executes an existing order in the market.
      *
@@ -0,0 +1,128 @@
+#ifndef UBI_TRADER_MARKET_COMMAND_H
+#define UBI_TRADER_MARKET_COMMAND_H
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <string>
+#include <type_traits>
+#include "book_prices.h"
+#include "order.h"
+#include "pnl_helper.h"
+#include "seqlock.h"
+
+namespace UBIEngine {
+class OrderBookHandler;
+
+/**
+ * What the worker thread of ConcurrentMarket publishes about a symbol after
+ * every command on it: enough to compute the base price, the price limits
+ * and the PnL on another thread.
+ */
+struct SymbolSnapshot
+{
+    BookPrices prices;
+    PnlHelper pnl_helper;
+};
+
+// The published snapshot of a symbol, written by its worker thread only.
+using SymbolSnapshotSlot = Concurrent::SeqLock<SymbolSnapshot>;
+
+enum class MarketCommandType : uint8_t
+{
+    AddSymbol,
+    DeleteSymbol,
+    AddOrder,
+    DeleteOrder,
+    ExecuteOrder,   // At the price of the resting order.
+    ExecuteOrderAt, // At `execute.price`.
+    Query,
+};
+
+/**
+ * A request to the worker thread of ConcurrentMarket that owns the symbol.
+ * Commands are plain bytes of a fixed size, written straight into the
+ * worker's ring and decoded with a switch: submitting an order allocates
+ * nothing and calls nothing indirectly.
+ */
+struct MarketCommand
+{
+    // Symbol names longer than this are cut, the books do not use them.
+    static constexpr size_t kMaxSymbolName = 15;
+
+    MarketCommandType type;
+    uint32_t symbol_id;
+    union
+    {
+        struct
+        {
+            uint64_t previous_close_price;
+            uint32_t previous_position;
+            char name[kMaxSymbolName + 1];
+            // Where the worker publishes the symbol, owned by the market.
+            SymbolSnapshotSlot *snapshot;
+        } add_symbol;
+        // A new order, see `order()`. Order itself is not plain bytes (it has list hooks).
+        struct
+        {
+            uint64_t order_id;
+            uint64_t quantity;
+            uint64_t price;
+            OrderType type;
+            OrderSide side;
+            bool is_strategy;
+        } add_order;
+        struct
+        {
+            uint64_t order_id;
+        } delete_order;
+        struct
+        {
+            uint64_t order_id;
+            uint64_t quantity;
+            uint64_t price;
+        } execute;
+        struct
+        {
+            // Set to the string representation of the worker's books.
+            std::promise<std::string> *result;
+        } query;
+    };
+
+    /**
+     * @param order a new order, require that nothing of it has been executed.
+     */
+    void setOrder(const Order &order)
+    {
+        add_order.order_id = order.getOrderID();
+        add_order.quantity = order.getQuantity();
+        add_order.price = order.getPrice();
+        add_order.type = order.getType();
+        add_order.side = order.getSide();
+        add_order.is_strategy = order.isStrategyOrder();
+    }
+
+    Order order() const
+    {
+        return Order::newOrder(add_order.type, add_order.side, add_order.order_id, symbol_id,
+            add_order.quantity, add_order.price, add_order.is_strategy);
+    }
+
+    void setSymbolName(const std::string &name)
+    {
+        size_t length = std::min(name.size(), kMaxSymbolName);
+        std::memcpy(add_symbol.name, name.data(), length);
+        add_symbol.name[length] = '\0';
+    }
+
+    /**
+     * Applies the command to the books of `handler`.
+     *
+     * @param handler the orderbook handler of the worker thread.
+     */
+    void apply(OrderBookHandler &handler) const;
+};
+
+static_assert(std::is_trivially_copyable_v<MarketCommand>, "Commands must be plain bytes!");
+} // namespace UBIEngine
+#endif // UBI_TRADER_MARKET_COMMAND_H
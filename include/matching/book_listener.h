@@ -0,0 +1,28 @@
+#ifndef UBI_TRADER_BOOK_LISTENER_H
+#define UBI_TRADER_BOOK_LISTENER_H
+#include <cstdint>
+#include "order.h"
+
+namespace UBIEngine {
+/**
+ * Receives the changes of a MapOrderBook as they happen, on the thread that
+ * changes the book. Used to publish market data (see engine/market_data_publisher.h).
+ */
+class BookListener {
+public:
+    virtual ~BookListener() = default;
+
+    /**
+     * The open volume at a price level changed.
+     *
+     * @param volume the total open volume of the level now, zero if the level is gone.
+     */
+    virtual void onLevel(uint32_t symbol_id, OrderSide side, uint64_t price, uint64_t volume) = 0;
+
+    /**
+     * Orders of the symbol traded.
+     */
+    virtual void onTrade(uint32_t symbol_id, uint64_t price, uint64_t quantity) = 0;
+};
+} // namespace UBIEngine
+#endif // UBI_TRADER_BOOK_LISTENER_H
@@ -0,0 +1,42 @@
+#ifndef UBI_TRADER_BOOK_PRICES_H
+#define UBI_TRADER_BOOK_PRICES_H
+#include <cstdint>
+#include <limits>
+#include "order.h"
+
+namespace UBIEngine {
+/**
+ * The prices of a book that its base price and price limits depend on. A
+ * plain copy, so the worker thread of ConcurrentMarket can publish it and
+ * other threads can compute the limits without touching the book.
+ */
+struct BookPrices {
+    // The highest bid, 0 if there are no bids.
+    uint64_t best_bid = 0;
+    // The lowest ask, the max 64-bit unsigned integer value if there are no asks.
+    uint64_t best_ask = std::numeric_limits<uint64_t>::max();
+    // 0 if nothing has traded yet.
+    uint64_t last_traded_price = 0;
+    uint64_t previous_close_price = 0;
+    bool has_bids = false;
+    bool has_asks = false;
+
+    /**
+     * @param side the side of the new order.
+     * @return the best price of the opposite side, else of the same side,
+     *         else the last traded price, else the previous close price.
+     */
+    [[nodiscard]] uint64_t basePrice(OrderSide side) const;
+
+    /**
+     * @return the lowest price allowed for an order of `side`.
+     */
+    [[nodiscard]] uint64_t downLimit(OrderSide side) const;
+
+    /**
+     * @return the highest price allowed for an order of `side`.
+     */
+    [[nodiscard]] uint64_t upLimit(OrderSide side) const;
+};
+} // namespace UBIEngine
+#endif // UBI_TRADER_BOOK_PRICES_H
@@ -3,6 +3,8 @@
 #include <map>
 #include <limits>
 #include "robin_hood.h"
+#include "book_listener.h"
+#include "book_prices.h"
 #include "level.h"
 #include "orderbook.h"
 #include "pnl_helper.h"
@@ -134,6 +136,23 @@ public:
         return last_traded_price;
     }
 
+    /**
+     * Reports every level change and trade of the book to `listener_`.
+     *
+     * @param listener_ the listener, nullptr to stop reporting.
+     */
+    void setListener(BookListener *listener_) {
+        listener = listener_;
+    }
+
+    /**
+     * @return the quantity of the last added order that was executed when it
+     *         was matched on arrival.
+     */
+    [[nodiscard]] uint64_t lastAddedExecutedQuantity() const {
+        return last_added_executed_quantity;
+    }
+
     /**
      * @return the previous close price. define in pnl_helper.h
      */
@@ -155,6 +174,20 @@ public:
         return pnl_helper;
     }
 
+    /**
+     * @return the prices that the base price and the price limits depend on.
+     */
+    [[nodiscard]] BookPrices prices() const {
+        BookPrices book_prices;
+        book_prices.best_bid = bestBid();
+        book_prices.best_ask = bestAsk();
+        book_prices.last_traded_price = last_traded_price;
+        book_prices.previous_close_price = previousClosePrice();
+        book_prices.has_bids = !bid_levels.empty();
+        book_prices.has_asks = !ask_levels.empty();
+        return book_prices;
+    }
+
     /**
      * @inheritdoc
      */
@@ -229,6 +262,16 @@ private:
      */
     void executeOrders(Order &ask, Order &bid, uint64_t executing_price);
 
+    /**
+     * Reports the current volume of a level to the listener, if any.
+     */
+    void publishLevel(OrderSide side, uint64_t price) const {
+        if (listener != nullptr)
+            publishLevelSlow(side, price);
+    }
+
+    void publishLevelSlow(OrderSide side, uint64_t price) const;
+
     /**
      * @returns the last traded price if any trades have been made and the max
      *          64-bit unsigned integer value otherwise.
@@ -280,6 +323,10 @@ private:
     // The current price of the symbol - based off the price that the
     // symbol was last traded at. Initially zero.
     uint64_t last_traded_price;
+    // The executed quantity of the last added order, reported by order-entry acks.
+    uint64_t last_added_executed_quantity = 0;
+    // Notified of level changes and trades, not owned.
+    BookListener *listener = nullptr;
     // The symbol ID associated with the book.
     uint32_t symbol_id;
 };
@@ -0,0 +1,23 @@
+#ifndef UBI_TRADER_UTILS_CPU_H
+#define UBI_TRADER_UTILS_CPU_H
+#include <pthread.h>
+#include <sched.h>
+
+namespace UBIEngine::Utils {
+/* A pause between polls of a spin loop: saves power and the sibling hyperthread's cycles. */
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/* Pins the calling thread to `cpu`. Returns false if the CPU does not exist or is not allowed. */
+inline bool pinCurrentThread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+}  // namespace UBIEngine::Utils
+#endif  // UBI_TRADER_UTILS_CPU_H
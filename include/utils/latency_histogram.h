@@ -0,0 +1,63 @@
+#ifndef UBI_TRADER_UTILS_LATENCY_HISTOGRAM_H
+#define UBI_TRADER_UTILS_LATENCY_HISTOGRAM_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace UBIEngine::Utils {
+/**
+ * A log-linear latency histogram: values below 32ns are exact, larger values
+ * keep 5 significant bits (about 3% resolution). Recording is O(1) and the
+ * memory does not grow with the number of values, so it neither pollutes the
+ * peak RSS bench_replay reports nor grows in long-running processes.
+ */
+class LatencyHistogram {
+   public:
+    LatencyHistogram() : buckets(64 << kSubBits, 0) {}
+
+    void add(uint64_t value) {
+        ++buckets[index(value)];
+        ++count;
+    }
+
+    /* The number of recorded values. */
+    uint64_t size() const { return count; }
+
+    /**
+     * @param p the percentile in (0, 1].
+     * @return the lower bound of the bucket that holds the percentile.
+     */
+    uint64_t percentile(double p) const {
+        uint64_t target = static_cast<uint64_t>(p * count + 0.5);
+        if (target == 0) target = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= target) return lowerBound(i);
+        }
+        return 0;
+    }
+
+   private:
+    static constexpr int kSubBits = 5;
+
+    static size_t index(uint64_t value) {
+        if (value < (1u << kSubBits)) return value;
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - kSubBits;
+        return (static_cast<size_t>(shift + 1) << kSubBits) +
+               ((value >> shift) & ((1u << kSubBits) - 1));
+    }
+
+    static uint64_t lowerBound(size_t index) {
+        if (index < (1u << kSubBits)) return index;
+        int shift = static_cast<int>(index >> kSubBits) - 1;
+        uint64_t sub = index & ((1u << kSubBits) - 1);
+        return ((1ull << kSubBits) + sub) << shift;
+    }
+
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+};
+}  // namespace UBIEngine::Utils
+#endif  // UBI_TRADER_UTILS_LATENCY_HISTOGRAM_H
@@ -1,5 +1,6 @@
 #ifndef UBI_TRADER_QUEUE_H
 #define UBI_TRADER_QUEUE_H
+#include <chrono>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
@@ -55,6 +56,18 @@ public:
         return true;
     }
 
+    /**
+     * Waits until the queue is not empty or `timeout` has passed.
+     *
+     * @return true if the queue is not empty.
+     */
+    template<typename Rep, typename Period>
+    bool waitForData(const std::chrono::duration<Rep, Period> &timeout) const
+    {
+        std::unique_lock<std::mutex> lk(m);
+        return c.wait_for(lk, timeout, [this] { return !queue.empty(); });
+    }
+
     bool empty() const
     {
         std::lock_guard<std::mutex> lk(m);
@@ -64,7 +77,7 @@ public:
 private:
     mutable std::mutex m;
     std::queue<T> queue;
-    std::condition_variable c;
+    mutable std::condition_variable c;
 };
 } // namespace UBIEngine::Concurrent
 #endif // UBI_TRADER_QUEUE_H
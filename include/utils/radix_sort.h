@@ -0,0 +1,313 @@
+#ifndef UBI_TRADER_UTILS_RADIX_SORT_H
+#define UBI_TRADER_UTILS_RADIX_SORT_H
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "io/type.h"
+
+namespace UBIEngine::Utils {
+/* A 128-bit sort key, ordered by `high` then `low`. */
+struct SortKey {
+    uint64_t high;
+    uint64_t low;
+
+    bool operator<(const SortKey& other) const {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+};
+
+/**
+ * An 8-byte instrument id as a big-endian integer, so that integer order is
+ * the `strncmp(a, b, 8)` order: the bytes after the terminator count as 0.
+ */
+inline uint64_t instrumentSortKey(const char* instrument_id) {
+    uint64_t key;
+    std::memcpy(&key, instrument_id, 8);
+    // The lowest flagged byte is the first zero byte (higher flags may be false positives).
+    uint64_t zeros = (key - 0x0101010101010101ull) & ~key & 0x8080808080808080ull;
+    if (zeros != 0) key &= (uint64_t{1} << (__builtin_ctzll(zeros) & ~7u)) - 1;
+    return __builtin_bswap64(key);
+}
+
+/* (timestamp, instrument_id), the order of my_compare_twap. */
+inline SortKey twapSortKey(const IO::twap_order& order) {
+    // Flipping the sign bit orders negative timestamps first.
+    return {static_cast<uint64_t>(order.timestamp) ^ (uint64_t{1} << 63),
+            instrumentSortKey(order.instrument_id)};
+}
+
+/* instrument_id, the order of my_compare_pnl. */
+inline SortKey pnlSortKey(const IO::pnl_and_pos& pnl) {
+    return {0, instrumentSortKey(pnl.instrument_id)};
+}
+
+namespace detail {
+struct RadixItem {
+    SortKey key;
+    uint32_t index;
+};
+
+template <typename F>
+void parallelFor(unsigned thread_count, F&& body) {
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < thread_count; ++t) threads.emplace_back(body, t);
+    body(0u);
+    for (auto& thread : threads) thread.join();
+}
+
+/* A key of at most 64 significant bits and the position of its item. */
+struct PackedItem {
+    uint64_t key;
+    uint32_t position;
+};
+
+/**
+ * The LSD passes of radixOrderPacked() over `Item`s made by `make(item, i)`,
+ * which `key_of` and `position_of` take apart again.
+ */
+template <typename Item, typename Make, typename KeyOf, typename PositionOf>
+std::vector<uint32_t> lsdOrder(const std::vector<RadixItem>& items, Make make, KeyOf key_of,
+                               PositionOf position_of, unsigned bits, unsigned thread_count) {
+    const size_t n = items.size();
+    // Chunks smaller than this are not worth a thread.
+    constexpr size_t kMinChunk = 1 << 15;
+    constexpr unsigned kMaxDigitBits = 11;
+    thread_count = static_cast<unsigned>(
+        std::max<size_t>(1, std::min<size_t>(thread_count, n / kMinChunk + 1)));
+    auto chunkBegin = [&](unsigned t) { return n * t / thread_count; };
+    const unsigned passes = (bits + kMaxDigitBits - 1) / kMaxDigitBits;
+    const unsigned digit_bits = (bits + passes - 1) / passes;
+    const size_t buckets = size_t{1} << digit_bits;
+    const uint64_t digit_mask = buckets - 1;
+
+    std::vector<Item> from(n), to(n);
+    parallelFor(thread_count, [&](unsigned t) {
+        for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i) from[i] = make(items[i], i);
+    });
+    std::vector<std::vector<size_t>> counts(thread_count, std::vector<size_t>(buckets));
+    for (unsigned pass = 0; pass < passes; ++pass) {
+        const unsigned shift = pass * digit_bits;
+        parallelFor(thread_count, [&](unsigned t) {
+            auto& count = counts[t];
+            std::fill(count.begin(), count.end(), 0);
+            for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+                ++count[(key_of(from[i]) >> shift) & digit_mask];
+        });
+        // Exclusive prefix sum, digit major and thread minor, so the scatter is stable.
+        size_t offset = 0;
+        for (size_t d = 0; d < buckets; ++d) {
+            for (unsigned t = 0; t < thread_count; ++t) {
+                size_t count = counts[t][d];
+                counts[t][d] = offset;
+                offset += count;
+            }
+        }
+        parallelFor(thread_count, [&](unsigned t) {
+            auto& next = counts[t];
+            for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+                to[next[(key_of(from[i]) >> shift) & digit_mask]++] = from[i];
+        });
+        from.swap(to);
+    }
+
+    std::vector<uint32_t> order(n);
+    parallelFor(thread_count, [&](unsigned t) {
+        for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+            order[i] = static_cast<uint32_t>(position_of(from[i]));
+    });
+    return order;
+}
+
+inline unsigned bitWidth(uint64_t x) { return x == 0 ? 0 : 64 - __builtin_clzll(x); }
+
+/**
+ * The positions of `items` in stable order of `packed(item)`, a key of
+ * `bits` significant bits, by a parallel LSD radix sort of up to 11 bits
+ * per pass. If the key and the item's position fit in 64 bits together,
+ * the passes move single words, which halves the memory traffic.
+ */
+template <typename Packed>
+std::vector<uint32_t> radixOrderPacked(const std::vector<RadixItem>& items, Packed packed,
+                                       unsigned bits, unsigned thread_count) {
+    if (bits == 0) {
+        std::vector<uint32_t> order(items.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<uint32_t>(i);
+        return order;
+    }
+    const unsigned position_bits = bitWidth(items.size() - 1);
+    if (bits + position_bits <= 64) {
+        const uint64_t position_mask = (uint64_t{1} << position_bits) - 1;
+        return lsdOrder<uint64_t>(
+            items,
+            [&](const RadixItem& item, size_t i) { return packed(item) << position_bits | i; },
+            [=](uint64_t word) { return word >> position_bits; },
+            [=](uint64_t word) { return word & position_mask; }, bits, thread_count);
+    } else {
+        return lsdOrder<PackedItem>(
+            items,
+            [&](const RadixItem& item, size_t i) {
+                return PackedItem{packed(item), static_cast<uint32_t>(i)};
+            },
+            [](const PackedItem& item) { return item.key; },
+            [](const PackedItem& item) { return item.position; }, bits, thread_count);
+    }
+}
+
+/**
+ * The positions of the items in stable key order, by a parallel LSD radix
+ * sort. Only the bits that vary are sorted on: `high` relative to its
+ * minimum and the span of `low` bits that are not the same in every key.
+ * When both fit in 64 bits (e.g. a day of millisecond timestamps and the
+ * last digits of the instrument ids) they are packed into one key and
+ * sorted in a few passes.
+ */
+inline std::vector<uint32_t> radixOrder(const std::vector<RadixItem>& items,
+                                        unsigned thread_count) {
+    uint64_t min_high = UINT64_MAX, max_high = 0, low_diff = 0;
+    const uint64_t first_low = items[0].key.low;
+    for (const auto& item : items) {
+        min_high = std::min(min_high, item.key.high);
+        max_high = std::max(max_high, item.key.high);
+        low_diff |= item.key.low ^ first_low;
+    }
+    const unsigned high_bits = bitWidth(max_high - min_high);
+    const unsigned low_shift = low_diff == 0 ? 0 : __builtin_ctzll(low_diff);
+    const unsigned low_bits = bitWidth(low_diff) - low_shift;
+    auto lowPart = [=](const RadixItem& item) {
+        uint64_t low = item.key.low >> low_shift;
+        return low_bits == 64 ? low : low & ((uint64_t{1} << low_bits) - 1);
+    };
+    auto highPart = [=](const RadixItem& item) { return item.key.high - min_high; };
+
+    if (high_bits + low_bits <= 64) {
+        auto packed = [=](const RadixItem& item) {
+            return low_bits == 64 ? lowPart(item) : (highPart(item) << low_bits) | lowPart(item);
+        };
+        return radixOrderPacked(items, packed, high_bits + low_bits, thread_count);
+    }
+    // LSD over the two halves: by `low` first, then stably by `high`.
+    std::vector<uint32_t> by_low = radixOrderPacked(items, lowPart, low_bits, thread_count);
+    std::vector<RadixItem> reordered(items.size());
+    for (size_t i = 0; i < items.size(); ++i) reordered[i] = items[by_low[i]];
+    std::vector<uint32_t> order = radixOrderPacked(reordered, highPart, high_bits, thread_count);
+    for (auto& position : order) position = by_low[position];
+    return order;
+}
+
+/* Reorders `records` so that the i-th is the old `records[position_of(i)]`. */
+template <typename T, typename PositionOf>
+void gatherRecords(std::vector<T>& records, size_t count, PositionOf position_of) {
+    std::vector<T> sorted;
+    sorted.reserve(records.size());
+    for (size_t i = 0; i < count; ++i) sorted.push_back(records[position_of(i)]);
+    records.swap(sorted);
+}
+}  // namespace detail
+
+/**
+ * Sorts records by `key_of(record)` (a SortKey) with a parallel LSD radix
+ * sort. The sort is stable. Keys are computed once, the passes move packed
+ * (key, position) words and the records are gathered once at the end.
+ *
+ * @param records require that there are less than 2^32 of them.
+ * @param key_of maps a record to its SortKey, e.g. twapSortKey.
+ * @param thread_count the number of threads, require that it is positive.
+ */
+template <typename T, typename KeyOf>
+void radixSort(std::vector<T>& records, KeyOf key_of,
+               unsigned thread_count = std::max(1u, std::thread::hardware_concurrency())) {
+    if (records.size() < 2) return;
+    std::vector<detail::RadixItem> items(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        items[i] = {key_of(records[i]), static_cast<uint32_t>(i)};
+    }
+    // Below a few hundred records a comparison sort is faster than the histograms.
+    if (items.size() < 256) {
+        std::stable_sort(items.begin(), items.end(),
+                         [](const auto& a, const auto& b) { return a.key < b.key; });
+        return detail::gatherRecords(records, items.size(),
+                                     [&](size_t i) { return items[i].index; });
+    }
+    std::vector<uint32_t> order = detail::radixOrder(items, thread_count);
+    detail::gatherRecords(records, order.size(), [&](size_t i) { return order[i]; });
+}
+
+/**
+ * Sorts records that are nearly sorted already, such as twap_orders, which
+ * the replay emits in time order with ties in arbitrary instrument order.
+ *
+ * One pass keeps a greedy run of records whose SortKey::high (e.g. the
+ * timestamp) never decreases and sets the other records aside. Equal-`high`
+ * groups of the run are usually a handful of records and are sorted by
+ * insertion (larger ones by std::stable_sort). The records set aside are
+ * radix sorted and merged in. If more than 1/8 of the records are out of
+ * order, it is a plain radixSort(). The sort is stable.
+ */
+template <typename T, typename KeyOf>
+void sortNearlySorted(std::vector<T>& records, KeyOf key_of,
+                      unsigned thread_count = std::max(1u, std::thread::hardware_concurrency())) {
+    const size_t n = records.size();
+    if (n < 2) return;
+    std::vector<detail::RadixItem> run;
+    std::vector<detail::RadixItem> late;
+    run.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        detail::RadixItem item{key_of(records[i]), static_cast<uint32_t>(i)};
+        if (run.empty() || run.back().key.high <= item.key.high) {
+            run.push_back(item);
+        } else {
+            late.push_back(item);
+            if (late.size() > n / 8) return radixSort(records, key_of, thread_count);
+        }
+    }
+
+    // Insertion sort within each group of equal `high`, stable.
+    auto byKey = [](const auto& a, const auto& b) { return a.key < b.key; };
+    for (size_t begin = 0; begin < run.size();) {
+        size_t end = begin + 1;
+        while (end < run.size() && run[end].key.high == run[begin].key.high) ++end;
+        if (end - begin > 32) {
+            std::stable_sort(run.begin() + begin, run.begin() + end, byKey);
+            begin = end;
+            continue;
+        }
+        for (size_t i = begin + 1; i < end; ++i) {
+            detail::RadixItem item = run[i];
+            size_t j = i;
+            for (; j > begin && item.key < run[j - 1].key; --j) run[j] = run[j - 1];
+            run[j] = item;
+        }
+        begin = end;
+    }
+    auto runIndex = [&](size_t i) { return run[i].index; };
+    if (late.empty()) return detail::gatherRecords(records, run.size(), runIndex);
+
+    if (late.size() < 256) {
+        std::stable_sort(late.begin(), late.end(), byKey);
+    } else {
+        std::vector<uint32_t> order = detail::radixOrder(late, thread_count);
+        std::vector<detail::RadixItem> sorted(late.size());
+        for (size_t i = 0; i < late.size(); ++i) sorted[i] = late[order[i]];
+        late.swap(sorted);
+    }
+    std::vector<detail::RadixItem> items(n);
+    // Equal keys keep the input order.
+    std::merge(run.begin(), run.end(), late.begin(), late.end(), items.begin(),
+               [](const auto& a, const auto& b) {
+                   return a.key < b.key || (!(b.key < a.key) && a.index < b.index);
+               });
+    detail::gatherRecords(records, n, [&](size_t i) { return items[i].index; });
+}
+
+/* Sorts twap_orders by (timestamp, instrument_id), like my_compare_twap. */
+inline void sortTwapOrders(std::vector<IO::twap_order>& orders) {
+    sortNearlySorted(orders, twapSortKey);
+}
+
+/* Sorts pnl_and_pos by instrument_id, like my_compare_pnl. */
+inline void sortPnls(std::vector<IO::pnl_and_pos>& pnls) { radixSort(pnls, pnlSortKey); }
+}  // namespace UBIEngine::Utils
+#endif  // UBI_TRADER_UTILS_RADIX_SORT_H
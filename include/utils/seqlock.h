@@ -0,0 +1,71 @@
+#ifndef UBI_TRADER_SEQLOCK_H
+#define UBI_TRADER_SEQLOCK_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "utils/cpu.h"
+
+namespace UBIEngine::Concurrent {
+/**
+ * A value with exactly one writer thread that any thread can read without
+ * taking a lock or making the writer wait. The writer makes the sequence odd,
+ * writes the value and makes it even again; a reader copies the value and
+ * retries if the sequence was odd or changed in between, so it never sees
+ * half of a write.
+ *
+ * The value is kept as relaxed atomic words, so a read that races with a
+ * write is a retry and not a data race.
+ *
+ * @tparam T type of the value, require that it is trivially copyable.
+ */
+template <typename T>
+class alignas(64) SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock needs a trivially copyable value!");
+
+   public:
+    explicit SeqLock(const T& value = T()) { store(value); }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    /* Writer only. */
+    void store(const T& value) {
+        uint64_t buffer[kWords] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        uint64_t s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) words[i].store(buffer[i], std::memory_order_relaxed);
+        sequence.store(s + 2, std::memory_order_release);
+    }
+
+    /* Any thread. Returns a value that the writer stored as a whole. */
+    T load() const {
+        uint64_t buffer[kWords];
+        while (true) {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                Utils::cpuRelax();
+                continue;
+            }
+            for (size_t i = 0; i < kWords; ++i)
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) break;
+        }
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+   private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[kWords];
+};
+}  // namespace UBIEngine::Concurrent
+#endif  // UBI_TRADER_SEQLOCK_H
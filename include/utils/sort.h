@@ -7,13 +7,13 @@
 
 namespace UBIEngine::Utils {
 // Comparator for twap_order.
-bool my_compare_twap(const IO::twap_order &a, const IO::twap_order &b) {
+inline bool my_compare_twap(const IO::twap_order &a, const IO::twap_order &b) {
     if (a.timestamp != b.timestamp)
         return a.timestamp < b.timestamp;
     return std::strncmp(a.instrument_id, b.instrument_id, 8) < 0;
 }
 
-bool my_compare_pnl(const IO::pnl_and_pos &a, const IO::pnl_and_pos &b) {
+inline bool my_compare_pnl(const IO::pnl_and_pos &a, const IO::pnl_and_pos &b) {
     return std::strncmp(a.instrument_id, b.instrument_id, 8) < 0;
 }
 
@@ -0,0 +1,142 @@
+#ifndef UBI_TRADER_SPSC_QUEUE_H
+#define UBI_TRADER_SPSC_QUEUE_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace UBIEngine::Concurrent {
+/**
+ * A bounded lock-free queue for exactly one producer thread and one consumer
+ * thread. The indices live on separate cache lines and each side caches the
+ * other side's index, so a push or pop touches the shared lines only when the
+ * cached view says the queue is full or empty.
+ *
+ * @tparam T type of the objects stored in the queue, require that it is
+ *           default constructible and movable.
+ */
+template <typename T>
+class SpscQueue {
+   public:
+    /**
+     * @param capacity the minimum number of objects the queue holds, rounded
+     *                 up to a power of two.
+     */
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /* Producer only. Returns false if the queue is full, then `value` is left as is. */
+    bool tryPush(T&& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head == slots.size()) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head == slots.size()) return false;
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value) {
+        T copy = value;
+        return tryPush(std::move(copy));
+    }
+
+    /* Producer only. Waits while the queue is full, like `Queue::push()` it never fails. */
+    void push(T value) {
+        while (!tryPush(std::move(value))) std::this_thread::yield();
+    }
+
+    /**
+     * Producer only. Lets `write` fill the next slot in place, so large
+     * objects are written once, straight into the ring. Returns false without
+     * calling `write` if the queue is full.
+     */
+    template <typename F>
+    bool tryPushWith(F&& write) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head == slots.size()) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head == slots.size()) return false;
+        }
+        write(slots[t & mask]);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Producer only. Like `tryPushWith()`, waits while the queue is full. */
+    template <typename F>
+    void pushWith(F&& write) {
+        while (!tryPushWith(write)) std::this_thread::yield();
+    }
+
+    /* Consumer only. Returns false if the queue is empty. */
+    bool tryPop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) return false;
+        }
+        value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer only. Calls `f` on up to `max_count` objects in place, then
+     * releases their slots with one store, so a burst costs one round trip of
+     * the index's cache line instead of one per object. Objects that own
+     * something are reset to `T()` after `f`, so nothing they own outlives the
+     * call. `f` must not throw.
+     *
+     * @return the number of objects popped, 0 if the queue is empty.
+     */
+    template <typename F>
+    size_t tryPopBatch(F&& f, size_t max_count) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (cached_tail - h < max_count) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) return 0;
+        }
+        size_t count = std::min(cached_tail - h, max_count);
+        for (size_t i = 0; i < count; ++i) {
+            T& slot = slots[(h + i) & mask];
+            f(slot);
+            if constexpr (!std::is_trivially_destructible_v<T>) slot = T();
+        }
+        head.store(h + count, std::memory_order_release);
+        return count;
+    }
+
+    /* Approximate unless called by the consumer. */
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+   private:
+    static constexpr size_t kCacheLine = 64;
+
+    // Consumer side.
+    alignas(kCacheLine) std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+    // Producer side.
+    alignas(kCacheLine) std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+
+    alignas(kCacheLine) std::vector<T> slots;
+    size_t mask = 0;
+};
+}  // namespace UBIEngine::Concurrent
+#endif  // UBI_TRADER_SPSC_QUEUE_H
@@ -4,21 +4,38 @@
 #include <vector>
 #include <atomic>
 #include <cassert>
+#include <chrono>
+#include <functional>
 #include <future>
+#include <type_traits>
 #include "thread_joiner.h"
 #include "queue.h"
+#include "spsc_queue.h"
 
 namespace UBIEngine::Concurrent {
-class ThreadPool
+/**
+ * A thread pool with one task queue per worker thread.
+ *
+ * @tparam TaskQueue the queue type of the workers: Queue (any number of
+ *                   submitting threads, a mutex per operation) or SpscQueue
+ *                   (bounded and lock-free, tasks of a queue must all be
+ *                   submitted from one thread). See ThreadPool and SpscThreadPool.
+ */
+template<typename TaskQueue>
+class BasicThreadPool
 {
 public:
+    using Task = std::function<void()>;
+
     /**
      * A constructor for the thread pool.
      *
      * @param num_threads_ the number of worker threads that will be spawned by
      *                     the thread pool, require that num_threads_ is positive.
+     * @param queue_capacity the tasks each bounded queue holds, submitting waits beyond it.
      */
-    explicit ThreadPool(uint32_t num_threads_ = std::thread::hardware_concurrency())
+    explicit BasicThreadPool(uint32_t num_threads_ = std::thread::hardware_concurrency(),
+                             size_t queue_capacity = 1 << 16)
         : num_threads(num_threads_)
         , running(true)
         , thread_joiner(threads)
@@ -33,8 +50,11 @@ public:
         {
             for (auto i = 0; i < num_threads; ++i)
             {
-                thread_queues.push_back(std::make_unique<Queue<std::function<void()>>>());
-                threads.emplace_back(&ThreadPool::workerThread, this, i);
+                if constexpr (std::is_constructible_v<TaskQueue, size_t>)
+                    thread_queues.push_back(std::make_unique<TaskQueue>(queue_capacity));
+                else
+                    thread_queues.push_back(std::make_unique<TaskQueue>());
+                threads.emplace_back(&BasicThreadPool::workerThread, this, i);
             }
         }
         catch (...)
@@ -58,8 +78,8 @@ public:
     template<typename F, typename... Args>
     void submitTask(uint32_t queue_index, F &&f, Args &&...args)
     {
-        std::function<void()> task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-        thread_queues[queue_index]->push(task);
+        Task task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        thread_queues[queue_index]->push(std::move(task));
     }
 
     /**
@@ -112,7 +132,7 @@ public:
         try
         {
             for (auto i = 0; i < num_threads; ++i)
-                threads[i] = std::thread(&ThreadPool::workerThread, this, i);
+                threads[i] = std::thread(&BasicThreadPool::workerThread, this, i);
         }
         catch (...)
         {
@@ -149,12 +169,17 @@ public:
     /**
      * A destructor for the thread pool. Notifies worker threads that they are finished.
      */
-    ~ThreadPool()
+    ~BasicThreadPool()
     {
         running = false;
     };
 
 private:
+    // The most tasks a worker takes from a lock-free queue at once.
+    static constexpr size_t kBatchSize = 64;
+    // The longest an idle worker of a mutex queue sleeps before it looks at the running flag.
+    static constexpr std::chrono::milliseconds kIdleWait{10};
+
     /**
      * Wait for and execute incoming tasks.
      *
@@ -164,19 +189,53 @@ private:
     void workerThread(uint32_t queue_id)
     {
         assert(queue_id < thread_queues.size() && "Invalid queue index!");
-        // Keep processing tasks until the running flag is set to false and the queue is empty.
-        // Otherwise, there may be unfinished tasks left in the queue.
-        while (running || !thread_queues[queue_id]->empty())
+        TaskQueue &queue = *thread_queues[queue_id];
+        while (true)
         {
-            std::function<void()> task;
-            bool empty = false;
-            if (thread_queues[queue_id]->tryPop(task))
-                task();
-            else
-                std::this_thread::yield();
+            if (runTasks(queue) != 0)
+                continue;
+            // Keep processing tasks until the running flag is set to false and the queue is
+            // empty. Only an idle worker looks at them, a busy one never takes the lock.
+            if (!running && queue.empty())
+                return;
+            idle(queue);
         }
     }
 
+    /**
+     * Waits a little for the next task of an idle worker. A mutex queue sleeps
+     * on its condition variable, waking up now and then to see the running
+     * flag; a lock-free queue serves latency-bound work and only yields.
+     */
+    static void idle(Queue<Task> &queue)
+    {
+        queue.waitForData(kIdleWait);
+    }
+
+    static void idle(SpscQueue<Task> &)
+    {
+        std::this_thread::yield();
+    }
+
+    /**
+     * Runs the next task of `queue`, or the next batch of them.
+     *
+     * @return the number of tasks that ran, 0 if the queue was empty.
+     */
+    static size_t runTasks(Queue<Task> &queue)
+    {
+        Task task;
+        if (!queue.tryPop(task))
+            return 0;
+        task();
+        return 1;
+    }
+
+    static size_t runTasks(SpscQueue<Task> &queue)
+    {
+        return queue.tryPopBatch([](Task &task) { task(); }, kBatchSize);
+    }
+
     // IMPORTANT: The running flag and the work queues must be declared
     // before the vector containing the threads. Otherwise, the queue and
     // the flag would be destroyed before the threads have finished their work.
@@ -186,11 +245,16 @@ private:
     // The number of worker threads in the thread pool - must be at least 1.
     uint32_t num_threads;
     // Thread-safe queue for each worker thread.
-    std::vector<std::unique_ptr<Queue<std::function<void()>>>> thread_queues;
+    std::vector<std::unique_ptr<TaskQueue>> thread_queues;
     // The worker threads and their corresponding queues - each thread gets its own queue.
     std::vector<std::thread> threads;
     // Handles cleaning up the worker threads when the thread pool is destroyed.
     ThreadJoiner thread_joiner;
 };
+
+// Tasks may be submitted from any thread.
+using ThreadPool = BasicThreadPool<Queue<std::function<void()>>>;
+// The tasks of each queue come from one thread, e.g. the replay thread of ConcurrentMarket.
+using SpscThreadPool = BasicThreadPool<SpscQueue<std::function<void()>>>;
 } // namespace UBIEngine::Concurrent
 #endif // UBI_TRADER_THREAD_POOL_H
@@ -0,0 +1,170 @@
+#ifndef UBI_TRADER_UTILS_TRACE_H
+#define UBI_TRADER_UTILS_TRACE_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace UBIEngine::Utils {
+/**
+ * The kinds of record written by the tracer.
+ */
+enum class TraceKind : uint8_t {
+    HistoryOrder = 0,   // An order from order_log that was submitted to the market.
+    TwapOrder = 1,      // A TWAP slice that was submitted to the market.
+    RejectedOrder = 2   // An order from order_log that was dropped before the market.
+};
+
+/**
+ * A fixed-size binary trace record. Prices are in ticks (0.01), like the orderbook.
+ */
+struct TraceRecord {
+    int64_t clock_ns;       // steady_clock time when the record was written.
+    int64_t timestamp;      // The timestamp of the event in the input data.
+    uint32_t symbol_id;
+    TraceKind kind;
+    int8_t direction;       // 1 for bid and -1 for ask.
+    uint8_t order_type;     // The raw order_log type.
+    uint8_t reserved;
+    uint32_t volume;
+    uint32_t price;
+    uint64_t base_price;
+    uint64_t up_limit;
+    uint64_t down_limit;
+};
+
+/**
+ * A ring buffer of trace records with a per-symbol filter. The newest
+ * `kCapacity` records are kept, older ones are overwritten.
+ *
+ * The filter is read from the `UBI_TRACE_SYMBOLS` environment variable at
+ * startup (a comma separated list of symbol IDs, or `all`), falling back to
+ * the `UBI_TRACE_DEFAULT_SYMBOLS` build definition.
+ *
+ * Write records through the UBI_TRACE_EVENT macro: it compiles to nothing
+ * unless the build defines UBI_TRACE (cmake -DENABLE_TRACE=ON).
+ */
+class Tracer {
+   public:
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    /**
+     * @return true if records of the symbol should be written.
+     */
+    bool enabled(uint32_t symbol_id) const {
+        return trace_all || (symbol_id < symbol_filter.size() && symbol_filter[symbol_id]);
+    }
+
+    /**
+     * @return the symbols of the filter in increasing order, empty if it traces
+     *         all symbols or none.
+     */
+    std::vector<uint32_t> tracedSymbols() const {
+        std::vector<uint32_t> symbols;
+        if (trace_all) return symbols;
+        for (uint32_t symbol_id = 0; symbol_id < symbol_filter.size(); ++symbol_id)
+            if (symbol_filter[symbol_id]) symbols.push_back(symbol_id);
+        return symbols;
+    }
+
+    void record(TraceKind kind, uint32_t symbol_id, int64_t timestamp, int32_t direction,
+                int32_t order_type, uint32_t volume, uint32_t price, uint64_t base_price = 0,
+                uint64_t up_limit = 0, uint64_t down_limit = 0) {
+        uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+        TraceRecord& r = ring[index & (ring.size() - 1)];
+        r.clock_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+        r.timestamp = timestamp;
+        r.symbol_id = symbol_id;
+        r.kind = kind;
+        r.direction = static_cast<int8_t>(direction);
+        r.order_type = static_cast<uint8_t>(order_type);
+        r.reserved = 0;
+        r.volume = volume;
+        r.price = price;
+        r.base_price = base_price;
+        r.up_limit = up_limit;
+        r.down_limit = down_limit;
+    }
+
+    /**
+     * Writes the buffered records, oldest first, to a binary file and clears the buffer.
+     * Decode the file with IO/Trace/read.
+     */
+    bool dump(const std::string& path) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) return false;
+        uint64_t end = head.load(std::memory_order_relaxed);
+        uint64_t begin = end > ring.size() ? end - ring.size() : 0;
+        for (uint64_t i = begin; i < end; ++i) {
+            file.write(reinterpret_cast<const char*>(&ring[i & (ring.size() - 1)]),
+                       sizeof(TraceRecord));
+        }
+        head.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+   private:
+    // Must be a power of two. 1M records of 56 bytes = 56 MiB.
+    static constexpr size_t kCapacity = 1 << 20;
+    static_assert(sizeof(TraceRecord) == 56, "Update the ring size above");
+
+    Tracer() : ring(kCapacity) {
+        const char* symbols = std::getenv("UBI_TRACE_SYMBOLS");
+#ifdef UBI_TRACE_DEFAULT_SYMBOLS
+        if (symbols == nullptr) symbols = UBI_TRACE_DEFAULT_SYMBOLS;
+#endif
+        if (symbols == nullptr) return;
+        std::string list(symbols);
+        if (list == "all") {
+            trace_all = true;
+            return;
+        }
+        size_t start = 0;
+        while (start < list.size()) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) end = list.size();
+            if (end > start) {
+                auto symbol_id = static_cast<uint32_t>(std::stoul(list.substr(start, end - start)));
+                if (symbol_id >= symbol_filter.size()) symbol_filter.resize(symbol_id + 1, 0);
+                symbol_filter[symbol_id] = 1;
+            }
+            start = end + 1;
+        }
+    }
+
+    std::vector<TraceRecord> ring;
+    std::atomic<uint64_t> head{0};
+    std::vector<uint8_t> symbol_filter;
+    bool trace_all = false;
+};
+
+#ifdef UBI_TRACE
+inline constexpr bool kTraceEnabled = true;
+#else
+inline constexpr bool kTraceEnabled = false;
+#endif
+}  // namespace UBIEngine::Utils
+
+// The arguments are only evaluated when tracing is compiled in and the symbol passes the filter,
+// so expensive fields (e.g. price limits) cost nothing otherwise.
+#ifdef UBI_TRACE
+#    define UBI_TRACE_EVENT(kind, symbol_id, ...)                                              \
+        do {                                                                                 \
+            auto& ubi_tracer_ = ::UBIEngine::Utils::Tracer::instance();                     \
+            if (ubi_tracer_.enabled(symbol_id))                                              \
+                ubi_tracer_.record(::UBIEngine::Utils::TraceKind::kind, symbol_id, __VA_ARGS__); \
+        } while (0)
+#else
+#    define UBI_TRACE_EVENT(kind, symbol_id, ...) \
+        do {                                      \
+        } while (0)
+#endif
+#endif  // UBI_TRADER_UTILS_TRACE_H
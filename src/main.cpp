@@ -1,371 +1,338 @@
 #include <boost/filesystem.hpp>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <queue>
 
 #include "concurrent_market.h"
+#include "engine/replay.h"
+#include "io/archive.h"
+#include "io/bulk_reader.h"
+#include "io/mapped_output.h"
+#include "io/order_decoder.h"
 #include "io/reader.h"
-#include "io/sender.h"
+#include "io/result_shipper.h"
+#include "io/result_writer.h"
+#include "io/shm_transport.h"
+#include "io/stream_reader.h"
+#include "io/symbol_index.h"
+#include "io/validate.h"
 #include "market.h"
 #include "robin_hood.h"
 #include "symbol.h"
-#include "utils/sort.h"
+#include "utils/trace.h"
 
 using namespace UBIEngine;
 
-// 假设 IO::pnl_and_pos 和 IO::twap_order 都有大小信息
-bool send_data(const IO::GlobalSocket& gSocket,
-               const std::string& filename,  // <-- File name to be sent
-               const std::vector<IO::pnl_and_pos>& pnls, const std::vector<IO::twap_order>& ans) {
-    int sockfd = gSocket.getSocket();
-
-    // Parse and Send the filename
-    int year, month, day, x, y;
-    sscanf(filename.c_str(), "%4d%2d%2d_%d_%d", &year, &month, &day, &x, &y);
-    std::cout << "filename: " << filename << std::endl;
-    std::cout << "year: " << year << " month: " << month << " day: " << day << " x: " << x
-              << " y: " << y << std::endl;
-    ssize_t bytesWritten = write(sockfd, &year, sizeof(year));
-    if (bytesWritten != sizeof(year)) {
-        return false;
-    }
-    bytesWritten = write(sockfd, &month, sizeof(month));
-    if (bytesWritten != sizeof(month)) {
-        return false;
-    }
-    bytesWritten = write(sockfd, &day, sizeof(day));
-    if (bytesWritten != sizeof(day)) {
-        return false;
-    }
-    bytesWritten = write(sockfd, &x, sizeof(x));
-    if (bytesWritten != sizeof(x)) {
-        return false;
-    }
-    bytesWritten = write(sockfd, &y, sizeof(y));
-    if (bytesWritten != sizeof(y)) {
-        return false;
-    }
-
-    // Send pnls
-    ssize_t bytesToSend = pnls.size() * sizeof(IO::pnl_and_pos);
-    bytesWritten = write(sockfd, pnls.data(), bytesToSend);
-    if (bytesWritten != bytesToSend) {
-        return false;
-    }
-    std::cout << "Successfully sent pnls!" << std::endl;
-
-    // Send ans
-    bytesToSend = ans.size() * sizeof(IO::twap_order);
-    bytesWritten = write(sockfd, ans.data(), bytesToSend);
-    if (bytesWritten != bytesToSend) {
-        return false;
+// Where runSessions() puts the outputs.
+struct OutputSink {
+    IO::ResultWriter& writer;
+    // Check that the outputs are sorted (O(n)) before they are written.
+    bool verify_order = false;
+    // Write twap_order in place through a mapping of the output file (IO::MappedRecords).
+    bool map_twap = false;
+    IO::WriteOptions write_options;
+    // Ship the results to a receiver instead of writing them, if not null.
+    IO::ResultShipper* shipper = nullptr;
+    // Write the results into the shared-memory ring of a receiver on this host, if not null.
+    IO::ShmResultSender* shm = nullptr;
+};
+
+// Throws if `--verify-order` is set and the outputs of the session are not sorted.
+template <typename TwapRecords>
+void verifyOrder(const OutputSink& output, const SessionConfig& config, const TwapRecords& ans,
+                 const std::vector<IO::pnl_and_pos>& pnls) {
+    if (output.verify_order && (!isSortedTwapOutput(ans) || !isSortedPnlOutput(pnls))) {
+        throw std::runtime_error("The outputs of session " + std::to_string(config.session_num) +
+                                 "_" + std::to_string(config.session_length) +
+                                 " are not sorted");
     }
-    std::cout << "Successfully sent ans!" << std::endl;
-
-    return true;
 }
 
-std::future<bool> async_send_data(const IO::GlobalSocket& gSocket,
-                                  const std::string& filename,  // <-- File name to be sent
-                                  const std::vector<IO::pnl_and_pos>& pnls,
-                                  const std::vector<IO::twap_order>& ans) {
-    return std::async(std::launch::async, [&]() {
-        int sockfd = gSocket.getSocket();
-
-        // Parse and Send the filename
-        int year, month, day, x, y;
-        sscanf(filename.c_str(), "%4d%2d%2d_%d_%d", &year, &month, &day, &x, &y);
-        std::cout << "filename: " << filename << std::endl;
-        std::cout << "year: " << year << " month: " << month << " day: " << day << " x: " << x
-                  << " y: " << y << std::endl;
-        ssize_t bytesWritten = write(sockfd, &year, sizeof(year));
-        if (bytesWritten != sizeof(year)) {
-            return false;
-        }
-        bytesWritten = write(sockfd, &month, sizeof(month));
-        if (bytesWritten != sizeof(month)) {
-            return false;
-        }
-        bytesWritten = write(sockfd, &day, sizeof(day));
-        if (bytesWritten != sizeof(day)) {
-            return false;
-        }
-        bytesWritten = write(sockfd, &x, sizeof(x));
-        if (bytesWritten != sizeof(x)) {
-            return false;
-        }
-        bytesWritten = write(sockfd, &y, sizeof(y));
-        if (bytesWritten != sizeof(y)) {
-            return false;
-        }
-
-        // Send pnls
-        ssize_t bytesToSend = pnls.size() * sizeof(IO::pnl_and_pos);
-        bytesWritten = write(sockfd, pnls.data(), bytesToSend);
-        if (bytesWritten != bytesToSend) {
-            return false;
-        }
-        std::cout << "Successfully sent pnls!" << std::endl;
-
-        // Send ans
-        bytesToSend = ans.size() * sizeof(IO::twap_order);
-        bytesWritten = write(sockfd, ans.data(), bytesToSend);
-        if (bytesWritten != bytesToSend) {
-            return false;
-        }
-        std::cout << "Successfully sent ans!" << std::endl;
-
-        return true;
-    });
+// Replays one session with twap_order written straight into its output file.
+template <typename OrderQueue, typename AlphaQueue, typename PrevInfos>
+void runMappedSession(OrderQueue& order_queue, AlphaQueue& alpha_queue,
+                      const PrevInfos& prev_trade_infos, const SessionConfig& config,
+                      const std::string& twap_path, const std::string& pnl_path,
+                      OutputSink& output) {
+    // 文件按 reserve 的大小 fallocate，结束时截断到实际大小，内存中没有第二份拷贝。
+    IO::MappedRecords<IO::twap_order> ans(twap_path, output.write_options.fsync);
+    std::vector<IO::pnl_and_pos> pnls;
+    replaySession(order_queue, alpha_queue, prev_trade_infos, config, ans, pnls);
+    verifyOrder(output, config, ans, pnls);
+    ans.close();
+    IO::writeFiles({{pnl_path, reinterpret_cast<const char*>(pnls.data()),
+                     pnls.size() * sizeof(IO::pnl_and_pos)}},
+                   output.write_options);
+    std::cout << "Finish writing to: " << twap_path << "\n"
+              << "Finish writing to: " << pnl_path << std::endl;
 }
 
-template <typename T>
-bool writeToFile(const std::vector<T>& data, const std::string& filename) {
-    std::ofstream outFile(filename, std::ios::binary);
-
-    if (!outFile.is_open()) {
-        std::cerr << "Error: Couldn't open the file: " << filename << std::endl;
-        return false;
-    }
-
-    outFile.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
-    outFile.close();
-    return true;
-}
-
-// void solve(std::string& dataset_dir_path, IO::GlobalSocket &gSocket) {
-void solve(std::string& dataset_dir_path, std::string& fileActPath) {
-    /* Data Pre-Process */
-    auto order_logs = IO::reader_sync<IO::order_log>(dataset_dir_path + "/order_log");
-    auto order_queue = IO::VectorQueue<IO::order_log>(std::move(order_logs));
-    auto alpha_arr = IO::reader_sync<IO::alpha>(dataset_dir_path + "/alpha");
-    auto alpha_queue = IO::VectorQueue<IO::alpha>(std::move(alpha_arr));
-    auto prev_trade_infos =
-        IO::reader_sync<IO::prev_trade_info>(dataset_dir_path + "/prev_trade_info");
-    std::priority_queue<IO::twap_order, std::vector<IO::twap_order>, IO::priority_cmp>
-        strategy_queue;
-
+template <typename OrderQueue, typename AlphaQueue, typename PrevInfos>
+void runSessions(OrderQueue& order_queue, AlphaQueue& alpha_queue,
+                 const PrevInfos& prev_trade_infos, const std::string& fileActPath,
+                 OutputSink& output) {
     std::vector<uint32_t> session_nums = {3, 3, 3, 5, 5};
     std::vector<uint32_t> session_lengths = {1, 3, 5, 2, 3};
 
     for (int i = 0; i < session_nums.size(); ++i) {
         uint32_t session_num = session_nums[i];
         uint32_t session_length = session_lengths[i];
-        assert(strategy_queue.size() == 0 && "Strategy queue should be empty at the beginning!");
-
-        std::cout << "Start init symbol_manager and market!\n";
-        /* Init market */
-        Market market;
-        // ConcurrentMarket market(1);
-        SymbolManager symbol_manager;
-        for (const auto& prev_info : prev_trade_infos) {
-            // 首先这样可以获得 char[8] to uint32_t 的转换。
-            symbol_manager.getSymbolId(prev_info.instrument_id);
-            // 把对应的 symbol 加入到 market 中。
-            market.addSymbol(symbol_manager.getSymbolId(prev_info.instrument_id),
-                             std::string(prev_info.instrument_id),
-                             static_cast<uint64_t>(prev_info.prev_close_price * 100 + 0.5),
-                             prev_info.prev_position);
+        SessionConfig config{session_num, session_length};
+        std::string session_name =
+            fileActPath + "_" + std::to_string(session_num) + "_" + std::to_string(session_length);
+        std::string twap_path = "../data/output_data/twap_order/" + session_name;
+        std::string pnl_path = "../data/output_data/pnl_and_position/" + session_name;
+
+        if (output.shm != nullptr) {
+            // TWAP 订单直接写进共享内存环，receiver 原地落盘，pnls 在 commit 时追加。
+            auto frame = output.shm->beginFrame(
+                session_name, alpha_queue.size() * session_num, prev_trade_infos.size());
+            std::vector<IO::pnl_and_pos> pnls;
+            replaySession(order_queue, alpha_queue, prev_trade_infos, config, frame.ans, pnls);
+            verifyOrder(output, config, frame.ans, pnls);
+            output.shm->commit(frame, pnls);
+        } else if (output.shipper != nullptr) {
+            // 结果交给发送线程，撮合线程不等网络；队列满时才等待（反压）。
+            IO::ShippedResults results;
+            results.session_name = session_name;
+            replaySession(order_queue, alpha_queue, prev_trade_infos, config, results.ans,
+                          results.pnls);
+            verifyOrder(output, config, results.ans, results.pnls);
+            output.shipper->submit(std::move(results));
+        } else if (output.map_twap) {
+            runMappedSession(order_queue, alpha_queue, prev_trade_infos, config, twap_path,
+                             pnl_path, output);
+        } else {
+            // 结果写在双缓冲里，上一个 session 的文件由写线程落盘，与本次撮合重叠。
+            IO::SessionResults& results = output.writer.acquire();
+            std::vector<IO::twap_order>& ans = results.twap_orders;
+            std::vector<IO::pnl_and_pos>& pnls = results.pnls;
+            replaySession(order_queue, alpha_queue, prev_trade_infos, config, ans, pnls);
+
+            /* 输出已按顺序生成，无需排序，直接写到本地 */
+            verifyOrder(output, config, ans, pnls);
+            results.twap_path = twap_path;
+            results.pnl_path = pnl_path;
+            output.writer.submit();
         }
+        if constexpr (Utils::kTraceEnabled) {
+            std::string trace_name = "../data/output_data/" + session_name + ".trace";
+            if (!Utils::Tracer::instance().dump(trace_name))
+                std::cerr << "Error: Couldn't write the trace: " << trace_name << std::endl;
+        }
+        order_queue.reset();
+        alpha_queue.reset();
+    }
+}
 
-        uint64_t order_id = 0;
-        // 为了方便，直接分配好内存。
-        std::vector<IO::twap_order> ans;
-        ans.reserve(alpha_arr.size() * session_num);
-        int32_t symbol_id_tar = 0x3f3f3f3f;
-        uint64_t cnt = 0;
-        std::cout << "[Start]: " << session_num << "_" << session_length << std::endl;
-        auto start_time = std::chrono::steady_clock::now();
-        /* main loop */
-        while (!order_queue.empty() || !alpha_queue.empty() || !strategy_queue.empty()) {
-            // 即使时间相同，也要先处理order_log。
-            if (!order_queue.empty() &&
-                (alpha_queue.empty() ||
-                 order_queue.front().timestamp <= alpha_queue.front().timestamp) &&
-                (strategy_queue.empty() ||
-                 order_queue.front().timestamp <= strategy_queue.top().timestamp)) {
-                const auto& raw_order = order_queue.front();
-                order_queue.pop();
-                uint32_t symbol_id = symbol_manager.getSymbolId(raw_order.instrument_id);
-                OrderSide side = raw_order.direction == 1 ? OrderSide::Bid : OrderSide::Ask;
-                //! 获取基准价格
-                auto basePrice = market.getBasePrice(symbol_id, side);
-                double price_off_100 = raw_order.price_off * 100;
-                int32_t price_off_int;
-                if (price_off_100 > 0)
-                    price_off_int = static_cast<int32_t>(price_off_100 + 0.5);
-                else
-                    price_off_int = static_cast<int32_t>(price_off_100 - 0.5);
-
-                //! Only LIMIT order has price_off.
-                if (raw_order.type != 0) price_off_int = 0;
-
-                uint32_t price = raw_order.type == 0 ? basePrice + price_off_int : 0;
-                Order order = Order::newOrder(int2OrderType(raw_order.type), side, order_id++,
-                                              symbol_id, raw_order.volume, price,
-                                              false  // is Strategy Order?
-                );
-
-                // ============================================================================================================
-                if (symbol_id == symbol_id_tar || symbol_id_tar == -1) {
-                    double price_t = static_cast<double>(price) / 100;
-                    double basePrice_t = static_cast<double>(basePrice) / 100;
-                    double down_limit =
-                        static_cast<double>(market.getDownLimit(symbol_id, side)) / 100;
-                    double up_limit = static_cast<double>(market.getUpLimit(symbol_id, side)) / 100;
-                    std::cout << "Symbol_id: " << symbol_id << std::endl;
-                    if (raw_order.type == 0)
-                        printf(
-                            "history order: timestamp=%d, direction=%d, order_type=%d, volume=%d, "
-                            "price=%.6lf, base_price=%.6lf, up_limit=%.6lf, down_limit=%.6lf\n",
-                            raw_order.timestamp, raw_order.direction, raw_order.type,
-                            raw_order.volume, price_t, basePrice_t, up_limit, down_limit);
-                    else
-                        printf(
-                            "history order: timestamp=%d, direction=%d, order_type=%d, volume=%d\n",
-                            raw_order.timestamp, raw_order.direction, raw_order.type,
-                            raw_order.volume);
-                }
-                // ============================================================================================================
-
-                // Check 下价格是否合法
-                if (price_off_int < 0 && basePrice < -price_off_int) {
-                    std::cout << ">>>>>>>>>> Price off is too large! <<<<<<<<<<\n";
-                    continue;
-                }
-
-                market.addOrder(order);
-            }
-            // 处理信号
-            if (!alpha_queue.empty() &&
-                (order_queue.empty() ||
-                 alpha_queue.front().timestamp < order_queue.front().timestamp) &&
-                (strategy_queue.empty() ||
-                 alpha_queue.front().timestamp <= strategy_queue.top().timestamp)) {
-                auto alpha_t = alpha_queue.front();
-                alpha_queue.pop();
-
-                uint32_t symbol_id = symbol_manager.getSymbolId(alpha_t.instrument_id);
-                const auto& pnl_helper = market.getPnlHelper(symbol_id);
-                int32_t diff = alpha_t.target_volume - pnl_helper.getPosition();
-
-                //! If diff == 0, skip!!
-                if (diff == 0) continue;
-
-                // 通过 diff 判断是 Bid or Ask
-                int32_t strategy_side = diff > 0 ? 1 : -1;
-                // 并且下单的量肯定是 diff 的绝对值
-                uint64_t volume = std::abs(diff);
-
-                for (int part_id = 0; part_id < session_num; ++part_id) {
-                    int32_t part_volume =
-                        (volume * (part_id + 1) / session_num) - (volume * part_id / session_num);
-                    // if (symbol_id == 1)
-                    // std::cout << "timestap: " << alpha_t.timestamp + part_id * session_length *
-                    // 1000 << " part_volume: " << part_volume
-                    // << " queue_size: " << strategy_queue.size() <<
-                    // << " front: " <<
-                    IO::emplaceTwapOrder_queue(strategy_queue, alpha_t.instrument_id,
-                                               alpha_t.timestamp + part_id * session_length * 1000,
-                                               strategy_side, part_volume,
-                                               static_cast<double>(0)  // ! Note 需要就地构造
-                    );
-                }
-            }
+/**
+ * Trace builds: indexes order_log and alpha by symbol (IO::SymbolIndex) and
+ * reports the events of each traced symbol, so a filter that names a symbol
+ * without events is seen before the replay rather than in an empty trace.
+ */
+template <typename OrderRows, typename AlphaRows>
+void reportTracedSymbols(const OrderRows& order_rows, const AlphaRows& alpha_rows,
+                         const IO::SymbolTable& symbols) {
+    std::vector<uint32_t> traced = Utils::Tracer::instance().tracedSymbols();
+    if (traced.empty()) return;
+    IO::SymbolIndex order_index(order_rows, symbols);
+    IO::SymbolIndex alpha_index(alpha_rows, symbols);
+    for (uint32_t symbol_id : traced) {
+        if (symbol_id >= symbols.size()) {
+            std::cerr << "[Trace]: symbol " << symbol_id << " is not in prev_trade_info"
+                      << std::endl;
+            continue;
+        }
+        std::cout << "[Trace]: symbol " << symbol_id << ": " << order_index.count(symbol_id)
+                  << " order_log, " << alpha_index.count(symbol_id) << " alpha" << std::endl;
+    }
+}
 
-            // 处理策略单
-            if (!strategy_queue.empty() &&
-                (order_queue.empty() ||
-                 strategy_queue.top().timestamp < order_queue.front().timestamp) &&
-                (alpha_queue.empty() ||
-                 strategy_queue.top().timestamp < alpha_queue.front().timestamp)) {
-                auto strategy_order = strategy_queue.top();
-                strategy_queue.pop();
+/**
+ * Validates order_log and alpha (see IO::validateOrders()) and runs the
+ * sessions without the rejected rows. Valid inputs replay unchanged.
+ */
+template <typename OrderRows, typename AlphaRows, typename PrevInfos>
+void runValidatedSessions(OrderRows&& order_rows, AlphaRows&& alpha_rows,
+                          const PrevInfos& prev_trade_infos, const std::string& fileActPath,
+                          OutputSink& output) {
+    IO::SymbolTable symbols(prev_trade_infos);
+    IO::ValidationReport order_report, alpha_report;
+    IO::RejectBitmap order_rejects = IO::validateOrders(order_rows, symbols, &order_report);
+    IO::RejectBitmap alpha_rejects = IO::validateAlphas(alpha_rows, symbols, &alpha_report);
+    if (order_report.rejected != 0)
+        std::cerr << "[Validate]: order_log " << order_report.summary() << std::endl;
+    if (alpha_report.rejected != 0)
+        std::cerr << "[Validate]: alpha " << alpha_report.summary() << std::endl;
+    if constexpr (Utils::kTraceEnabled) reportTracedSymbols(order_rows, alpha_rows, symbols);
+
+    // 被拒绝的 order_log 在按批解码时跳过，撮合循环里没有逐字段的检查。
+    IO::DecodedOrderQueue<OrderRows> order_queue(std::move(order_rows), 1024,
+                                                 std::move(order_rejects));
+    if (alpha_report.rejected == 0) {
+        IO::VectorQueue<IO::alpha, AlphaRows> alpha_queue(std::move(alpha_rows));
+        runSessions(order_queue, alpha_queue, prev_trade_infos, fileActPath, output);
+    } else {
+        // alpha 很小，直接拷贝保留的行。
+        IO::VectorQueue<IO::alpha> alpha_queue(
+            IO::acceptedRecords<IO::alpha>(alpha_rows, alpha_rejects));
+        runSessions(order_queue, alpha_queue, prev_trade_infos, fileActPath, output);
+    }
+}
 
-                uint32_t symbol_id = symbol_manager.getSymbolId(strategy_order.instrument_id);
-                OrderSide side = strategy_order.direction == 1 ? OrderSide::Bid : OrderSide::Ask;
-                //! 获取基准价格.
-                auto basePrice = market.getBasePrice(symbol_id, side);
+// How solve() loads the input files of a date.
+enum class LoadMode {
+    Mmap,        // mmap 映射，按需缺页。
+    Stream,      // order_log 边读边撮合。
+    Bulk,        // 三个文件一次性 io_uring 批量读入内存。
+    BulkDirect,  // 同 Bulk，但使用 O_DIRECT 绕过 page cache。
+    Archive,     // order_log 从列式归档 order_log.archive 按块解码。
+};
 
-                // Must be LIMIT order.
-                uint32_t price = basePrice;
-                double price_double = static_cast<double>(price) / 100;
+// void solve(std::string& dataset_dir_path, IO::GlobalSocket &gSocket) {
+void solve(std::string& dataset_dir_path, std::string& fileActPath, LoadMode mode,
+           OutputSink& output) {
+    /* Data Pre-Process */
+    if (mode == LoadMode::Bulk || mode == LoadMode::BulkDirect) {
+        IO::BulkReadOptions options;
+        options.direct = mode == LoadMode::BulkDirect;
+        IO::BulkReadStats stats;
+        auto buffers = IO::readFiles({dataset_dir_path + "/order_log", dataset_dir_path + "/alpha",
+                                      dataset_dir_path + "/prev_trade_info"},
+                                     options, &stats);
+        std::printf("[Load]: %.3f GB in %.3fs, %.2f GB/s (%s%s)\n", stats.bytes / 1e9,
+                    stats.seconds, stats.gbps(), stats.used_uring ? "io_uring" : "pread",
+                    stats.used_direct ? ", O_DIRECT" : "");
+        IO::RecordBuffer<IO::prev_trade_info> prev_trade_infos(std::move(buffers[2]));
+        runValidatedSessions(IO::RecordBuffer<IO::order_log>(std::move(buffers[0])),
+                             IO::RecordBuffer<IO::alpha>(std::move(buffers[1])),
+                             prev_trade_infos, fileActPath, output);
+        return;
+    }
 
-                // TODO 写到 ans 数组中
-                IO::emplaceTwapOrder_vec(ans, strategy_order.instrument_id,
-                                         strategy_order.timestamp, strategy_order.direction,
-                                         strategy_order.volume, price_double);
+    // 输入文件直接 mmap，加载只有缺页开销，没有拷贝。
+    IO::RecordFile<IO::prev_trade_info> prev_trade_infos(dataset_dir_path + "/prev_trade_info");
+    if (mode == LoadMode::Mmap) {
+        // order_log 先并行校验，再按批解码（AVX2），撮合循环中不再逐条取整和哈希。
+        runValidatedSessions(IO::RecordFile<IO::order_log>(dataset_dir_path + "/order_log"),
+                             IO::RecordFile<IO::alpha>(dataset_dir_path + "/alpha"),
+                             prev_trade_infos, fileActPath, output);
+        return;
+    }
 
-                // ========================================================================
-                // if (symbol_id == symbol_id_tar || symbol_id_tar == -1) {
-                //     printf("twap order: timestamp=%d, direction=%d, volume=%d, price=%.6lf\n",
-                //             strategy_order.timestamp,
-                //             strategy_order.direction,
-                //             strategy_order.volume,
-                //             price_double);
-                // }
-                // ========================================================================
-                // 如果 volume == 0, 则不进入撮合系统.
-                if (strategy_order.volume == 0) continue;
+    IO::VectorQueue<IO::alpha, IO::RecordFile<IO::alpha>> alpha_queue(
+        IO::RecordFile<IO::alpha>(dataset_dir_path + "/alpha"));
+    if (mode == LoadMode::Archive) {
+        // 由 order_log_archive 生成。
+        IO::ArchiveQueue order_queue(dataset_dir_path + "/order_log.archive");
+        runSessions(order_queue, alpha_queue, prev_trade_infos, fileActPath, output);
+    } else {
+        // order_log 边读边撮合，内存占用与文件大小无关。不做整体校验。
+        IO::StreamQueue<IO::order_log> order_queue(dataset_dir_path + "/order_log");
+        runSessions(order_queue, alpha_queue, prev_trade_infos, fileActPath, output);
+    }
+}
 
-                Order order = Order::newOrder(OrderType::LIMIT, side, order_id++, symbol_id,
-                                              strategy_order.volume, price,
-                                              true  // is Strategy Order?
-                );
-                market.addOrder(order);
+int main(int argc, char* argv[]) {
+    // `--stream`: stream order_log from disk during the replay instead of loading it first.
+    // `--bulk`: read the files of a date into memory with one batch of io_uring reads.
+    // `--direct`: like `--bulk`, with O_DIRECT.
+    // `--archive`: decode order_log from `order_log.archive` (see IO/OrderLog/archive.cpp).
+    // `--fsync=data|full`: fdatasync/fsync every output file before it counts as written.
+    // `--verify-order`: check that every session's outputs are sorted before writing them.
+    // `--mmap-output`: write twap_order in place through a mapping of the output file.
+    // `--ship=<ip>:<port>`: send the results to a result_receiver instead of writing them.
+    // `--compress`: with `--ship`, send twap_order with the wire codec (io/result_codec.h).
+    // `--shm=<name>`: hand the results to `result_receiver --shm=<name>` on this host, one
+    //                 engine per ring.
+    LoadMode mode = LoadMode::Mmap;
+    IO::WriteOptions write_options;
+    bool verify_order = false;
+    bool map_twap = false;
+    std::unique_ptr<IO::ResultShipper> shipper;
+    IO::ShipperOptions ship_options;
+    bool ship = false;
+    std::string shm_name;
+    std::unique_ptr<IO::ShmResultSender> shm;
+    auto usage = [&] {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--stream | --bulk | --direct | --archive] [--fsync=data|full]"
+                  << " [--verify-order] [--mmap-output | --ship=<ip>:<port> [--compress]"
+                  << " | --shm=<name>]\n"
+                  << "  --shm=<name> needs a receiver of its own, one engine per ring."
+                  << std::endl;
+        return 1;
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stream") {
+            mode = LoadMode::Stream;
+        } else if (arg == "--bulk") {
+            mode = LoadMode::Bulk;
+        } else if (arg == "--direct") {
+            mode = LoadMode::BulkDirect;
+        } else if (arg == "--archive") {
+            mode = LoadMode::Archive;
+        } else if (arg == "--fsync=data") {
+            write_options.fsync = IO::FsyncPolicy::Data;
+        } else if (arg == "--fsync=full") {
+            write_options.fsync = IO::FsyncPolicy::Full;
+        } else if (arg == "--verify-order") {
+            verify_order = true;
+        } else if (arg == "--mmap-output") {
+            map_twap = true;
+        } else if (arg.rfind("--ship=", 0) == 0 && arg.find(':') != std::string::npos) {
+            ship_options.host = arg.substr(7, arg.rfind(':') - 7);
+            std::string port = arg.substr(arg.rfind(':') + 1);
+            char* end = nullptr;
+            long value = std::strtol(port.c_str(), &end, 10);
+            if (port.empty() || *end != '\0' || value <= 0 || value > 65535) {
+                std::cerr << "Bad port: " << port << std::endl;
+                return usage();
             }
-            // ++cnt;
-            // if (cnt >= 20000) break;
+            ship_options.port = static_cast<uint16_t>(value);
+            ship = true;
+        } else if (arg == "--compress") {
+            ship_options.compress = true;
+        } else if (arg.rfind("--shm=", 0) == 0 && arg.size() > 6) {
+            shm_name = arg.substr(6);
+        } else {
+            return usage();
         }
-
-        auto end_time = std::chrono::steady_clock::now();
-        std::cout << "[Done]: " << session_num << "_" << session_length << " Cost Time: "
-                  << static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                             end_time - start_time)
-                                             .count()) /
-                         1000
-                  << "s" << std::endl;
-
-        std::vector<IO::pnl_and_pos> pnls;
-        for (const auto& prev_info : prev_trade_infos) {
-            // 首先这样可以获得 char[8] to uint32_t 的转换。
-            int64_t pnl = market.calculatePnl(symbol_manager.getSymbolId(prev_info.instrument_id));
-            double pnl_double = static_cast<double>(pnl) / 100;
-            IO::emplacePnlAndPos_vec(
-                pnls, prev_info.instrument_id,
-                market.getPnlHelper(symbol_manager.getSymbolId(prev_info.instrument_id))
-                    .getPosition(),
-                pnl_double);
-        }
-
-        /* 排序后写到本地 */
-        Utils::multiThreadSort(ans, Utils::my_compare_twap);
-        Utils::multiThreadSort(pnls, Utils::my_compare_pnl);
-        std::string target_twap_name = "../data/output_data/twap_order/" + fileActPath + "_" +
-                                       std::to_string(session_num) + "_" +
-                                       std::to_string(session_length);
-        std::string target_pnl_name = "../data/output_data/pnl_and_position/" + fileActPath + "_" +
-                                      std::to_string(session_num) + "_" +
-                                      std::to_string(session_length);
-        writeToFile<IO::twap_order>(ans, target_twap_name);
-        std::cout << "Finish writing to: " << target_twap_name << std::endl;
-        writeToFile<IO::pnl_and_pos>(pnls, target_pnl_name);
-        std::cout << "Finish writing to: " << target_pnl_name << std::endl;
-        order_queue.reset();
-        alpha_queue.reset();
-        while (!strategy_queue.empty()) strategy_queue.pop();
     }
-}
-
-int main() {
+    // 输出只有一个去处，不悄悄地按优先级选一个。
+    if (int(map_twap) + int(ship) + int(!shm_name.empty()) > 1) {
+        std::cerr << "--mmap-output, --ship and --shm can not be combined" << std::endl;
+        return usage();
+    }
+    if (ship_options.compress && !ship) {
+        std::cerr << "--compress needs --ship" << std::endl;
+        return usage();
+    }
+    if (!shm_name.empty()) shm = std::make_unique<IO::ShmResultSender>(shm_name);
+    if (ship) shipper = std::make_unique<IO::ResultShipper>(ship_options);
+    // 输出由后台线程写出，各日期、各 session 共用。
+    IO::ResultWriter writer(write_options, true);
+    OutputSink output{writer, verify_order, map_twap, write_options, shipper.get(), shm.get()};
     // Assume the input dataset path is {Project_Dir}/data/input_data.
     boost::filesystem::path p("../data/input_data/");
     for (auto& entry : boost::filesystem::directory_iterator(p)) {
         std::cout << entry.path().filename().string() << std::endl;
         std::string dataset_dir_path = entry.path().string();
         std::string fileActPath = entry.path().filename().string();
-        solve(dataset_dir_path, fileActPath);
+        solve(dataset_dir_path, fileActPath, mode, output);
+    }
+    writer.flush();
+    if (shipper) {
+        shipper->close();
+        IO::ShipperStats stats = shipper->stats();
+        std::printf("[Ship]: %lu sent, %lu dropped, %lu reconnects, latency p50 %luus p99 %luus "
+                    "max %luus\n",
+                    stats.sent, stats.dropped, stats.reconnects, stats.p50_us, stats.p99_us,
+                    stats.max_us);
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -1,20 +1,124 @@
+#include <algorithm>
 #include "concurrent_market.h"
 #include "map_orderbook.h"
 
 namespace UBIEngine {
+void MarketCommand::apply(OrderBookHandler &handler) const
+{
+    switch (type)
+    {
+        case MarketCommandType::AddSymbol:
+            handler.addOrderBook(symbol_id, add_symbol.name,
+                add_symbol.previous_close_price, add_symbol.previous_position);
+            break;
+        case MarketCommandType::DeleteSymbol:
+            handler.deleteOrderBook(symbol_id, add_symbol.name);
+            break;
+        case MarketCommandType::AddOrder:
+            handler.addOrder(order());
+            break;
+        case MarketCommandType::DeleteOrder:
+            handler.deleteOrder(symbol_id, delete_order.order_id);
+            break;
+        case MarketCommandType::ExecuteOrder:
+            handler.executeOrder(symbol_id, execute.order_id, execute.quantity);
+            break;
+        case MarketCommandType::ExecuteOrderAt:
+            handler.executeOrder(symbol_id, execute.order_id, execute.quantity, execute.price);
+            break;
+        case MarketCommandType::Query:
+            query.result->set_value(handler.toString());
+            break;
+    }
+}
+
 ConcurrentMarket::ConcurrentMarket(uint8_t num_threads)
-    : thread_pool(num_threads)
-    , symbol_submission_index(0)
+    : symbol_submission_index(0)
+    , running(true)
+    , worker_joiner(workers)
 {
     assert(num_threads > 0 && "The number of threads must be positive!");
     orderbook_handlers.clear();
-    id_to_submission_index.clear();
+    id_to_route.clear();
     id_to_symbol.clear();
     for (uint8_t i = 0; i < num_threads; ++i)
+    {
         orderbook_handlers.push_back(std::make_unique<OrderBookHandler>());
+        command_queues.push_back(std::make_unique<SpscQueue<MarketCommand>>(kCommandCapacity));
+    }
+    worker_commands.assign(num_threads, 0);
+    worker_stats = std::make_unique<WorkerStats[]>(num_threads);
+    workers.reserve(num_threads);
+    try
+    {
+        for (uint8_t i = 0; i < num_threads; ++i)
+            workers.emplace_back(&ConcurrentMarket::workerThread, this, i);
+    }
+    catch (...)
+    {
+        running = false;
+        throw;
+    }
     std::cout << "Finish Concurrent-Market constructor" << std::endl;
 }
 
+ConcurrentMarket::~ConcurrentMarket()
+{
+    running = false;
+}
+
+void ConcurrentMarket::workerThread(uint32_t submission_index)
+{
+    SpscQueue<MarketCommand> &queue = *command_queues[submission_index];
+    OrderBookHandler &orderbook_handler = *orderbook_handlers[submission_index];
+    // The book and the snapshot slot of each symbol of this worker.
+    struct Published
+    {
+        const MapOrderBook *book;
+        SymbolSnapshotSlot *slot;
+    };
+    robin_hood::unordered_map<uint32_t, Published> published;
+    auto apply = [&](const MarketCommand &command) {
+        command.apply(orderbook_handler);
+        switch (command.type)
+        {
+            case MarketCommandType::AddSymbol:
+                published[command.symbol_id] = {
+                    orderbook_handler.getOrderBook(command.symbol_id).get(),
+                    command.add_symbol.snapshot};
+                break;
+            case MarketCommandType::DeleteSymbol:
+                published.erase(command.symbol_id);
+                return;
+            case MarketCommandType::Query:
+                return;
+            default:
+                break;
+        }
+        auto it = published.find(command.symbol_id);
+        if (it != published.end())
+            it->second.slot->store({it->second.book->prices(), it->second.book->getPnlHelper()});
+    };
+    std::atomic<uint64_t> &busy_ns = worker_stats[submission_index].busy_ns;
+    while (true)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (queue.tryPopBatch(apply, kCommandBatch) != 0)
+        {
+            auto busy = std::chrono::steady_clock::now() - start;
+            // The only writer, no read-modify-write needed.
+            busy_ns.store(busy_ns.load(std::memory_order_relaxed)
+                + std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count(),
+                std::memory_order_relaxed);
+            continue;
+        }
+        // Apply everything submitted before the market is destroyed.
+        if (!running && queue.empty())
+            return;
+        std::this_thread::yield();
+    }
+}
+
 void ConcurrentMarket::addSymbol(
     uint32_t symbol_id,
     const std::string &symbol_name,
@@ -24,104 +128,144 @@ void ConcurrentMarket::addSymbol(
     auto it = id_to_symbol.find(symbol_id);
     assert(it == id_to_symbol.end() && "Symbol already exists!");
     id_to_symbol.insert({symbol_id, std::make_unique<Symbol>(symbol_id, symbol_name)});
-    id_to_submission_index.insert({symbol_id, symbol_submission_index});
-    OrderBookHandler *orderbook_handler = orderbook_handlers[symbol_submission_index].get();
-    // std::cout << "Add Symbol" << std::endl;
-    thread_pool.submitTask(symbol_submission_index,
-        [=] { 
-            orderbook_handler->addOrderBook(
-            symbol_id, symbol_name,
-            previous_close_price, previous_position); 
-        }
-    );
-    updateSymbolSubmissionIndex();
+    uint32_t submission_index = newSymbolSubmissionIndex(symbol_id);
+    id_to_route.insert({symbol_id, SymbolRoute{submission_index, 0}});
+    // Readers see the new book until the worker publishes it.
+    SymbolSnapshot initial{BookPrices(), PnlHelper(previous_close_price, previous_position)};
+    initial.prices.previous_close_price = previous_close_price;
+    auto &slot = id_to_snapshot[symbol_id];
+    slot = std::make_unique<SymbolSnapshotSlot>(initial);
+    submit(route(symbol_id), MarketCommandType::AddSymbol, symbol_id,
+        [&](MarketCommand &command) {
+            command.add_symbol.previous_close_price = previous_close_price;
+            command.add_symbol.previous_position = previous_position;
+            command.setSymbolName(symbol_name);
+            command.add_symbol.snapshot = slot.get();
+        });
 }
 
 void ConcurrentMarket::deleteSymbol(uint32_t symbol_id)
 {
     auto it = id_to_symbol.find(symbol_id);
     assert(it != id_to_symbol.end() && "Symbol does not exist!");
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[symbol_submission_index].get();
-    thread_pool.submitTask(submission_index, [=] { orderbook_handler->deleteOrderBook(symbol_id, it->second->name); });
+    submit(route(symbol_id), MarketCommandType::DeleteSymbol, symbol_id,
+        [&](MarketCommand &command) { command.setSymbolName(it->second->name); });
     id_to_symbol.erase(symbol_id);
-    id_to_submission_index.erase(symbol_id);
+    id_to_route.erase(symbol_id);
+    auto snapshot_it = id_to_snapshot.find(symbol_id);
+    retired_snapshots.push_back(std::move(snapshot_it->second));
+    id_to_snapshot.erase(snapshot_it);
 }
 
 void ConcurrentMarket::addOrder(const Order &order)
 {
-    uint32_t submission_index = getSubmissionIndex(order.getSymbolID());
-    std::cout << "Sumission index: " << submission_index << std::endl;
-    assert (submission_index == 0 && "Submission index must be 0");
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();
-    thread_pool.submitTask(submission_index, [=] { orderbook_handler->addOrder(order); });
+    submit(route(order.getSymbolID()), MarketCommandType::AddOrder, order.getSymbolID(),
+        [&](MarketCommand &command) { command.setOrder(order); });
 }
 
 void ConcurrentMarket::deleteOrder(uint32_t symbol_id, uint64_t order_id)
 {
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();
-    thread_pool.submitTask(submission_index, [=] { orderbook_handler->deleteOrder(symbol_id, order_id); });
+    submit(route(symbol_id), MarketCommandType::DeleteOrder, symbol_id,
+        [&](MarketCommand &command) { command.delete_order.order_id = order_id; });
 }
 
 void ConcurrentMarket::executeOrder(uint32_t symbol_id, uint64_t order_id, uint64_t quantity, uint64_t price)
 {
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();
-    thread_pool.submitTask(submission_index, [=] { orderbook_handler->executeOrder(symbol_id, order_id, quantity, price); });
+    submit(route(symbol_id), MarketCommandType::ExecuteOrderAt, symbol_id,
+        [&](MarketCommand &command) {
+            command.execute.order_id = order_id;
+            command.execute.quantity = quantity;
+            command.execute.price = price;
+        });
 }
 
 void ConcurrentMarket::executeOrder(uint32_t symbol_id, uint64_t order_id, uint64_t quantity)
 {
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();
-    thread_pool.submitTask(submission_index, [=] { orderbook_handler->executeOrder(symbol_id, order_id, quantity); });
+    submit(route(symbol_id), MarketCommandType::ExecuteOrder, symbol_id,
+        [&](MarketCommand &command) {
+            command.execute.order_id = order_id;
+            command.execute.quantity = quantity;
+        });
+}
+
+const SymbolSnapshotSlot &ConcurrentMarket::getSnapshotSlot(uint32_t symbol_id) const
+{
+    auto it = id_to_snapshot.find(symbol_id);
+    assert(it != id_to_snapshot.end() && "Symbol does not exist!");
+    return *it->second;
+}
+
+SymbolSnapshot ConcurrentMarket::snapshot(uint32_t symbol_id) const
+{
+    return getSnapshotSlot(symbol_id).load();
 }
 
-const uint64_t ConcurrentMarket::getBasePrice(uint32_t symbol_id, OrderSide side) {
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();
-    return orderbook_handler->getOrderBook(symbol_id)->getBasePrice(side);
+const uint64_t ConcurrentMarket::getBasePrice(uint32_t symbol_id, OrderSide side) const
+{
+    return snapshot(symbol_id).prices.basePrice(side);
+}
+
+const uint64_t ConcurrentMarket::getDownLimit(uint32_t symbol_id, OrderSide side) const
+{
+    return snapshot(symbol_id).prices.downLimit(side);
 }
 
-const uint64_t ConcurrentMarket::getDownLimit(uint32_t symbol_id, OrderSide side)
+const uint64_t ConcurrentMarket::getUpLimit(uint32_t symbol_id, OrderSide side) const
 {
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();   
-    return orderbook_handler->getOrderBook(symbol_id)->getDownLimit(side);
+    return snapshot(symbol_id).prices.upLimit(side);
 }
 
-const uint64_t ConcurrentMarket::getUpLimit(uint32_t symbol_id, OrderSide side)
+PnlHelper ConcurrentMarket::getPnlHelper(uint32_t symbol_id) const
 {
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();
-    return orderbook_handler->getOrderBook(symbol_id)->getUpLimit(side);
+    return snapshot(symbol_id).pnl_helper;
 }
 
-const PnlHelper& ConcurrentMarket::getPnlHelper(uint32_t symbol_id) const {
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();
-    return orderbook_handler->getOrderBook(symbol_id)->getPnlHelper();
+const int64_t ConcurrentMarket::calculatePnl(uint32_t symbol_id) const
+{
+    // Position and last price from the same snapshot.
+    SymbolSnapshot symbol = snapshot(symbol_id);
+    return symbol.pnl_helper.calculatePnl(symbol.prices.last_traded_price);
 }
 
-const int64_t ConcurrentMarket::calculatePnl(uint32_t symbol_id) const {
-    uint32_t submission_index = getSubmissionIndex(symbol_id);
-    OrderBookHandler *orderbook_handler = orderbook_handlers[submission_index].get();
-    auto& pnl_helper = getPnlHelper(symbol_id);
-    uint64_t last_execute_price = orderbook_handler->getOrderBook(symbol_id)->lastTradedPrice();
-    return pnl_helper.calculatePnl(last_execute_price);
+void ConcurrentMarket::sync() const
+{
+    // A worker releases the slots of its ring after applying the commands in them.
+    for (const auto &queue : command_queues)
+    {
+        while (!queue->empty())
+            std::this_thread::yield();
+    }
 }
 
-const uint32_t ConcurrentMarket::getSubmissionIndex(uint32_t symbol_id) const
+uint32_t ConcurrentMarket::getWorker(uint32_t symbol_id) const
 {
-    auto it = id_to_submission_index.find(symbol_id);
-    return it == id_to_submission_index.end() ? 0 : it->second;
+    auto it = id_to_route.find(symbol_id);
+    assert(it != id_to_route.end() && "Symbol does not exist!");
+    return it->second.submission_index;
 }
 
-uint32_t ConcurrentMarket::getSubmissionIndex(uint32_t symbol_id)
+uint32_t ConcurrentMarket::route(uint32_t symbol_id)
 {
-    auto it = id_to_submission_index.find(symbol_id);
-    return it == id_to_submission_index.end() ? 0 : it->second;
+    auto it = id_to_route.find(symbol_id);
+    if (it == id_to_route.end())
+        return 0;
+    ++it->second.commands;
+    ++worker_commands[it->second.submission_index];
+    return it->second.submission_index;
+}
+
+uint32_t ConcurrentMarket::newSymbolSubmissionIndex(uint32_t symbol_id)
+{
+    auto it = planned_submission_index.find(symbol_id);
+    if (it != planned_submission_index.end())
+    {
+        uint32_t submission_index = it->second;
+        planned_submission_index.erase(it);
+        return submission_index;
+    }
+    uint32_t submission_index = symbol_submission_index;
+    updateSymbolSubmissionIndex();
+    return submission_index;
 }
 
 void ConcurrentMarket::updateSymbolSubmissionIndex()
@@ -129,14 +273,70 @@ void ConcurrentMarket::updateSymbolSubmissionIndex()
     symbol_submission_index = (symbol_submission_index + 1) % orderbook_handlers.size();
 }
 
+void ConcurrentMarket::placeSymbols(const SymbolLoads &loads)
+{
+    for (const auto &[symbol_id, submission_index] :
+        packSymbols(loads, static_cast<uint32_t>(orderbook_handlers.size())))
+        planned_submission_index[symbol_id] = submission_index;
+}
+
+robin_hood::unordered_map<uint32_t, uint32_t> ConcurrentMarket::packSymbols(
+    const SymbolLoads &loads, uint32_t num_workers)
+{
+    assert(num_workers > 0 && "The number of workers must be positive!");
+    std::vector<std::pair<uint32_t, uint64_t>> symbols;
+    symbols.reserve(loads.size());
+    for (const auto &[symbol_id, load] : loads)
+        symbols.emplace_back(symbol_id, load);
+    std::sort(symbols.begin(), symbols.end(), [](const auto &a, const auto &b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    std::vector<uint64_t> worker_loads(num_workers, 0);
+    robin_hood::unordered_map<uint32_t, uint32_t> placement;
+    placement.reserve(symbols.size());
+    for (const auto &[symbol_id, load] : symbols)
+    {
+        // Few workers, a scan is cheaper than a heap.
+        auto lightest = std::min_element(worker_loads.begin(), worker_loads.end());
+        *lightest += load;
+        placement[symbol_id] = static_cast<uint32_t>(lightest - worker_loads.begin());
+    }
+    return placement;
+}
+
+std::vector<uint64_t> ConcurrentMarket::busyNanoseconds() const
+{
+    std::vector<uint64_t> busy(orderbook_handlers.size());
+    for (size_t i = 0; i < busy.size(); ++i)
+        busy[i] = worker_stats[i].busy_ns.load(std::memory_order_relaxed);
+    return busy;
+}
+
+SymbolLoads ConcurrentMarket::measuredLoads() const
+{
+    std::vector<uint64_t> busy = busyNanoseconds();
+    SymbolLoads loads;
+    loads.reserve(id_to_route.size());
+    for (const auto &[symbol_id, symbol_route] : id_to_route)
+    {
+        uint64_t commands = worker_commands[symbol_route.submission_index];
+        double share = commands == 0 ? 0 : double(symbol_route.commands) / double(commands);
+        loads[symbol_id] = static_cast<uint64_t>(busy[symbol_route.submission_index] * share);
+    }
+    return loads;
+}
+
 std::string ConcurrentMarket::toString()
 {
     std::string market_string;
-    std::vector<std::future<std::string>> futures(orderbook_handlers.size());
-    for (uint32_t i = 0; i < futures.size(); ++i)
+    std::vector<std::promise<std::string>> results(orderbook_handlers.size());
+    std::vector<std::future<std::string>> futures;
+    for (auto &result : results)
+        futures.push_back(result.get_future());
+    for (uint32_t i = 0; i < results.size(); ++i)
     {
-        OrderBookHandler *orderbook_handler = orderbook_handlers[i].get();
-        futures[i] = thread_pool.submitWaitableTask(i, [=] { return orderbook_handler->toString(); });
+        submit(i, MarketCommandType::Query, 0,
+            [&](MarketCommand &command) { command.query.result = &results[i]; });
     }
     for (auto &future : futures)
         market_string += future.get();
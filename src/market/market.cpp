@@ -14,8 +14,16 @@ void OrderBookHandler::addOrderBook(
 {
     auto it = id_to_book.find(symbol_id);
     assert(it == id_to_book.end() && "Symbol already exists!");
-    id_to_book.insert({symbol_id, std::make_unique<MapOrderBook>(
-        symbol_id, previous_close_price, previous_position)});
+    auto book = std::make_unique<MapOrderBook>(symbol_id, previous_close_price, previous_position);
+    book->setListener(listener);
+    id_to_book.insert({symbol_id, std::move(book)});
+}
+
+void OrderBookHandler::setListener(BookListener *listener_)
+{
+    listener = listener_;
+    for (auto &entry : id_to_book)
+        entry.second->setListener(listener);
 }
 
 void OrderBookHandler::deleteOrderBook(uint32_t symbol_id, std::string symbol_name)
@@ -143,6 +151,22 @@ const uint64_t Market::getUpLimit(uint32_t symbol_id, OrderSide side)
     return orderbook_handler->getOrderBook(symbol_id)->getUpLimit(side);
 }
 
+const Order *Market::findOrder(uint32_t symbol_id, uint64_t order_id) const
+{
+    const auto &book = orderbook_handler->getOrderBook(symbol_id);
+    return book->hasOrder(order_id) ? &book->getOrder(order_id) : nullptr;
+}
+
+uint64_t Market::lastAddedExecutedQuantity(uint32_t symbol_id) const
+{
+    return orderbook_handler->getOrderBook(symbol_id)->lastAddedExecutedQuantity();
+}
+
+void Market::setBookListener(BookListener *listener)
+{
+    orderbook_handler->setListener(listener);
+}
+
 const PnlHelper& Market::getPnlHelper(uint32_t symbol_id) const {
     return orderbook_handler->getOrderBook(symbol_id)->getPnlHelper();
 }
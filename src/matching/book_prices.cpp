@@ -0,0 +1,71 @@
+#include <algorithm>
+#include "book_prices.h"
+
+namespace UBIEngine {
+uint64_t BookPrices::basePrice(OrderSide side) const {
+    if(side == OrderSide::Bid) {
+        // For buy orders
+        if(has_asks) {
+            return best_ask;
+        } else if(has_bids) {
+            return best_bid;
+        } else if(last_traded_price != 0) {
+            return last_traded_price;
+        } else {
+            return previous_close_price;
+        }
+    } else {
+        // For sell orders
+        if(has_bids) {
+            return best_bid;
+        } else if(has_asks) {
+            return best_ask;
+        } else if(last_traded_price != 0) {
+            return last_traded_price;
+        } else {
+            return previous_close_price;
+        }
+    }
+}
+
+uint64_t BookPrices::downLimit(OrderSide side) const {
+    uint64_t basePrice_ = basePrice(side);
+    // Assuming minimal increment is 1.
+    uint64_t minIncrement = 1;
+
+    // 10% decrease.
+    uint64_t minLimit =
+        static_cast<uint64_t>(previous_close_price * 0.90 + 0.5);
+
+    uint64_t minBase =
+        static_cast<uint64_t>(basePrice_ * 0.98 + 0.5);
+
+    uint64_t adjustedMin =
+        (basePrice_ > 10 * minIncrement)
+            ? std::min(minBase, basePrice_ - 10 * minIncrement)
+            : 0;
+    if (side == OrderSide::Bid)
+        return minLimit;
+    else
+        return std::max(adjustedMin, minLimit);
+}
+
+uint64_t BookPrices::upLimit(OrderSide side) const {
+    uint64_t basePrice_ = basePrice(side);
+    // Assuming minimal increment is 1.
+    uint64_t minIncrement = 1;
+
+    // 10% increase.
+    uint64_t maxLimit =
+        static_cast<uint64_t>(previous_close_price * 1.10 + 0.5);
+    uint64_t maxBase =
+        static_cast<uint64_t>(basePrice_ * 1.02 + 0.5);
+    uint64_t adjustedMax =
+        std::max(maxBase, basePrice_ + 10 * minIncrement);
+
+    if (side == OrderSide::Bid)
+        return std::min(adjustedMax, maxLimit);
+    else
+        return maxLimit;
+}
+} // namespace UBIEngine
@@ -35,6 +35,7 @@ void MapOrderBook::addOrder(Order order) {
         throw std::runtime_error("Invalid order type!");
         break;
     }
+    last_added_executed_quantity = order.getExecutedQuantity();
     VALIDATE_ORDERBOOK;
 }
 
@@ -54,8 +55,12 @@ void MapOrderBook::executeOrder(
     executing_level.reduceVolume(
         executing_order.getLastExecutedQuantity()
     );
+    if (listener != nullptr)
+        listener->onTrade(symbol_id, price, executing_order.getLastExecutedQuantity());
     if (executing_order.isFilled())
         deleteOrder(order_id, true);
+    else
+        publishLevel(executing_order.getSide(), executing_order.getPrice());
     VALIDATE_ORDERBOOK;
 }
 
@@ -75,8 +80,12 @@ void MapOrderBook::executeOrder(uint64_t order_id, uint64_t quantity) {
     executing_level.reduceVolume(
         executing_order.getLastExecutedQuantity()
     );
+    if (listener != nullptr)
+        listener->onTrade(symbol_id, executing_price, executing_order.getLastExecutedQuantity());
     if (executing_order.isFilled())
         deleteOrder(order_id, true);
+    else
+        publishLevel(executing_order.getSide(), executing_price);
     VALIDATE_ORDERBOOK;
 }
 
@@ -92,6 +101,8 @@ void MapOrderBook::deleteOrder(uint64_t order_id, bool notification) {
         throw std::runtime_error("Order does not exist!");
     auto &levels_it = orders_it->second.level_it;
     Order &deleting_order = orders_it->second.order;
+    OrderSide side = deleting_order.getSide();
+    uint64_t price = levels_it->first;
     levels_it->second.deleteOrder(deleting_order);
     if (levels_it->second.empty()) {
         switch (deleting_order.getType()) {
@@ -110,80 +121,19 @@ void MapOrderBook::deleteOrder(uint64_t order_id, bool notification) {
         }
     }
     orders.erase(orders_it);
+    publishLevel(side, price);
 }
 
 uint64_t MapOrderBook::getBasePrice(OrderSide side) const {
-    // std::cout << "====== getBasePrice ======" << std::endl;
-    // std::cout << "| bestAsk: " << bestAsk() << std::endl;
-    // std::cout << "| bestBid: " << bestBid() << std::endl;
-    // std::cout << "| lastTradedPrice: " << lastTradedPrice() << std::endl;
-    // std::cout << "| previousClosePrice: " << previousClosePrice() << std::endl;
-    // std::cout << "==========================\n" << std::endl;
-
-    if(side == OrderSide::Bid) {
-        // For buy orders
-        if(!ask_levels.empty()) {
-            return bestAsk();
-        } else if(!bid_levels.empty()) {
-            return bestBid();
-        } else if(last_traded_price != 0) {
-            return lastTradedPrice();
-        } else {
-            return previousClosePrice();
-        }
-    } else {
-        // For sell orders
-        if(!bid_levels.empty()) {
-            return bestBid();
-        } else if(!ask_levels.empty()) {
-            return bestAsk();
-        } else if(last_traded_price != 0) {
-            return lastTradedPrice();
-        } else {
-            return previousClosePrice();
-        }
-    }
+    return prices().basePrice(side);
 }
 
 uint64_t MapOrderBook::getDownLimit(OrderSide side) const {
-    uint64_t basePrice = getBasePrice(side);
-    // Assuming minimal increment is 1.
-    uint64_t minIncrement = 1;
-
-    // 10% decrease.
-    uint64_t minLimit =
-        static_cast<uint64_t>(previousClosePrice() * 0.90 + 0.5);
-
-    uint64_t minBase =
-        static_cast<uint64_t>(basePrice * 0.98 + 0.5);
-
-    uint64_t adjustedMin = 
-        (basePrice > 10 * minIncrement) 
-            ? std::min(minBase, basePrice - 10 * minIncrement) 
-            : 0;
-    if (side == OrderSide::Bid)
-        return minLimit;
-    else
-        return std::max(adjustedMin, minLimit);
+    return prices().downLimit(side);
 }
 
 uint64_t MapOrderBook::getUpLimit(OrderSide side) const {
-        uint64_t basePrice = getBasePrice(side);
-    // Assuming minimal increment is 1.
-    uint64_t minIncrement = 1;
-
-    // 10% increase.
-    uint64_t maxLimit = 
-        static_cast<uint64_t>(previousClosePrice() * 1.10 + 0.5);
-    uint64_t maxBase = 
-            static_cast<uint64_t>(basePrice * 1.02 + 0.5);
-    uint64_t adjustedMax =
-            std::max(maxBase, basePrice + 10 * minIncrement);
-
-    if (side == OrderSide::Bid)
-        return std::min(adjustedMax, maxLimit);
-    else
-        return maxLimit;
+    return prices().upLimit(side);
 }
 
 bool MapOrderBook::isPriceWithinAllowedRange(const Order &order) const {
@@ -270,6 +220,13 @@ void MapOrderBook::insertLimitOrder(const Order &order) {
             OrderWrapper{order, level_it});
         level_it->second.addOrder(orders_it->second.order);
     }
+    publishLevel(order.getSide(), order.getPrice());
+}
+
+void MapOrderBook::publishLevelSlow(OrderSide side, uint64_t price) const {
+    const auto &levels = side == OrderSide::Ask ? ask_levels : bid_levels;
+    auto it = levels.find(price);
+    listener->onLevel(symbol_id, side, price, it == levels.end() ? 0 : it->second.getVolume());
 }
 
 void MapOrderBook::addMarketOrder(Order &order) {
@@ -357,6 +314,8 @@ void MapOrderBook::match(Order &order) {
             bid_level.reduceVolume(bid_order.getLastExecutedQuantity());
             if (bid_order.isFilled())
                 deleteOrder(bid_order.getOrderID(), true);
+            else
+                publishLevel(bid_order.getSide(), executing_price);
             // ! Reset the level iterator - iterator may be invalidated
             // ! if the order is deleted.
             // ! 由于我们不交易完当前的 level 就不会去下一个 level，所以不需要
@@ -378,6 +337,8 @@ void MapOrderBook::match(Order &order) {
             ask_level.reduceVolume(ask_order.getLastExecutedQuantity());
             if (ask_order.isFilled())
                 deleteOrder(ask_order.getOrderID(), true);
+            else
+                publishLevel(ask_order.getSide(), executing_price);
             // ! Reset the level iterator - iterator may be invalidated
             // ! if the order is deleted.
             ask_levels_it = ask_levels.begin();
@@ -397,6 +358,8 @@ void MapOrderBook::executeOrders(
     bid.execute(executing_price, matched_quantity);
     ask.execute(executing_price, matched_quantity);
     last_traded_price = executing_price;
+    if (listener != nullptr)
+        listener->onTrade(symbol_id, executing_price, matched_quantity);
     // 考虑策略单的情况，如果是策略单，那么需要更新 PnlHelper.
     if (bid.isStrategyOrder()) {
         assert (bid.getType() == OrderType::LIMIT
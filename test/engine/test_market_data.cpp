@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "engine/market_data_publisher.h"
+#include "market.h"
+
+using namespace UBIEngine;
+
+namespace {
+std::vector<IO::prev_trade_info> prevInfos() {
+    std::vector<IO::prev_trade_info> infos(2);
+    std::strcpy(infos[0].instrument_id, "000001");
+    infos[0].prev_close_price = 10.0;
+    infos[0].prev_position = 0;
+    std::strcpy(infos[1].instrument_id, "000002");
+    infos[1].prev_close_price = 20.0;
+    infos[1].prev_position = 0;
+    return infos;
+}
+
+// A market whose book changes go to a publisher, and a feed that receives them on loopback.
+class MarketDataTest : public ::testing::Test {
+   protected:
+    void SetUp() override { start(MarketDataOptions()); }
+
+    void start(MarketDataOptions options) {
+        feed = std::make_unique<IO::MarketDataFeed>(IO::FeedOptions());
+        options.port = feed->port();
+        publisher = std::make_unique<MarketDataPublisher>(prevInfos(), options);
+        feed->setRecoveryServer("127.0.0.1", publisher->recoveryPort());
+        market = std::make_unique<Market>();
+        market->addSymbol(0, "000001", 1000);
+        market->addSymbol(1, "000002", 2000);
+        market->setBookListener(publisher.get());
+    }
+
+    void add(OrderSide side, uint64_t price, uint64_t quantity, uint32_t symbol = 0) {
+        market->addOrder(Order::newOrder(OrderType::LIMIT, side, ++order_id, symbol, quantity,
+                                         price));
+    }
+
+    // Polls the feed until it applied everything the publisher sent.
+    bool catchUp() {
+        publisher->flush();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (feed->nextSequence() <= publisher->lastSequence()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            feed->poll(50);
+        }
+        return true;
+    }
+
+    std::unique_ptr<IO::MarketDataFeed> feed;
+    std::unique_ptr<MarketDataPublisher> publisher;
+    std::unique_ptr<Market> market;
+    uint64_t order_id = 0;
+};
+
+using Levels = std::map<uint64_t, uint64_t>;
+
+Levels bidsOf(const IO::L2Book& book) { return Levels(book.bids.begin(), book.bids.end()); }
+Levels asksOf(const IO::L2Book& book) { return Levels(book.asks.begin(), book.asks.end()); }
+
+}  // namespace
+
+TEST_F(MarketDataTest, FeedFollowsTheBook) {
+    std::vector<uint64_t> trades;
+    feed->onTrade([&](const IO::TradeMessage& trade) { trades.push_back(trade.quantity); });
+    add(OrderSide::Ask, 1001, 100);
+    add(OrderSide::Ask, 1002, 200);
+    add(OrderSide::Bid, 999, 50);
+    add(OrderSide::Bid, 998, 70);
+    add(OrderSide::Bid, 1001, 30);  // Trades 30 at 1001.
+    add(OrderSide::Bid, 2000, 10, 1);
+    ASSERT_TRUE(catchUp());
+
+    const IO::L2Book* book = feed->book(0);
+    ASSERT_NE(book, nullptr);
+    EXPECT_EQ(bidsOf(*book), (Levels{{999, 50}, {998, 70}}));
+    EXPECT_EQ(asksOf(*book), (Levels{{1001, 70}, {1002, 200}}));
+    EXPECT_EQ(book->last_price, 1001u);
+    ASSERT_NE(feed->book(1), nullptr);
+    EXPECT_EQ(bidsOf(*feed->book(1)), (Levels{{2000, 10}}));
+    EXPECT_EQ(feed->gaps(), 0u);
+
+    // Sweeping the asks removes their levels.
+    add(OrderSide::Bid, 1002, 270);
+    ASSERT_TRUE(catchUp());
+    EXPECT_TRUE(feed->book(0)->asks.empty());
+    EXPECT_EQ(feed->book(0)->last_price, 1002u);
+    // The first recovery only happened because the feed joined.
+    EXPECT_EQ(feed->recoveries(), 1u);
+    // Trades seen in sequence, the ones before the first recovery are part of its snapshot.
+    EXPECT_FALSE(trades.empty());
+}
+
+TEST_F(MarketDataTest, RecoversFromAGap) {
+    add(OrderSide::Ask, 1001, 100);
+    ASSERT_TRUE(catchUp());
+    uint64_t recoveries = feed->recoveries();
+
+    // A heartbeat from the future: the feed has missed messages.
+    IO::MarketDataPacketHeader header{IO::kMarketDataMagic, IO::kMarketDataVersion, 0,
+                                      feed->nextSequence() + 5};
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(feed->port());
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(sendto(fd, &header, sizeof(header), 0, reinterpret_cast<sockaddr*>(&addr),
+                     sizeof(addr)),
+              ssize_t(sizeof(header)));
+    close(fd);
+    ASSERT_TRUE(feed->poll(5000));
+    EXPECT_EQ(feed->gaps(), 1u);
+    EXPECT_EQ(feed->recoveries(), recoveries + 1);
+    EXPECT_EQ(asksOf(*feed->book(0)), (Levels{{1001, 100}}));
+
+    // The stream goes on after the recovery.
+    add(OrderSide::Bid, 1001, 40);
+    ASSERT_TRUE(catchUp());
+    EXPECT_EQ(asksOf(*feed->book(0)), (Levels{{1001, 60}}));
+}
+
+TEST_F(MarketDataTest, LateJoinerRecovers) {
+    uint16_t port = feed->port();
+    feed.reset();  // Nobody listens, these packets are lost.
+    add(OrderSide::Ask, 1005, 10);
+    add(OrderSide::Bid, 995, 20);
+    publisher->flush();
+
+    IO::FeedOptions options;
+    options.port = port;
+    options.recovery_port = publisher->recoveryPort();
+    feed = std::make_unique<IO::MarketDataFeed>(options);
+    // The next heartbeat makes the feed recover.
+    ASSERT_TRUE(feed->poll(5000));
+    EXPECT_EQ(feed->recoveries(), 1u);
+    EXPECT_EQ(asksOf(*feed->book(0)), (Levels{{1005, 10}}));
+    EXPECT_EQ(bidsOf(*feed->book(0)), (Levels{{995, 20}}));
+    EXPECT_EQ(feed->nextSequence(), publisher->lastSequence() + 1);
+}
+
+TEST_F(MarketDataTest, TruncatedSnapshotsKeepDeeperLevels) {
+    MarketDataOptions options;
+    options.snapshot_depth = 2;
+    options.snapshot_interval = std::chrono::milliseconds(10);
+    start(options);
+    for (uint64_t i = 0; i < 5; ++i) add(OrderSide::Ask, 1001 + i, 10 + i);
+    ASSERT_TRUE(catchUp());
+    // Let a few snapshots through.
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while (std::chrono::steady_clock::now() < until) feed->poll(10);
+    EXPECT_EQ(asksOf(*feed->book(0)),
+              (Levels{{1001, 10}, {1002, 11}, {1003, 12}, {1004, 13}, {1005, 14}}));
+    EXPECT_EQ(feed->gaps(), 0u);
+    EXPECT_GT(publisher->stats().packets, 1u);
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "engine/order_gateway.h"
+
+using namespace UBIEngine;
+
+namespace {
+std::vector<IO::prev_trade_info> prevInfos() {
+    std::vector<IO::prev_trade_info> infos(2);
+    std::strcpy(infos[0].instrument_id, "000001");
+    infos[0].prev_close_price = 10.0;
+    infos[0].prev_position = 0;
+    std::strcpy(infos[1].instrument_id, "000002");
+    infos[1].prev_close_price = 20.0;
+    infos[1].prev_position = 0;
+    return infos;
+}
+
+IO::order_log orderOf(const char* instrument, int type, int direction, int volume,
+                      double price_off = 0) {
+    IO::order_log order{};
+    std::strncpy(order.instrument_id, instrument, sizeof(order.instrument_id));
+    order.type = type;
+    order.direction = direction;
+    order.volume = volume;
+    order.price_off = price_off;
+    return order;
+}
+
+// A gateway serving on its own thread.
+class GatewayTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        OrderGatewayOptions options;
+        options.spin = 0;  // The tests may run on one CPU.
+        gateway = std::make_unique<OrderGateway>(prevInfos(), options);
+        server = std::thread([this] { gateway->run(); });
+    }
+
+    void TearDown() override {
+        gateway->stop();
+        server.join();
+    }
+
+    std::unique_ptr<OrderGateway> gateway;
+    std::thread server;
+};
+
+IO::AckMessage receiveAck(IO::OrderEntryClient& client) {
+    IO::OrderEntryMessage message;
+    EXPECT_TRUE(client.receive(message));
+    EXPECT_EQ(message.header.type, uint16_t(IO::OrderEntryType::Ack));
+    return message.ack;
+}
+
+IO::ExecutionReportMessage receiveReport(IO::OrderEntryClient& client) {
+    IO::OrderEntryMessage message;
+    EXPECT_TRUE(client.receive(message));
+    EXPECT_EQ(message.header.type, uint16_t(IO::OrderEntryType::ExecutionReport));
+    return message.report;
+}
+}  // namespace
+
+TEST_F(GatewayTest, MatchesAndCancels) {
+    IO::OrderEntryClient client("127.0.0.1", gateway->port());
+
+    // An ask 5 ticks above the previous close rests.
+    client.sendNewOrder(7, orderOf("000001", 0, -1, 100, 0.05));
+    IO::AckMessage ack = receiveAck(client);
+    EXPECT_EQ(ack.client_order_id, 7u);
+    EXPECT_EQ(ack.accepted, 1);
+    uint64_t ask_id = ack.order_id;
+    EXPECT_NE(ask_id, 0u);
+    IO::ExecutionReportMessage report = receiveReport(client);
+    EXPECT_EQ(report.order_id, ask_id);
+    EXPECT_EQ(report.status, uint8_t(IO::ExecutionStatus::New));
+    EXPECT_EQ(report.executed_quantity, 0u);
+    EXPECT_EQ(report.open_quantity, 100u);
+
+    // A bid at the best ask fills against it.
+    client.sendNewOrder(8, orderOf("000001", 0, 1, 40));
+    ack = receiveAck(client);
+    EXPECT_EQ(ack.accepted, 1);
+    report = receiveReport(client);
+    EXPECT_EQ(report.client_order_id, 8u);
+    EXPECT_EQ(report.status, uint8_t(IO::ExecutionStatus::Filled));
+    EXPECT_EQ(report.executed_quantity, 40u);
+    EXPECT_EQ(report.open_quantity, 0u);
+
+    client.sendCancel(9, ask_id, "000001");
+    ack = receiveAck(client);
+    EXPECT_EQ(ack.accepted, 1);
+    report = receiveReport(client);
+    EXPECT_EQ(report.status, uint8_t(IO::ExecutionStatus::Cancelled));
+    EXPECT_EQ(report.executed_quantity, 40u);
+    EXPECT_EQ(report.open_quantity, 60u);
+
+    // The order is gone now.
+    client.sendCancel(10, ask_id, "000001");
+    ack = receiveAck(client);
+    EXPECT_EQ(ack.accepted, 0);
+    EXPECT_EQ(ack.reason, uint8_t(IO::OrderEntryReject::UnknownOrder));
+    EXPECT_EQ(gateway->requests(), 4u);
+}
+
+TEST_F(GatewayTest, OnlyTheOwnerCancels) {
+    IO::OrderEntryClient owner("127.0.0.1", gateway->port());
+    IO::OrderEntryClient other("127.0.0.1", gateway->port());
+
+    owner.sendNewOrder(1, orderOf("000002", 0, 1, 100, -0.05));
+    uint64_t bid_id = receiveAck(owner).order_id;
+    EXPECT_EQ(receiveReport(owner).status, uint8_t(IO::ExecutionStatus::New));
+
+    // Another connection can not cancel it, even with the right id and symbol.
+    other.sendCancel(2, bid_id, "000002");
+    IO::AckMessage ack = receiveAck(other);
+    EXPECT_EQ(ack.accepted, 0);
+    EXPECT_EQ(ack.reason, uint8_t(IO::OrderEntryReject::UnknownOrder));
+
+    owner.sendCancel(3, bid_id, "000002");
+    ack = receiveAck(owner);
+    EXPECT_EQ(ack.accepted, 1);
+    EXPECT_EQ(receiveReport(owner).status, uint8_t(IO::ExecutionStatus::Cancelled));
+
+    // A resting order filled by another connection's order can not be cancelled either.
+    owner.sendNewOrder(4, orderOf("000002", 0, -1, 50, 0.05));
+    uint64_t ask_id = receiveAck(owner).order_id;
+    receiveReport(owner);
+    other.sendNewOrder(5, orderOf("000002", 1, 1, 50));
+    receiveAck(other);
+    EXPECT_EQ(receiveReport(other).status, uint8_t(IO::ExecutionStatus::Filled));
+    owner.sendCancel(6, ask_id, "000002");
+    ack = receiveAck(owner);
+    EXPECT_EQ(ack.accepted, 0);
+    EXPECT_EQ(ack.reason, uint8_t(IO::OrderEntryReject::UnknownOrder));
+}
+
+TEST_F(GatewayTest, RejectsLikeValidation) {
+    IO::OrderEntryClient client("127.0.0.1", gateway->port());
+    struct Case {
+        IO::order_log order;
+        IO::OrderEntryReject reason;
+    } cases[] = {
+        {orderOf("000001", 9, 1, 10), IO::OrderEntryReject::UnknownType},
+        {orderOf("000001", 0, 0, 10), IO::OrderEntryReject::BadDirection},
+        {orderOf("000001", 0, 1, 0), IO::OrderEntryReject::NonPositiveVolume},
+        {orderOf("999999", 0, 1, 10), IO::OrderEntryReject::UnknownSymbol},
+        {orderOf("000001", 0, -1, 10, -20.0), IO::OrderEntryReject::PriceOutOfRange},
+    };
+    uint64_t id = 0;
+    for (const auto& c : cases) client.sendNewOrder(++id, c.order);
+    id = 0;
+    // Rejects get no execution report, so the acks follow each other.
+    for (const auto& c : cases) {
+        IO::AckMessage ack = receiveAck(client);
+        EXPECT_EQ(ack.client_order_id, ++id);
+        EXPECT_EQ(ack.accepted, 0);
+        EXPECT_EQ(ack.order_id, 0u);
+        EXPECT_EQ(ack.reason, uint8_t(c.reason));
+    }
+}
+
+TEST_F(GatewayTest, PipelinedClientsGetRepliesInOrder) {
+    constexpr int kClients = 3;
+    constexpr uint64_t kOrders = 2000;
+    std::vector<std::thread> threads;
+    std::vector<int> failures(kClients, 0);
+    for (int c = 0; c < kClients; ++c) {
+        threads.emplace_back([&, c] {
+            IO::OrderEntryClient client("127.0.0.1", gateway->port());
+            const char* instrument = c % 2 == 0 ? "000001" : "000002";
+            // Everything is sent before reading, the gateway must buffer the replies.
+            for (uint64_t i = 0; i < kOrders; ++i)
+                client.sendNewOrder(i, orderOf(instrument, 0, i % 2 == 0 ? 1 : -1, 1 + i % 7,
+                                               (i % 2 == 0 ? -0.01 : 0.01) * (1 + i % 5)));
+            IO::OrderEntryMessage message;
+            for (uint64_t i = 0; i < kOrders; ++i) {
+                if (!client.receive(message) ||
+                    message.header.type != uint16_t(IO::OrderEntryType::Ack) ||
+                    message.ack.client_order_id != i || !message.ack.accepted) {
+                    ++failures[c];
+                    return;
+                }
+                if (!client.receive(message) ||
+                    message.report.header.type != uint16_t(IO::OrderEntryType::ExecutionReport) ||
+                    message.report.client_order_id != i) {
+                    ++failures[c];
+                    return;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (int c = 0; c < kClients; ++c) EXPECT_EQ(failures[c], 0) << "client " << c;
+    EXPECT_EQ(gateway->requests(), kClients * kOrders);
+}
+
+TEST_F(GatewayTest, ClosesConnectionOnBadMessage) {
+    IO::OrderEntryClient client("127.0.0.1", gateway->port());
+    IO::OrderEntryHeader header{uint16_t(IO::OrderEntryType::Ack), sizeof(IO::AckMessage)};
+    ASSERT_EQ(send(client.socket(), &header, sizeof(header), MSG_NOSIGNAL),
+              ssize_t(sizeof(header)));
+    IO::OrderEntryMessage message;
+    EXPECT_FALSE(client.receive(message));
+
+    // Other clients are still served.
+    IO::OrderEntryClient other("127.0.0.1", gateway->port());
+    other.sendNewOrder(1, orderOf("000002", 0, 1, 10));
+    EXPECT_EQ(receiveAck(other).accepted, 1);
+}
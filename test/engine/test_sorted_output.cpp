@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "engine/sorted_output.h"
+
+using namespace UBIEngine;
+
+TEST(SortedOutputTest, matchesStableSort) {
+    std::mt19937 rng(5);
+    std::vector<IO::twap_order> emitted;
+    long timestamp = 0;
+    for (int i = 0; i < 20000; ++i) {
+        if (rng() % 3 == 0) timestamp += 1 + rng() % 1000;
+        IO::twap_order order{};
+        std::snprintf(order.instrument_id, 8, "%06u", static_cast<unsigned>(rng() % 40));
+        order.timestamp = timestamp;
+        order.volume = i;  // Tells equal keys apart.
+        emitted.push_back(order);
+    }
+    // Out of order orders are not emitted by the replay, but still land at their place.
+    emitted[5000].timestamp = 3;
+    emitted[12000].timestamp -= 5000;
+
+    std::vector<IO::twap_order> ans;
+    SortedTwapOutput output(ans);
+    for (const auto& order : emitted) {
+        output.emplace(order.instrument_id, order.timestamp, order.direction, order.volume,
+                       order.price);
+    }
+    output.finish();
+    auto expected = emitted;
+    std::stable_sort(expected.begin(), expected.end(), Utils::my_compare_twap);
+    ASSERT_EQ(ans.size(), expected.size());
+    for (size_t i = 0; i < ans.size(); ++i) {
+        ASSERT_EQ(ans[i].timestamp, expected[i].timestamp) << i;
+        ASSERT_EQ(ans[i].volume, expected[i].volume) << i;
+    }
+    EXPECT_TRUE(isSortedTwapOutput(ans));
+    std::swap(ans[10], ans[11000]);
+    EXPECT_FALSE(isSortedTwapOutput(ans));
+}
+
+TEST(SortedOutputTest, wideGroupsAreSortedOnce) {
+    // Every instrument shares each timestamp and arrives in reverse key order,
+    // the worst case of sorting by insertion.
+    constexpr int kInstruments = 20000;
+    std::vector<IO::twap_order> ans;
+    {
+        SortedTwapOutput output(ans);
+        for (long timestamp = 1; timestamp <= 3; ++timestamp) {
+            for (int i = kInstruments - 1; i >= 0; --i) {
+                char id[8];
+                std::snprintf(id, sizeof(id), "%06d", i);
+                output.emplace(id, timestamp, 1, static_cast<int32_t>(timestamp), 1.0);
+            }
+        }
+        // The last group is sorted when the output goes away.
+    }
+    ASSERT_EQ(ans.size(), 3u * kInstruments);
+    EXPECT_TRUE(isSortedTwapOutput(ans));
+    EXPECT_STREQ(ans[0].instrument_id, "000000");
+    EXPECT_STREQ(ans.back().instrument_id, "019999");
+}
+
+TEST(SortedOutputTest, instrumentOrder) {
+    std::vector<IO::prev_trade_info> prev_trade_infos(4);
+    const char* ids[] = {"600010", "000001", "600010", "300002"};
+    for (size_t i = 0; i < prev_trade_infos.size(); ++i) {
+        std::snprintf(prev_trade_infos[i].instrument_id, 8, "%s", ids[i]);
+    }
+    EXPECT_EQ(instrumentOrder(prev_trade_infos), (std::vector<uint32_t>{1, 3, 0, 2}));
+}
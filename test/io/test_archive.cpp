@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "io/archive.h"
+
+using namespace UBIEngine;
+
+namespace {
+std::string tempPath() {
+    char path[] = "/tmp/ubi_test_archive_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    return path;
+}
+
+IO::order_log makeRow(const char* instrument_id, long timestamp, int type, int direction,
+                      int volume, double price_off) {
+    IO::order_log row{};
+    std::strncpy(row.instrument_id, instrument_id, sizeof(row.instrument_id));
+    row.timestamp = timestamp;
+    row.type = type;
+    row.direction = direction;
+    row.volume = volume;
+    row.price_off = price_off;
+    return row;
+}
+
+std::vector<IO::order_event> decodeAll(const IO::OrderArchive& archive) {
+    std::vector<IO::order_event> events;
+    for (size_t b = 0; b < archive.blockCount(); ++b) {
+        size_t offset = events.size();
+        events.resize(offset + archive.block(b).count);
+        archive.decodeBlock(b, events.data() + offset);
+    }
+    return events;
+}
+}  // namespace
+
+TEST(ArchiveTest, roundTrip) {
+    std::mt19937_64 rng(7);
+    const char* instruments[] = {"600000", "000001", "12345678", "300750"};
+    std::vector<IO::order_log> rows;
+    long timestamp = 93000000;
+    for (int i = 0; i < 10000; ++i) {
+        // Equal, small, large and backwards timestamp steps.
+        int step = i % 97 == 0 ? 5000000 : i % 89 == 0 ? -3 : static_cast<int>(rng() % 3);
+        timestamp += step;
+        int type = static_cast<int>(rng() % 6);
+        double price_off = (static_cast<int>(rng() % 2001) - 1000) / 100.0 + 0.004;
+        rows.push_back(makeRow(instruments[rng() % 4], timestamp, type, rng() % 2 ? 1 : -1,
+                               static_cast<int>(rng() % 50 + 1) * 100, price_off));
+    }
+    rows.push_back(makeRow("600000", timestamp, 0, 1, 7, -0.005));  // Breaks the volume gcd.
+
+    std::string path = tempPath();
+    {
+        IO::OrderArchiveWriter writer(path, 1000);
+        for (const auto& row : rows) writer.append(row);
+        writer.close();
+    }
+    IO::OrderArchive archive(path);
+    EXPECT_EQ(archive.size(), rows.size());
+    EXPECT_EQ(archive.blockCount(), 11);
+    EXPECT_EQ(archive.dictionarySize(), 4);
+    EXPECT_LT(archive.bytes(), rows.size() * sizeof(IO::order_log) / 4);
+
+    auto events = decodeAll(archive);
+    ASSERT_EQ(events.size(), rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        EXPECT_EQ(events[i].timestamp, rows[i].timestamp) << i;
+        EXPECT_STREQ(archive.instrumentId(events[i].instrument),
+                     std::string(rows[i].instrument_id, 8).c_str());
+        EXPECT_EQ(events[i].type, rows[i].type);
+        EXPECT_EQ(events[i].direction, rows[i].direction);
+        EXPECT_EQ(events[i].volume, rows[i].volume);
+        EXPECT_EQ(events[i].price_off_ticks, IO::priceOffTicks(rows[i]));
+    }
+    std::remove(path.c_str());
+}
+
+TEST(ArchiveTest, queue) {
+    std::string path = tempPath();
+    {
+        IO::OrderArchiveWriter writer(path, 2);
+        for (int i = 0; i < 5; ++i) writer.append(makeRow("600000", 100 + i, 0, 1, 100, 0.01 * i));
+        writer.close();
+    }
+    IO::ArchiveQueue queue(path);
+    EXPECT_EQ(queue.size(), 5);
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 5; ++i) {
+            ASSERT_FALSE(queue.empty());
+            EXPECT_EQ(queue.front().timestamp, 100 + i);
+            EXPECT_EQ(queue.front().price_off_ticks, i);
+            queue.pop();
+        }
+        EXPECT_TRUE(queue.empty());
+        queue.reset();
+    }
+    std::remove(path.c_str());
+}
+
+TEST(ArchiveTest, emptyAndInvalid) {
+    std::string path = tempPath();
+    IO::OrderArchiveWriter(path).close();
+    IO::ArchiveQueue queue(path);
+    EXPECT_TRUE(queue.empty());
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    std::fputs("not an archive, just some text", file);
+    std::fclose(file);
+    EXPECT_THROW(IO::OrderArchive archive(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ArchiveTest, failedConversionLeavesNoArchive) {
+    std::string path = tempPath();
+    std::remove(path.c_str());
+    {
+        IO::OrderArchiveWriter writer(path, 2);
+        for (int i = 0; i < 5; ++i) writer.append(makeRow("600000", 100 + i, 0, 1, 100, 0.0));
+        EXPECT_THROW(writer.append(makeRow("600000", 105, 9, 1, 100, 0.0)), std::runtime_error);
+        EXPECT_THROW(writer.close(), std::runtime_error);
+    }
+    {
+        // Destroyed without close(), e.g. while an exception unwinds.
+        IO::OrderArchiveWriter writer(path, 2);
+        for (int i = 0; i < 5; ++i) writer.append(makeRow("600000", 100 + i, 0, 1, 100, 0.0));
+    }
+    EXPECT_FALSE(std::filesystem::exists(path));
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+}
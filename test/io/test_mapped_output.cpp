@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "engine/sorted_output.h"
+#include "io/mapped_output.h"
+
+using namespace UBIEngine;
+
+namespace {
+std::string tempPath() {
+    char path[] = "/tmp/ubi_test_mapped_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    return path;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+template <typename T>
+std::string bytesOf(const std::vector<T>& records) {
+    return std::string(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+}
+}  // namespace
+
+TEST(MappedOutputTest, growsAndTruncates) {
+    std::string path = tempPath();
+    std::vector<IO::pnl_and_pos> expected;
+    {
+        // Starts with room for 2 records, so the mapping is grown several times.
+        IO::MappedRecords<IO::pnl_and_pos> records(path, IO::FsyncPolicy::Data, 2);
+        for (int i = 0; i < 1000; ++i) {
+            IO::pnl_and_pos pnl{};
+            std::snprintf(pnl.instrument_id, sizeof(pnl.instrument_id), "%06d", i);
+            pnl.position = i;
+            records.push_back(pnl);
+            expected.push_back(pnl);
+            if (i % 10 == 0) {
+                records.insert(records.begin() + i / 2, pnl);
+                expected.insert(expected.begin() + i / 2, pnl);
+            }
+        }
+        ASSERT_EQ(records.size(), expected.size());
+        EXPECT_GE(records.capacity(), records.size());
+        EXPECT_EQ(records.back().position, 999);
+        records.reserve(100000);  // Preallocated space is cut off by close().
+        records.close();
+    }
+    EXPECT_EQ(readFile(path), bytesOf(expected));
+    std::remove(path.c_str());
+}
+
+TEST(MappedOutputTest, emptyAndUnclosed) {
+    std::string path = tempPath();
+    { IO::MappedRecords<IO::twap_order> records(path, IO::FsyncPolicy::None, 4096); }
+    EXPECT_EQ(readFile(path), "");
+
+    IO::twap_order order{};
+    order.timestamp = 42;
+    {
+        // The destructor closes the file as well.
+        IO::MappedRecords<IO::twap_order> records(path);
+        records.push_back(order);
+    }
+    EXPECT_EQ(readFile(path), bytesOf(std::vector<IO::twap_order>{order}));
+    std::remove(path.c_str());
+    EXPECT_THROW(IO::MappedRecords<IO::twap_order>("/nonexistent/dir/file"), std::runtime_error);
+}
+
+TEST(MappedOutputTest, failedPreallocationLeavesNothing) {
+    auto openFiles = [] {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator("/proc/self/fd")) {
+            (void)entry;
+            ++count;
+        }
+        return count;
+    };
+    std::string path = tempPath();
+    size_t before = openFiles();
+    // Larger than any file system allows.
+    EXPECT_THROW(IO::MappedRecords<IO::twap_order>(path, IO::FsyncPolicy::None, size_t(1) << 55),
+                 std::runtime_error);
+    EXPECT_EQ(openFiles(), before);
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(MappedOutputTest, sortedTwapOutputInPlace) {
+    std::mt19937 rng(3);
+    std::string path = tempPath();
+    std::vector<IO::twap_order> ans;
+    IO::MappedRecords<IO::twap_order> mapped(path, IO::FsyncPolicy::None, 16);
+    SortedTwapOutput to_vector(ans);
+    SortedTwapOutput to_file(mapped);
+    long timestamp = 0;
+    for (int i = 0; i < 5000; ++i) {
+        if (rng() % 4 == 0) timestamp += 1 + rng() % 100;
+        char id[8];
+        std::snprintf(id, sizeof(id), "%06u", static_cast<unsigned>(rng() % 30));
+        to_vector.emplace(id, timestamp, i % 2, i, 1.5);
+        to_file.emplace(id, timestamp, i % 2, i, 1.5);
+    }
+    to_vector.finish();
+    to_file.finish();
+    EXPECT_TRUE(isSortedTwapOutput(mapped));
+    mapped.close();
+    EXPECT_EQ(readFile(path), bytesOf(ans));
+    std::remove(path.c_str());
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "io/order_decoder.h"
+
+using namespace UBIEngine;
+
+namespace {
+std::vector<IO::order_log> makeRows(size_t count) {
+    std::mt19937_64 rng(11);
+    std::vector<IO::order_log> rows(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto& row = rows[i];
+        std::snprintf(row.instrument_id, sizeof(row.instrument_id), "%06d",
+                      static_cast<int>(rng() % 7));
+        row.timestamp = 93000000 + i;
+        row.type = static_cast<int>(rng() % 7);  // 6 is not a known type.
+        row.direction = static_cast<int>(rng() % 3) - 1;
+        row.volume = static_cast<int>(rng() % 100000);
+        switch (i % 4) {
+            // Prices close to the rounding boundaries are the interesting ones.
+            case 0: row.price_off = (static_cast<int>(rng() % 20001) - 10000) / 100.0; break;
+            case 1: row.price_off = (static_cast<int>(rng() % 2001) - 1000) / 1000.0 + 0.005; break;
+            case 2: {
+                double boundary = std::nextafter(0.005, rng() % 2 ? 1.0 : -1.0);
+                row.price_off = rng() % 2 ? boundary : -boundary;
+                break;
+            }
+            default: row.price_off = static_cast<double>(rng() % 2000000) / 1e4 - 100; break;
+        }
+    }
+    return rows;
+}
+}  // namespace
+
+TEST(OrderDecoderTest, avx2MatchesScalar) {
+    if (!IO::hasAvx2Decoder()) GTEST_SKIP() << "AVX2 is not supported";
+    // Not a multiple of 8, so the scalar tail runs too.
+    auto rows = makeRows(100003);
+    IO::OrderColumns scalar, simd;
+    scalar.resize(rows.size());
+    simd.resize(rows.size());
+    IO::decodeOrdersScalar(rows.data(), rows.size(), scalar);
+    IO::decodeOrdersAvx2(rows.data(), rows.size(), simd);
+    EXPECT_EQ(simd.side, scalar.side);
+    EXPECT_EQ(simd.type, scalar.type);
+    EXPECT_EQ(simd.price_off_ticks, scalar.price_off_ticks);
+    EXPECT_EQ(simd.volume, scalar.volume);
+}
+
+TEST(OrderDecoderTest, scalarMatchesReplay) {
+    auto rows = makeRows(1000);
+    IO::OrderColumns columns;
+    IO::decodeOrders(rows.data(), rows.size(), columns);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        EXPECT_EQ(columns.side[i], rows[i].direction == 1 ? 1 : -1);
+        EXPECT_EQ(columns.type[i], rows[i].type);
+        EXPECT_EQ(columns.price_off_ticks[i], IO::priceOffTicks(rows[i]));
+        EXPECT_EQ(columns.volume[i], rows[i].volume);
+    }
+}
+
+TEST(OrderDecoderTest, decodedQueue) {
+    auto rows = makeRows(2500);
+    IO::DecodedOrderQueue<std::vector<IO::order_log>> queue(std::vector<IO::order_log>(rows),
+                                                            1000);
+    EXPECT_EQ(queue.size(), rows.size());
+    for (int round = 0; round < 2; ++round) {
+        for (const auto& row : rows) {
+            ASSERT_FALSE(queue.empty());
+            const auto& event = queue.front();
+            EXPECT_EQ(event.timestamp, row.timestamp);
+            EXPECT_STREQ(queue.instrumentId(event.instrument), row.instrument_id);
+            EXPECT_EQ(event.price_off_ticks, IO::priceOffTicks(row));
+            queue.pop();
+        }
+        EXPECT_TRUE(queue.empty());
+        queue.reset();
+    }
+}
+
+TEST(OrderDecoderTest, decodedQueueSkipsRejects) {
+    auto rows = makeRows(700);
+    IO::RejectBitmap rejects(rows.size());
+    // Batches of 100 rows straddle the 64-row words; word 3 is rejected as a whole.
+    for (size_t i = 0; i < rows.size(); ++i)
+        if (i % 37 == 5 || (i >= 192 && i < 256) || i == rows.size() - 1) rejects.reject(i);
+    IO::DecodedOrderQueue<std::vector<IO::order_log>> queue(std::vector<IO::order_log>(rows), 100,
+                                                            rejects);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (rejects.rejected(i)) continue;
+        ASSERT_FALSE(queue.empty()) << i;
+        EXPECT_EQ(queue.front().timestamp, rows[i].timestamp) << i;
+        queue.pop();
+    }
+    EXPECT_TRUE(queue.empty());
+}
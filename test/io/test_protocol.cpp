@@ -0,0 +1,211 @@
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "io/protocol.h"
+
+using namespace UBIEngine;
+
+namespace {
+void fill(std::vector<IO::pnl_and_pos>& pnls, std::vector<IO::twap_order>& ans, int count) {
+    for (int i = 0; i < 7; ++i) {
+        IO::pnl_and_pos pnl{};
+        std::snprintf(pnl.instrument_id, sizeof(pnl.instrument_id), "%06d", i);
+        pnl.position = i;
+        pnls.push_back(pnl);
+    }
+    for (int i = 0; i < count; ++i) {
+        IO::twap_order order{};
+        std::snprintf(order.instrument_id, sizeof(order.instrument_id), "%06d", i % 7);
+        order.timestamp = i;
+        order.volume = i * 3;
+        ans.push_back(order);
+    }
+}
+
+// A connected TCP pair on the loopback interface.
+std::pair<int, int> tcpPair() {
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    listen(server, 1);
+    getsockname(server, reinterpret_cast<sockaddr*>(&addr), &len);
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    int accepted = accept(server, nullptr, nullptr);
+    close(server);
+    return {client, accepted};
+}
+}  // namespace
+
+TEST(ProtocolTest, header) {
+    IO::ResultFrameHeader header = IO::makeResultHeader("20160202_5_3", 10, 200);
+    EXPECT_EQ(header.year, 2016);
+    EXPECT_EQ(header.month, 2);
+    EXPECT_EQ(header.day, 2);
+    EXPECT_EQ(header.session_num, 5u);
+    EXPECT_EQ(header.session_length, 3u);
+    EXPECT_EQ(IO::sessionName(header), "20160202_5_3");
+    EXPECT_THROW(IO::makeResultHeader("output", 0, 0), std::invalid_argument);
+}
+
+TEST(ProtocolTest, framesRoundTrip) {
+    std::vector<IO::pnl_and_pos> pnls;
+    std::vector<IO::twap_order> ans;
+    fill(pnls, ans, 200000);  // Larger than the socket buffers.
+
+    for (bool zerocopy : {false, true}) {
+        auto [client, server] = tcpPair();
+        std::thread sender([&, client = client] {
+            IO::FrameSendOptions options;
+            options.zerocopy = zerocopy;
+            IO::sendResultFrame(client, IO::makeResultHeader("20160202_3_1", 7, ans.size()),
+                                pnls, ans, options);
+            IO::sendResultFrame(client, IO::makeResultHeader("20160203_5_2", 0, 0), {}, {},
+                                options);
+            close(client);
+        });
+        IO::ResultFrameHeader header;
+        std::vector<IO::pnl_and_pos> got_pnls;
+        std::vector<IO::twap_order> got_ans;
+        ASSERT_TRUE(IO::receiveResultFrame(server, header, got_pnls, got_ans));
+        EXPECT_EQ(IO::sessionName(header), "20160202_3_1");
+        ASSERT_EQ(got_ans.size(), ans.size());
+        EXPECT_EQ(std::memcmp(got_ans.data(), ans.data(), ans.size() * sizeof(IO::twap_order)), 0);
+        EXPECT_EQ(std::memcmp(got_pnls.data(), pnls.data(), 7 * sizeof(IO::pnl_and_pos)), 0);
+
+        ASSERT_TRUE(IO::receiveResultFrame(server, header, got_pnls, got_ans));
+        EXPECT_EQ(IO::sessionName(header), "20160203_5_2");
+        EXPECT_TRUE(got_pnls.empty());
+        EXPECT_TRUE(got_ans.empty());
+        EXPECT_FALSE(IO::receiveResultFrame(server, header, got_pnls, got_ans));
+        sender.join();
+        close(server);
+    }
+}
+
+TEST(ProtocolTest, codecRoundTrip) {
+    std::vector<IO::twap_order> ans;
+    for (int i = 0; i < 10000; ++i) {
+        IO::twap_order order{};
+        std::snprintf(order.instrument_id, sizeof(order.instrument_id), "%06d", i % 50);
+        order.timestamp = 20160202093000000 + i / 7 * 3000;
+        order.direction = i % 3 == 0 ? -1 : 1;
+        order.volume = 100 * (1 + i % 9);
+        order.price = static_cast<double>(1000 + i % 50 * 37 + i % 11) / 100;
+        ans.push_back(order);
+    }
+    // Rows the tick deltas cannot express, they must come back bit for bit too.
+    IO::twap_order odd{};
+    std::memcpy(odd.instrument_id, "00000\0\x7f\x01", 8);  // Bytes after the terminator.
+    odd.timestamp = std::numeric_limits<long>::min();
+    odd.direction = std::numeric_limits<int>::min();
+    odd.volume = std::numeric_limits<int>::max();
+    for (double price : {0.1 + 0.2, -0.0, -12.34, 1e300, std::nan("")}) {
+        odd.price = price;
+        ans.push_back(odd);
+    }
+    ans.back().timestamp = std::numeric_limits<long>::max();
+
+    IO::TwapEncoder encoder;
+    std::vector<uint8_t> bytes = encoder.encode(ans);
+    EXPECT_LT(bytes.size(), ans.size() * sizeof(IO::twap_order) / 3);
+    std::vector<IO::twap_order> decoded;
+    IO::decodeTwapOrders(bytes.data(), bytes.size(), ans.size(), decoded);
+    ASSERT_EQ(decoded.size(), ans.size());
+    EXPECT_EQ(std::memcmp(decoded.data(), ans.data(), ans.size() * sizeof(IO::twap_order)), 0);
+    // The encoder is reusable, every call starts a new dictionary.
+    EXPECT_EQ(encoder.encode(ans), bytes);
+
+    EXPECT_THROW(IO::decodeTwapOrders(bytes.data(), bytes.size() - 1, ans.size(), decoded),
+                 std::runtime_error);
+    EXPECT_THROW(IO::decodeTwapOrders(bytes.data(), bytes.size(), ans.size() - 1, decoded),
+                 std::runtime_error);
+    EXPECT_THROW(IO::decodeTwapOrders(bytes.data(), bytes.size(), ans.size() + 1, decoded),
+                 std::runtime_error);
+    bytes[0] = 0x7e;  // An instrument code that was never introduced.
+    EXPECT_THROW(IO::decodeTwapOrders(bytes.data(), bytes.size(), ans.size(), decoded),
+                 std::runtime_error);
+}
+
+TEST(ProtocolTest, encodedFramesRoundTrip) {
+    std::vector<IO::pnl_and_pos> pnls;
+    std::vector<IO::twap_order> ans;
+    fill(pnls, ans, 200000);
+    IO::TwapEncoder encoder;
+    auto [client, server] = tcpPair();
+    std::thread sender([&, client = client] {
+        IO::FrameSendOptions options;
+        options.encoder = &encoder;
+        IO::sendResultFrame(client, IO::makeResultHeader("20160202_3_1", 7, ans.size()), pnls,
+                            ans, options);
+        IO::sendResultFrame(client, IO::makeResultHeader("20160203_5_2", 0, 0), {}, {}, options);
+        close(client);
+    });
+    IO::ResultFrameHeader header;
+    std::vector<IO::pnl_and_pos> got_pnls;
+    std::vector<IO::twap_order> got_ans;
+    ASSERT_TRUE(IO::receiveResultFrame(server, header, got_pnls, got_ans));
+    EXPECT_EQ(header.version, IO::kEncodedResultFrameVersion);
+    ASSERT_EQ(got_ans.size(), ans.size());
+    EXPECT_EQ(std::memcmp(got_ans.data(), ans.data(), ans.size() * sizeof(IO::twap_order)), 0);
+    EXPECT_EQ(std::memcmp(got_pnls.data(), pnls.data(), 7 * sizeof(IO::pnl_and_pos)), 0);
+
+    // Nothing to encode, the frame goes out as version 1.
+    ASSERT_TRUE(IO::receiveResultFrame(server, header, got_pnls, got_ans));
+    EXPECT_EQ(header.version, IO::kResultFrameVersion);
+    EXPECT_TRUE(got_ans.empty());
+    EXPECT_FALSE(IO::receiveResultFrame(server, header, got_pnls, got_ans));
+    sender.join();
+    close(server);
+}
+
+TEST(ProtocolTest, badFrames) {
+    std::vector<IO::pnl_and_pos> pnls;
+    std::vector<IO::twap_order> ans;
+    IO::ResultFrameHeader header = IO::makeResultHeader("20160202_3_1", 0, 10);
+    EXPECT_THROW(IO::sendResultFrame(-1, header, pnls, ans), std::invalid_argument);
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    // Truncated: the header promises 10 orders, only one follows.
+    IO::twap_order order{};
+    ASSERT_EQ(write(fds[0], &header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+    ASSERT_EQ(write(fds[0], &order, sizeof(order)), static_cast<ssize_t>(sizeof(order)));
+    close(fds[0]);
+    EXPECT_THROW(IO::receiveResultFrame(fds[1], header, pnls, ans), std::runtime_error);
+    close(fds[1]);
+
+    // Too large: rejected from the header, before allocating the records.
+    IO::ResultFrameHeader large = IO::makeResultHeader("20160202_3_1", uint64_t(1) << 40, 0);
+    EXPECT_THROW(IO::checkResultHeader(large), std::runtime_error);
+    large = IO::makeResultHeader("20160202_3_1", 0, 10);
+    EXPECT_NO_THROW(IO::checkResultHeader(large));
+    EXPECT_THROW(IO::checkResultHeader(large, 10 * sizeof(IO::twap_order) - 1), std::runtime_error);
+    large.pnl_count = large.twap_count = ~uint64_t(0) / 2;
+    EXPECT_THROW(IO::checkResultHeader(large), std::runtime_error);
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_EQ(write(fds[0], &header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+    EXPECT_THROW(IO::receiveResultFrame(fds[1], header, pnls, ans, 16), std::runtime_error);
+    close(fds[0]);
+    close(fds[1]);
+
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    header.magic = 0;
+    ASSERT_EQ(write(fds[0], &header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+    EXPECT_THROW(IO::receiveResultFrame(fds[1], header, pnls, ans), std::runtime_error);
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "io/bulk_reader.h"
+#include "io/reader.h"
+
+using namespace UBIEngine;
+
+namespace {
+std::string writeTempFile(const std::vector<IO::alpha>& records) {
+    char path[] = "/tmp/ubi_test_reader_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(IO::alpha));
+    return path;
+}
+
+std::vector<IO::alpha> makeAlphas(int count) {
+    std::vector<IO::alpha> alphas(count);
+    for (int i = 0; i < count; ++i) {
+        // Bounded to six digits, so the id and its terminator fit in 8 bytes.
+        std::snprintf(alphas[i].instrument_id, sizeof(alphas[i].instrument_id), "%06u",
+                      static_cast<unsigned>(i) % 1000000u);
+        alphas[i].timestamp = 93000000 + i;
+        alphas[i].target_volume = i * 100;
+    }
+    return alphas;
+}
+}  // namespace
+
+TEST(RecordFileTest, viewMatchesFile) {
+    auto alphas = makeAlphas(1000);
+    std::string path = writeTempFile(alphas);
+
+    IO::MapOptions options;
+    options.populate = true;
+    options.huge_pages = true;
+    IO::RecordFile<IO::alpha> file(path, options);
+    ASSERT_EQ(file.size(), alphas.size());
+    size_t i = 0;
+    for (const auto& record : file) {
+        EXPECT_EQ(record.timestamp, alphas[i].timestamp);
+        EXPECT_EQ(record.target_volume, alphas[i].target_volume);
+        EXPECT_STREQ(record.instrument_id, alphas[i].instrument_id);
+        ++i;
+    }
+    EXPECT_EQ(i, alphas.size());
+
+    // Moving keeps the mapping alive.
+    IO::RecordFile<IO::alpha> moved(std::move(file));
+    EXPECT_TRUE(file.empty());
+    EXPECT_EQ(moved[999].timestamp, alphas[999].timestamp);
+    std::remove(path.c_str());
+}
+
+TEST(RecordFileTest, emptyFile) {
+    std::string path = writeTempFile({});
+    IO::RecordFile<IO::alpha> file(path);
+    EXPECT_TRUE(file.empty());
+    EXPECT_EQ(file.begin(), file.end());
+    std::remove(path.c_str());
+}
+
+TEST(RecordFileTest, missingFile) {
+    EXPECT_THROW(IO::RecordFile<IO::alpha>("/nonexistent/alpha"), std::runtime_error);
+}
+
+TEST(RecordFileTest, vectorQueue) {
+    auto alphas = makeAlphas(10);
+    std::string path = writeTempFile(alphas);
+    IO::VectorQueue<IO::alpha, IO::RecordFile<IO::alpha>> queue{IO::RecordFile<IO::alpha>(path)};
+    for (int round = 0; round < 2; ++round) {
+        for (const auto& alpha : alphas) {
+            ASSERT_FALSE(queue.empty());
+            EXPECT_EQ(queue.front().timestamp, alpha.timestamp);
+            queue.pop();
+        }
+        EXPECT_TRUE(queue.empty());
+        queue.reset();
+    }
+    std::remove(path.c_str());
+}
+
+TEST(BulkReaderTest, readFiles) {
+    // Sizes that are not multiples of the block size or of the O_DIRECT alignment.
+    std::vector<std::vector<IO::alpha>> contents = {makeAlphas(5000), makeAlphas(1), {},
+                                                    makeAlphas(1237)};
+    std::vector<std::string> paths;
+    for (const auto& alphas : contents) paths.push_back(writeTempFile(alphas));
+
+    for (bool use_uring : {true, false}) {
+        for (bool direct : {true, false}) {
+            IO::BulkReadOptions options;
+            options.use_uring = use_uring;
+            options.direct = direct;
+            options.block_size = 4096;
+            options.queue_depth = 4;
+            IO::BulkReadStats stats;
+            auto buffers = IO::readFiles(paths, options, &stats);
+            ASSERT_EQ(buffers.size(), paths.size());
+            EXPECT_EQ(stats.bytes, (5000 + 1 + 1237) * sizeof(IO::alpha));
+            for (size_t i = 0; i < contents.size(); ++i) {
+                IO::RecordBuffer<IO::alpha> records(std::move(buffers[i]));
+                ASSERT_EQ(records.size(), contents[i].size());
+                EXPECT_EQ(std::memcmp(records.data(), contents[i].data(),
+                                      contents[i].size() * sizeof(IO::alpha)),
+                          0);
+            }
+        }
+    }
+    for (const auto& path : paths) std::remove(path.c_str());
+}
@@ -0,0 +1,234 @@
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "io/result_server.h"
+
+using namespace UBIEngine;
+
+namespace {
+int connectTo(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// The orders of `client`'s session, told apart by their volumes.
+std::vector<IO::twap_order> ordersOf(int client, int session, int count) {
+    std::vector<IO::twap_order> ans(count);
+    for (int i = 0; i < count; ++i) {
+        std::snprintf(ans[i].instrument_id, sizeof(ans[i].instrument_id), "%06d", i % 13);
+        ans[i].timestamp = i;
+        ans[i].volume = client * 1000000 + session * 100000 + i;
+    }
+    return ans;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Collects the frames of a server running on its own thread.
+struct Collector {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<std::string, IO::ReceivedResults> frames;
+    std::vector<std::string> order;  // Session names in handling order.
+
+    IO::ResultServer::Handler handler() {
+        return [this](IO::ReceivedResults& results) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string name = IO::sessionName(results.header);
+            order.push_back(name);
+            frames[name] = std::move(results);
+            changed.notify_all();
+        };
+    }
+
+    bool waitFor(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, std::chrono::seconds(30),
+                                [&] { return frames.size() >= count; });
+    }
+};
+}  // namespace
+
+TEST(ResultServerTest, manyConcurrentClients) {
+    Collector collector;
+    IO::ResultServerOptions options;
+    options.write_threads = 3;
+    IO::ResultServer server(collector.handler(), options);
+    std::thread serving([&] { server.run(); });
+
+    constexpr int kClients = 32, kSessions = 3;
+    std::vector<std::thread> clients;
+    for (int client = 0; client < kClients; ++client) {
+        clients.emplace_back([&, client] {
+            int fd = connectTo(server.port());
+            ASSERT_NE(fd, -1);
+            std::vector<IO::pnl_and_pos> pnls(2);
+            // Every other client sends its twap_order records encoded.
+            IO::TwapEncoder encoder;
+            IO::FrameSendOptions send_options;
+            if (client % 2 == 1) send_options.encoder = &encoder;
+            for (int session = 1; session <= kSessions; ++session) {
+                // Some frames are larger than the socket buffers, some are empty.
+                int count = client % 4 == 0 ? 50000 : (client + session) % 5 == 0 ? 0 : 300;
+                auto ans = ordersOf(client, session, count);
+                char name[32];
+                std::snprintf(name, sizeof(name), "201602%02d_%d_%d", client + 1, session, count);
+                IO::sendResultFrame(fd, IO::makeResultHeader(name, pnls.size(), ans.size()),
+                                    pnls, ans, send_options);
+            }
+            close(fd);
+        });
+    }
+    for (auto& client : clients) client.join();
+    ASSERT_TRUE(collector.waitFor(kClients * kSessions));
+    server.stop();
+    serving.join();
+
+    EXPECT_EQ(server.frames(), static_cast<uint64_t>(kClients * kSessions));
+    for (int client = 0; client < kClients; ++client) {
+        std::vector<size_t> positions;
+        for (int session = 1; session <= kSessions; ++session) {
+            int count = client % 4 == 0 ? 50000 : (client + session) % 5 == 0 ? 0 : 300;
+            char name[32];
+            std::snprintf(name, sizeof(name), "201602%02d_%d_%d", client + 1, session, count);
+            ASSERT_EQ(collector.frames.count(name), 1u) << name;
+            const auto& frame = collector.frames[name];
+            auto expected = ordersOf(client, session, count);
+            ASSERT_EQ(frame.ans.size(), expected.size());
+            EXPECT_EQ(std::memcmp(frame.ans.data(), expected.data(),
+                                  expected.size() * sizeof(IO::twap_order)),
+                      0);
+            EXPECT_EQ(frame.pnls.size(), 2u);
+            positions.push_back(std::find(collector.order.begin(), collector.order.end(), name) -
+                                collector.order.begin());
+        }
+        // The frames of a connection are handled in order.
+        EXPECT_TRUE(std::is_sorted(positions.begin(), positions.end())) << client;
+    }
+}
+
+TEST(ResultServerTest, partialWritesAndBadClients) {
+    Collector collector;
+    IO::ResultServer server(collector.handler());
+    std::thread serving([&] { server.run(); });
+
+    // A frame trickled in small pieces.
+    std::vector<IO::pnl_and_pos> pnls(3);
+    auto ans = ordersOf(7, 1, 40);
+    IO::ResultFrameHeader header = IO::makeResultHeader("20160202_3_1", pnls.size(), ans.size());
+    std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytes.append(reinterpret_cast<const char*>(pnls.data()), pnls.size() * sizeof(pnls[0]));
+    bytes.append(reinterpret_cast<const char*>(ans.data()), ans.size() * sizeof(ans[0]));
+    int slow = connectTo(server.port());
+    // A client sending garbage is dropped without affecting the others.
+    int bad = connectTo(server.port());
+    ASSERT_EQ(write(bad, "not a frame, just some bytes of junk data", 41), 41);
+    for (size_t offset = 0; offset < bytes.size(); offset += 7) {
+        size_t length = std::min<size_t>(7, bytes.size() - offset);
+        ASSERT_EQ(write(slow, bytes.data() + offset, length), static_cast<ssize_t>(length));
+        if (offset % 140 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(collector.waitFor(1));
+    close(slow);
+    close(bad);
+    server.stop();
+    serving.join();
+    const auto& frame = collector.frames["20160202_3_1"];
+    ASSERT_EQ(frame.ans.size(), ans.size());
+    EXPECT_EQ(std::memcmp(frame.ans.data(), ans.data(), ans.size() * sizeof(IO::twap_order)), 0);
+}
+
+TEST(ResultServerTest, slowWriterPausesItsConnection) {
+    Collector collector;
+    std::mutex gate;
+    gate.lock();  // Holds the writer in the first frame.
+    IO::ResultServerOptions options;
+    options.write_threads = 1;
+    options.max_pending_frames = 2;
+    auto collect = collector.handler();
+    IO::ResultServer server(
+        [&](IO::ReceivedResults& results) {
+            std::lock_guard<std::mutex> lock(gate);
+            collect(results);
+        },
+        options);
+    std::thread serving([&] { server.run(); });
+
+    int client = connectTo(server.port());
+    ASSERT_NE(client, -1);
+    std::vector<IO::pnl_and_pos> pnls(1);
+    for (int session = 1; session <= 10; ++session) {
+        auto ans = ordersOf(1, session, 5);
+        IO::ResultFrameHeader header = IO::makeResultHeader(
+            "20160202_" + std::to_string(session) + "_1", pnls.size(), ans.size());
+        IO::sendResultFrame(client, header, pnls, ans);
+    }
+    // Everything fits in the socket buffers, yet only the frames up to the limit are read.
+    for (int i = 0; i < 3000 && server.pauses() == 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(server.frames(), 2u);
+    EXPECT_EQ(server.pauses(), 1u);
+
+    gate.unlock();
+    ASSERT_TRUE(collector.waitFor(10));
+    EXPECT_EQ(server.frames(), 10u);
+    for (int session = 1; session <= 10; ++session)
+        EXPECT_EQ(collector.order[session - 1], "20160202_" + std::to_string(session) + "_1");
+    close(client);
+    server.stop();
+    serving.join();
+}
+
+TEST(ResultServerTest, fileHandler) {
+    char dir[] = "/tmp/ubi_test_server_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    std::string output_dir = dir;
+    mkdir((output_dir + "/twap_order").c_str(), 0755);
+    mkdir((output_dir + "/pnl_and_pos").c_str(), 0755);
+
+    IO::ReceivedResults results;
+    results.header = IO::makeResultHeader("20160202_5_3", 1, 20);
+    results.pnls.resize(1);
+    results.pnls[0].position = 9;
+    results.ans = ordersOf(1, 1, 20);
+    IO::ResultServer::fileHandler(output_dir)(results);
+    EXPECT_EQ(readFile(output_dir + "/twap_order/20160202_5_3"),
+              std::string(reinterpret_cast<const char*>(results.ans.data()),
+                          results.ans.size() * sizeof(IO::twap_order)));
+    EXPECT_EQ(readFile(output_dir + "/pnl_and_pos/20160202_5_3").size(),
+              sizeof(IO::pnl_and_pos));
+    std::remove((output_dir + "/twap_order/20160202_5_3").c_str());
+    std::remove((output_dir + "/pnl_and_pos/20160202_5_3").c_str());
+    rmdir((output_dir + "/twap_order").c_str());
+    rmdir((output_dir + "/pnl_and_pos").c_str());
+    rmdir(dir);
+}
@@ -0,0 +1,147 @@
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "io/result_server.h"
+#include "io/result_shipper.h"
+
+using namespace UBIEngine;
+
+namespace {
+IO::ShippedResults sessionResults(int day, int count) {
+    IO::ShippedResults results;
+    char name[32];
+    std::snprintf(name, sizeof(name), "201602%02d_3_1", day);
+    results.session_name = name;
+    results.pnls.resize(2);
+    results.ans.resize(count);
+    for (int i = 0; i < count; ++i) results.ans[i].volume = day * 100000 + i;
+    return results;
+}
+
+// A port nothing listens on, until a server binds it.
+uint16_t freePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// A ResultServer on its own thread that counts the orders of every session.
+struct Receiver {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<std::string, size_t> orders;
+    IO::ResultServer server;
+    std::thread serving;
+
+    explicit Receiver(uint16_t port)
+        : server(
+              [this](IO::ReceivedResults& results) {
+                  std::lock_guard<std::mutex> lock(mutex);
+                  orders[IO::sessionName(results.header)] = results.ans.size();
+                  changed.notify_all();
+              },
+              IO::ResultServerOptions{port}) {
+        serving = std::thread([this] { server.run(); });
+    }
+
+    ~Receiver() {
+        server.stop();
+        serving.join();
+    }
+
+    bool waitFor(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, std::chrono::seconds(30),
+                                [&] { return orders.size() >= count; });
+    }
+};
+}  // namespace
+
+TEST(ResultShipperTest, shipsFromManyProducers) {
+    Receiver receiver(0);
+    IO::ShipperOptions options;
+    options.port = receiver.server.port();
+    options.capacity = 2;
+    IO::ResultShipper shipper(options);
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < 3; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (int i = 0; i < 5; ++i)
+                shipper.submit(sessionResults(producer * 5 + i + 1, 1000 * (i + 1)));
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    shipper.flush();
+    ASSERT_TRUE(receiver.waitFor(15));
+    for (int day = 1; day <= 15; ++day) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "201602%02d_3_1", day);
+        EXPECT_EQ(receiver.orders[name], 1000u * ((day - 1) % 5 + 1)) << name;
+    }
+    IO::ShipperStats stats = shipper.stats();
+    EXPECT_EQ(stats.submitted, 15u);
+    EXPECT_EQ(stats.sent, 15u);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.queued, 0u);
+    EXPECT_GE(stats.max_us, stats.p50_us);
+}
+
+TEST(ResultShipperTest, backpressureAndReconnect) {
+    IO::ShipperOptions options;
+    options.port = freePort();
+    options.capacity = 2;
+    options.retry_initial = std::chrono::milliseconds(1);
+    options.retry_max = std::chrono::milliseconds(20);
+    IO::ResultShipper shipper(options);
+
+    // Nothing listens: one session is retried by the I/O thread, two wait in the queue.
+    int submitted = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (submitted < 3 && std::chrono::steady_clock::now() < deadline) {
+        IO::ShippedResults results = sessionResults(submitted + 1, 10);
+        if (shipper.trySubmit(results)) ++submitted;
+    }
+    ASSERT_EQ(submitted, 3);
+    IO::ShippedResults rejected = sessionResults(9, 10);
+    EXPECT_FALSE(shipper.trySubmit(rejected));
+    EXPECT_EQ(rejected.ans.size(), 10u);  // Left as is.
+
+    Receiver receiver(options.port);
+    ASSERT_TRUE(receiver.waitFor(3));
+    shipper.flush();
+    IO::ShipperStats stats = shipper.stats();
+    EXPECT_EQ(stats.sent, 3u);
+    EXPECT_GT(stats.reconnects, 0u);
+}
+
+TEST(ResultShipperTest, closeDropsWhenUnreachable) {
+    IO::ShipperOptions options;
+    options.port = freePort();
+    options.retry_initial = std::chrono::milliseconds(1);
+    IO::ResultShipper shipper(options);
+    shipper.submit(sessionResults(1, 10));
+    shipper.submit(sessionResults(2, 10));
+    shipper.close();
+    IO::ShipperStats stats = shipper.stats();
+    EXPECT_EQ(stats.sent, 0u);
+    EXPECT_EQ(stats.dropped, 2u);
+    EXPECT_THROW(shipper.submit(sessionResults(3, 10)), std::logic_error);
+}
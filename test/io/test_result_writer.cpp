@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "io/result_writer.h"
+
+using namespace UBIEngine;
+
+namespace {
+std::string tempPath() {
+    char path[] = "/tmp/ubi_test_writer_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    return path;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+template <typename T>
+std::string bytesOf(const std::vector<T>& records) {
+    return std::string(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+}
+
+void fill(IO::SessionResults& results, int session, int count) {
+    for (int i = 0; i < count; ++i) {
+        IO::twap_order order{};
+        std::snprintf(order.instrument_id, sizeof(order.instrument_id), "%06d", i % 7);
+        order.timestamp = session * 1000000 + i;
+        order.volume = i;
+        results.twap_orders.push_back(order);
+    }
+    for (int i = 0; i < 7; ++i) {
+        IO::pnl_and_pos pnl{};
+        std::snprintf(pnl.instrument_id, sizeof(pnl.instrument_id), "%06d", i);
+        pnl.position = session + i;
+        results.pnls.push_back(pnl);
+    }
+}
+}  // namespace
+
+TEST(ResultWriterTest, writeFilesInBlocks) {
+    std::vector<char> data(100000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 31);
+    for (bool use_uring : {true, false}) {
+        IO::WriteOptions options;
+        options.use_uring = use_uring;
+        options.block_size = 4096;  // Many requests per file.
+        options.fsync = IO::FsyncPolicy::Data;
+        std::string first = tempPath(), second = tempPath();
+        IO::writeFiles({{first, data.data(), data.size()}, {second, data.data(), 10}}, options);
+        EXPECT_EQ(readFile(first), std::string(data.begin(), data.end()));
+        EXPECT_EQ(readFile(second), std::string(data.begin(), data.begin() + 10));
+        // Existing files are truncated.
+        IO::writeFiles({{first, data.data(), 0}}, options);
+        EXPECT_EQ(readFile(first).size(), 0);
+        std::remove(first.c_str());
+        std::remove(second.c_str());
+    }
+}
+
+TEST(ResultWriterTest, sessionsAreWrittenInBackground) {
+    IO::WriteOptions options;
+    options.fsync = IO::FsyncPolicy::Full;
+    IO::ResultWriter writer(options);
+    std::vector<std::string> paths;
+    std::vector<std::string> expected;
+    for (int session = 0; session < 5; ++session) {
+        IO::SessionResults& results = writer.acquire();
+        EXPECT_TRUE(results.twap_orders.empty());
+        EXPECT_TRUE(results.pnls.empty());
+        fill(results, session, 1000 * (session + 1));
+        results.twap_path = tempPath();
+        results.pnl_path = tempPath();
+        paths.push_back(results.twap_path);
+        paths.push_back(results.pnl_path);
+        expected.push_back(bytesOf(results.twap_orders));
+        expected.push_back(bytesOf(results.pnls));
+        writer.submit();
+    }
+    writer.flush();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        EXPECT_EQ(readFile(paths[i]), expected[i]) << paths[i];
+        std::remove(paths[i].c_str());
+    }
+    EXPECT_THROW(writer.submit(), std::logic_error);
+}
+
+TEST(ResultWriterTest, errorsAreRethrown) {
+    IO::ResultWriter writer;
+    IO::SessionResults& results = writer.acquire();
+    results.twap_path = "/nonexistent_dir/twap";
+    results.pnl_path = "/nonexistent_dir/pnl";
+    writer.submit();
+    EXPECT_THROW(writer.flush(), std::runtime_error);
+    // The error is reported once, the writer keeps working.
+    writer.flush();
+}
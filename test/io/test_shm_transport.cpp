@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine/sorted_output.h"
+#include "io/shm_transport.h"
+
+using namespace UBIEngine;
+
+namespace {
+// Fixed before any fork, so parent and child use the same name.
+const std::string kRingName = "/ubi_test_ring_" + std::to_string(getpid());
+
+// The session of `index`, its size varies so the frames wrap at different places.
+void fillSession(int index, std::vector<IO::pnl_and_pos>& pnls, std::vector<IO::twap_order>& ans) {
+    pnls.assign(index % 3, IO::pnl_and_pos{});
+    for (size_t i = 0; i < pnls.size(); ++i) pnls[i].position = index + i;
+    ans.assign((index * 37) % 500, IO::twap_order{});
+    for (size_t i = 0; i < ans.size(); ++i) {
+        ans[i].timestamp = i;
+        ans[i].volume = index * 1000 + i;
+    }
+}
+
+std::string sessionName(int index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "20160202_%d_1", index);
+    return name;
+}
+
+void expectSession(int index, const IO::ShmFrameView& frame) {
+    std::vector<IO::pnl_and_pos> pnls;
+    std::vector<IO::twap_order> ans;
+    fillSession(index, pnls, ans);
+    ASSERT_EQ(IO::sessionName(frame.header), sessionName(index));
+    ASSERT_EQ(frame.header.pnl_count, pnls.size());
+    ASSERT_EQ(frame.header.twap_count, ans.size());
+    EXPECT_EQ(std::memcmp(frame.ans, ans.data(), ans.size() * sizeof(IO::twap_order)), 0);
+    EXPECT_EQ(std::memcmp(frame.pnls, pnls.data(), pnls.size() * sizeof(IO::pnl_and_pos)), 0);
+}
+}  // namespace
+
+TEST(ShmTransportTest, framesWrapAroundTheRing) {
+    IO::ShmResultReceiver receiver(kRingName, 64 << 10);  // Room for a few frames only.
+    std::thread sender_thread([] {
+        IO::ShmResultSender sender(kRingName);
+        for (int index = 0; index < 300; ++index) {
+            std::vector<IO::pnl_and_pos> pnls;
+            std::vector<IO::twap_order> ans;
+            fillSession(index, pnls, ans);
+            if (index % 2 == 0) {
+                sender.send(sessionName(index), pnls, ans);
+                continue;
+            }
+            // Written in place, with a reservation larger than the frame.
+            auto frame = sender.beginFrame(sessionName(index), ans.size() + 100, 2);
+            SortedTwapOutput output(frame.ans);
+            for (const auto& order : ans)
+                output.emplace(order.instrument_id, order.timestamp, order.direction, order.volume,
+                               order.price);
+            output.finish();
+            sender.commit(frame, pnls);
+        }
+    });
+    IO::ShmFrameView frame;
+    int received = 0;
+    while (receiver.receive(frame)) {
+        expectSession(received++, frame);
+        receiver.release(frame);
+    }
+    sender_thread.join();
+    EXPECT_EQ(received, 300);
+}
+
+TEST(ShmTransportTest, acrossProcesses) {
+    IO::ShmResultReceiver receiver(kRingName, 32 << 10);
+    pid_t child = fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+        {
+            IO::ShmResultSender sender(kRingName);
+            for (int index = 0; index < 50; ++index) {
+                std::vector<IO::pnl_and_pos> pnls;
+                std::vector<IO::twap_order> ans;
+                fillSession(index, pnls, ans);
+                sender.send(sessionName(index), pnls, ans);
+            }
+        }
+        _exit(0);
+    }
+    IO::ShmFrameView frame;
+    int received = 0;
+    while (receiver.receive(frame)) {
+        expectSession(received++, frame);
+        receiver.release(frame);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(received, 50);
+}
+
+TEST(ShmTransportTest, limits) {
+    auto receiver = std::make_unique<IO::ShmResultReceiver>(kRingName, 4096);
+    IO::ShmResultSender sender(kRingName);
+    // One sender per ring.
+    EXPECT_THROW(IO::ShmResultSender second(kRingName), std::runtime_error);
+    EXPECT_THROW(sender.beginFrame("20160202_3_1", 1000, 0), std::length_error);
+
+    auto frame = sender.beginFrame("20160202_3_1", 2, 0);
+    frame.ans.push_back(IO::twap_order{});
+    frame.ans.push_back(IO::twap_order{});
+    EXPECT_THROW(frame.ans.push_back(IO::twap_order{}), std::length_error);
+    std::vector<IO::pnl_and_pos> pnls(1);
+    EXPECT_THROW(sender.commit(frame, pnls), std::length_error);
+    sender.commit(frame, {});
+
+    IO::ShmFrameView view;
+    EXPECT_TRUE(receiver->receive(view, 0));
+    EXPECT_EQ(view.header.twap_count, 2u);
+    // Until it is released, the frame is handed out again.
+    EXPECT_TRUE(receiver->receive(view, 10));
+    EXPECT_EQ(IO::sessionName(view.header), "20160202_3_1");
+
+    // A full ring waits for the receiver, which goes away.
+    std::thread closer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        receiver.reset();
+    });
+    EXPECT_THROW(sender.beginFrame("20160202_3_3", 125, 0), std::runtime_error);
+    closer.join();
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "io/symbol_index.h"
+
+using namespace UBIEngine;
+
+namespace {
+std::vector<IO::prev_trade_info> makePrevInfos(int count) {
+    std::vector<IO::prev_trade_info> prev_trade_infos(count);
+    for (int i = 0; i < count; ++i) {
+        // Bounded to six digits, so the id and its terminator fit in 8 bytes.
+        std::snprintf(prev_trade_infos[i].instrument_id, 8, "%06u",
+                      static_cast<unsigned>(i) % 1000000u);
+        prev_trade_infos[i].prev_close_price = 10;
+        prev_trade_infos[i].prev_position = 0;
+    }
+    return prev_trade_infos;
+}
+}  // namespace
+
+TEST(SymbolIndexTest, symbolTable) {
+    auto prev_trade_infos = makePrevInfos(3);
+    prev_trade_infos.push_back(prev_trade_infos[1]);  // Duplicates keep the first id.
+    IO::SymbolTable symbols(prev_trade_infos);
+    EXPECT_EQ(symbols.size(), 3);
+    EXPECT_EQ(symbols.symbolId("000000"), 0);
+    EXPECT_EQ(symbols.symbolId("000002"), 2);
+    EXPECT_EQ(symbols.symbolId("999999"), symbols.unknown());
+}
+
+TEST(SymbolIndexTest, parallelMatchesSerial) {
+    auto prev_trade_infos = makePrevInfos(50);
+    IO::SymbolTable symbols(prev_trade_infos);
+    std::mt19937 rng(3);
+    // Enough records for several threads; index 60 to 64 are unknown instruments.
+    std::vector<IO::alpha> alphas(300000);
+    for (size_t i = 0; i < alphas.size(); ++i) {
+        std::snprintf(alphas[i].instrument_id, 8, "%06u", static_cast<unsigned>(rng() % 55));
+        alphas[i].timestamp = i;
+    }
+
+    IO::SymbolIndex serial(alphas, symbols, 1);
+    IO::SymbolIndex parallel(alphas, symbols, 4);
+    size_t total = 0;
+    for (uint32_t s = 0; s <= symbols.unknown(); ++s) {
+        ASSERT_EQ(parallel.count(s), serial.count(s));
+        ASSERT_TRUE(std::equal(parallel.begin(s), parallel.end(s), serial.begin(s)));
+        // Every symbol's positions are in input order and point at its records.
+        for (auto it = parallel.begin(s); it != parallel.end(s); ++it) {
+            if (it != parallel.begin(s)) {
+                ASSERT_LT(*(it - 1), *it);
+            }
+            EXPECT_EQ(symbols.symbolId(alphas[*it].instrument_id), s);
+            EXPECT_EQ(parallel.symbolOf(*it), s);
+        }
+        total += parallel.count(s);
+    }
+    EXPECT_EQ(total, alphas.size());
+    EXPECT_GT(parallel.count(symbols.unknown()), 0);
+}
+
+TEST(SymbolIndexTest, empty) {
+    auto prev_trade_infos = makePrevInfos(2);
+    IO::SymbolTable symbols(prev_trade_infos);
+    IO::SymbolIndex index(std::vector<IO::alpha>(), symbols, 8);
+    EXPECT_EQ(index.count(0), 0);
+    EXPECT_EQ(index.count(index.unknown()), 0);
+}
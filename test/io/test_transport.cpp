@@ -0,0 +1,93 @@
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "io/transport.h"
+
+using namespace UBIEngine;
+
+namespace {
+// A listening socket on the loopback interface and its port.
+std::pair<int, uint16_t> listenLoopback() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    listen(fd, 1);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    return {fd, ntohs(addr.sin_port)};
+}
+
+// Echoes length-prefixed messages, small ones in pieces so receives see partial messages.
+void echo(int listen_fd, IO::TransportKind kind) {
+    IO::TransportOptions options;
+    options.kind = kind;
+    auto transport = IO::makeTransport(accept(listen_fd, nullptr, nullptr), options);
+    uint32_t length;
+    std::vector<char> buffer;
+    while (transport->receiveFully(&length, sizeof(length))) {
+        buffer.resize(length);
+        ASSERT_TRUE(transport->receiveFully(buffer.data(), length));
+        size_t piece = length <= 64 ? 7 : length;
+        for (size_t sent = 0; sent < length; sent += piece)
+            transport->send(buffer.data() + sent, std::min<size_t>(piece, length - sent));
+    }
+}
+
+// Sends `message` to the echo server and checks that it comes back.
+void roundTrip(IO::Transport& transport, const std::vector<char>& message) {
+    uint32_t length = static_cast<uint32_t>(message.size());
+    transport.send(&length, sizeof(length));
+    transport.send(message.data(), message.size());
+    std::vector<char> reply(message.size());
+    ASSERT_TRUE(transport.receiveFully(reply.data(), reply.size()));
+    EXPECT_EQ(reply, message);
+}
+}  // namespace
+
+TEST(TransportTest, pingPong) {
+    for (auto kind : {IO::TransportKind::Epoll, IO::TransportKind::BusyPoll}) {
+        auto [listen_fd, port] = listenLoopback();
+        std::thread server(echo, listen_fd, kind);
+        {
+            IO::TransportOptions options;
+            options.kind = kind;
+            auto transport = IO::connectTransport("127.0.0.1", port, options);
+            for (int round = 0; round < 100; ++round)
+                roundTrip(*transport, std::vector<char>(64, static_cast<char>('a' + round % 26)));
+            // Larger than the socket buffers: the sends wait for the peer to drain them.
+            roundTrip(*transport, std::vector<char>(8 << 20, 'z'));
+        }
+        server.join();
+        close(listen_fd);
+    }
+}
+
+TEST(TransportTest, endOfStream) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    auto transport = IO::makeTransport(fds[0]);
+    EXPECT_STREQ(transport->name(), "epoll");
+    ASSERT_EQ(write(fds[1], "abc", 3), 3);
+    close(fds[1]);
+    char buffer[8];
+    EXPECT_THROW(transport->receiveFully(buffer, sizeof(buffer)), std::runtime_error);
+    EXPECT_EQ(transport->receive(buffer, sizeof(buffer)), 0u);
+    EXPECT_FALSE(transport->receiveFully(buffer, sizeof(buffer)));
+}
+
+TEST(TransportTest, userSpaceIsNotBuilt) {
+    IO::TransportOptions options;
+    options.kind = IO::parseTransportKind("user-space");
+    EXPECT_THROW(IO::connectTransport("127.0.0.1", 1, options), std::runtime_error);
+    EXPECT_THROW(IO::parseTransportKind("rdma"), std::invalid_argument);
+}
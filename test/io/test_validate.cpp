@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <vector>
+
+#include "io/order_decoder.h"
+#include "io/validate.h"
+
+using namespace UBIEngine;
+
+namespace {
+// Instrument n is "00000n", six digits so the id and its terminator fit in 8 bytes.
+void setInstrument(char* instrument_id, size_t n) {
+    std::snprintf(instrument_id, 8, "%06u", static_cast<unsigned>(n % 1000000));
+}
+
+// The symbol table of instruments 0 .. count - 1, only the ids matter to validation.
+IO::SymbolTable symbolsOf(size_t count) {
+    std::vector<IO::prev_trade_info> prev_trade_infos(count);
+    for (size_t i = 0; i < count; ++i) setInstrument(prev_trade_infos[i].instrument_id, i);
+    return IO::SymbolTable(prev_trade_infos);
+}
+
+std::vector<IO::order_log> makeOrders(size_t count, int symbols) {
+    std::vector<IO::order_log> orders(count);
+    for (size_t i = 0; i < count; ++i) {
+        setInstrument(orders[i].instrument_id, i % symbols);
+        orders[i].timestamp = 1000 + i / 3;
+        orders[i].type = i % 6;
+        orders[i].direction = i % 2 ? 1 : -1;
+        orders[i].volume = 100;
+        orders[i].price_off = 0.01 * (i % 7);
+    }
+    return orders;
+}
+}  // namespace
+
+TEST(ValidateTest, rejectsByReason) {
+    IO::SymbolTable symbols = symbolsOf(4);
+    auto orders = makeOrders(10, 4);
+    orders[2].timestamp = 0;  // Backwards.
+    orders[4].type = 9;
+    orders[5].direction = 0;
+    orders[6].volume = 0;
+    std::snprintf(orders[7].instrument_id, 8, "999999");  // Not in prev_trade_info.
+    orders[8].type = -1;
+    orders[8].volume = 0;  // Only the first reason is counted.
+
+    IO::ValidationReport report;
+    IO::RejectBitmap rejects = IO::validateOrders(orders, symbols, &report, 1);
+    std::vector<size_t> expected = {2, 4, 5, 6, 7, 8};
+    for (size_t i = 0; i < orders.size(); ++i) {
+        bool is_expected = std::find(expected.begin(), expected.end(), i) != expected.end();
+        EXPECT_EQ(rejects.rejected(i), is_expected) << i;
+    }
+    EXPECT_EQ(rejects.count(), expected.size());
+    EXPECT_EQ(report.checked, orders.size());
+    EXPECT_EQ(report.rejected, expected.size());
+    auto reason = [&](IO::RejectReason r) { return report.by_reason[static_cast<size_t>(r)]; };
+    EXPECT_EQ(reason(IO::RejectReason::TimestampBackwards), 1);
+    EXPECT_EQ(reason(IO::RejectReason::UnknownType), 2);
+    EXPECT_EQ(reason(IO::RejectReason::BadDirection), 1);
+    EXPECT_EQ(reason(IO::RejectReason::NonPositiveVolume), 1);
+    EXPECT_EQ(reason(IO::RejectReason::UnknownSymbol), 1);
+    EXPECT_EQ(report.summary(),
+              "6 of 10 rejected (timestamp backwards: 1, unknown type: 2, bad direction: 1, "
+              "non-positive volume: 1, unknown symbol: 1)");
+}
+
+TEST(ValidateTest, parallelMatchesSerial) {
+    IO::SymbolTable symbols = symbolsOf(20);
+    // Enough rows for several threads, with rejects on and around chunk boundaries.
+    auto orders = makeOrders(1 << 18, 21);
+    for (size_t i = 0; i < orders.size(); i += 4093) orders[i].volume = -1;
+    orders[65536].timestamp = 0;
+    orders[65535].type = 6;
+    // A backward run across the first chunk boundary, so the guess of the next
+    // chunk is wrong, and a spike right before the second one.
+    for (size_t i = 65520; i < 65550; ++i) orders[i].timestamp = 5;
+    orders[131071].timestamp = 1000000000;
+
+    IO::ValidationReport serial_report, parallel_report;
+    IO::RejectBitmap serial = IO::validateOrders(orders, symbols, &serial_report, 1);
+    IO::RejectBitmap parallel = IO::validateOrders(orders, symbols, &parallel_report, 4);
+    for (size_t i = 0; i < orders.size(); ++i) ASSERT_EQ(parallel.rejected(i), serial.rejected(i));
+    EXPECT_EQ(parallel_report.checked, orders.size());
+    EXPECT_EQ(parallel_report.by_reason, serial_report.by_reason);
+    EXPECT_EQ(parallel_report.rejected, parallel.count());
+    EXPECT_TRUE(serial.rejected(65549));
+    EXPECT_TRUE(serial.rejected(131071));
+    EXPECT_FALSE(serial.rejected(131072));
+}
+
+TEST(ValidateTest, acceptedTimestampsNeverGoBackwards) {
+    IO::SymbolTable symbols = symbolsOf(1);
+    auto rejectedRows = [&](std::vector<long> timestamps) {
+        auto orders = makeOrders(timestamps.size(), 1);
+        for (size_t i = 0; i < orders.size(); ++i) {
+            orders[i].timestamp = timestamps[i];
+            orders[i].type = 0;
+        }
+        IO::RejectBitmap rejects = IO::validateOrders(orders, symbols, nullptr, 1);
+        std::vector<size_t> rows;
+        for (size_t i = 0; i < orders.size(); ++i)
+            if (rejects.rejected(i)) rows.push_back(i);
+        return rows;
+    };
+    // A backward run that recovers partly: 5 and 6 are both behind 20.
+    EXPECT_EQ(rejectedRows({10, 20, 5, 6, 30}), (std::vector<size_t>{2, 3}));
+    EXPECT_EQ(rejectedRows({10, 20, 5, 6, 15, 20, 21}), (std::vector<size_t>{2, 3, 4}));
+    // A spike is rejected instead of the rows after it.
+    EXPECT_EQ(rejectedRows({10, 99, 11, 12}), (std::vector<size_t>{1}));
+    EXPECT_EQ(rejectedRows({99, 11, 12}), (std::vector<size_t>{0}));
+    EXPECT_EQ(rejectedRows({10, 10, 11}), std::vector<size_t>());
+}
+
+TEST(ValidateTest, decodedQueueSkipsRejects) {
+    IO::SymbolTable symbols = symbolsOf(3);
+    auto orders = makeOrders(100, 3);
+    // A whole batch of rejects, and a reject in every other batch.
+    for (size_t i = 40; i < 48; ++i) orders[i].direction = 2;
+    for (size_t i = 3; i < orders.size(); i += 8) orders[i].volume = 0;
+    IO::RejectBitmap rejects = IO::validateOrders(orders, symbols);
+
+    auto copy = orders;
+    IO::DecodedOrderQueue<std::vector<IO::order_log>> queue(std::move(copy), 8, rejects);
+    for (int round = 0; round < 2; ++round) {
+        size_t i = 0;
+        for (; !queue.empty(); queue.pop()) {
+            while (rejects.rejected(i)) ++i;
+            const IO::order_event& event = queue.front();
+            EXPECT_EQ(event.timestamp, orders[i].timestamp);
+            EXPECT_STREQ(queue.instrumentId(event.instrument), orders[i].instrument_id);
+            EXPECT_EQ(event.volume, orders[i].volume);
+            ++i;
+        }
+        while (i < orders.size() && rejects.rejected(i)) ++i;
+        EXPECT_EQ(i, orders.size());
+        queue.reset();
+    }
+}
+
+TEST(ValidateTest, alphas) {
+    IO::SymbolTable symbols = symbolsOf(2);
+    std::vector<IO::alpha> alphas(4);
+    const char* ids[] = {"000000", "000001", "000007", "000000"};
+    for (size_t i = 0; i < alphas.size(); ++i) {
+        std::snprintf(alphas[i].instrument_id, 8, "%s", ids[i]);
+        alphas[i].timestamp = 10 * i;
+        alphas[i].target_volume = 100;
+    }
+    alphas[3].timestamp = 5;
+    IO::RejectBitmap rejects = IO::validateAlphas(alphas, symbols);
+    auto accepted = IO::acceptedRecords<IO::alpha>(alphas, rejects);
+    ASSERT_EQ(accepted.size(), 2);
+    EXPECT_EQ(accepted[0].timestamp, 0);
+    EXPECT_EQ(accepted[1].timestamp, 10);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "concurrent_market.h"
+#include "engine/symbol_loads.h"
+#include "market.h"
+
+using namespace UBIEngine;
+
+namespace {
+// Applies the same operations to a Market and a ConcurrentMarket.
+template <typename AnyMarket>
+void trade(AnyMarket &market) {
+    for (uint32_t symbol = 1; symbol <= 3; ++symbol)
+        market.addSymbol(symbol, "00000" + std::to_string(symbol), 1000, 100);
+    uint64_t id = 0;
+    for (int round = 0; round < 200; ++round) {
+        uint32_t symbol = 1 + round % 3;
+        OrderSide side = round % 2 == 0 ? OrderSide::Bid : OrderSide::Ask;
+        uint64_t price = side == OrderSide::Bid ? 995 + round % 7 : 998 + round % 5;
+        market.addOrder(Order::newOrder(OrderType::LIMIT, side, ++id, symbol, 100 + round, price));
+    }
+    market.addSymbol(4, "000004", 500, 0);
+    market.addOrder(Order::newOrder(OrderType::LIMIT, OrderSide::Ask, ++id, 4, 300, 510));
+    market.executeOrder(4, id, 100);
+    market.executeOrder(4, id, 50, 510);
+    market.addOrder(Order::newOrder(OrderType::LIMIT, OrderSide::Bid, ++id, 4, 300, 490));
+    market.deleteOrder(4, id);
+}
+}  // namespace
+
+TEST(ConcurrentMarketTest, matchesLikeMarket) {
+    Market market;
+    trade(market);
+    ConcurrentMarket concurrent_market(1);
+    trade(concurrent_market);
+    // The query is queued behind the commands, so it sees all of them.
+    std::string books = concurrent_market.toString();
+    EXPECT_FALSE(books.empty());
+    EXPECT_EQ(books, market.toString());
+}
+
+TEST(ConcurrentMarketTest, snapshotsMatchMarketOnManyThreads) {
+    Market market;
+    trade(market);
+    ConcurrentMarket concurrent_market(3);
+    trade(concurrent_market);
+    concurrent_market.sync();
+    for (uint32_t symbol = 1; symbol <= 4; ++symbol) {
+        for (OrderSide side : {OrderSide::Bid, OrderSide::Ask}) {
+            EXPECT_EQ(concurrent_market.getBasePrice(symbol, side),
+                      market.getBasePrice(symbol, side));
+            EXPECT_EQ(concurrent_market.getUpLimit(symbol, side), market.getUpLimit(symbol, side));
+            EXPECT_EQ(concurrent_market.getDownLimit(symbol, side),
+                      market.getDownLimit(symbol, side));
+        }
+        EXPECT_EQ(concurrent_market.getPnlHelper(symbol).getPosition(),
+                  market.getPnlHelper(symbol).getPosition());
+        EXPECT_EQ(concurrent_market.calculatePnl(symbol), market.calculatePnl(symbol));
+    }
+}
+
+TEST(ConcurrentMarketTest, newSymbolIsReadableAtOnce) {
+    ConcurrentMarket concurrent_market(2);
+    concurrent_market.addSymbol(1, "000001", 1000, 100);
+    // Whether or not the worker applied it yet.
+    EXPECT_EQ(concurrent_market.getBasePrice(1, OrderSide::Bid), 1000u);
+    EXPECT_EQ(concurrent_market.getPnlHelper(1).getPosition(), 100u);
+    EXPECT_EQ(concurrent_market.calculatePnl(1), -100000);
+    concurrent_market.deleteSymbol(1);
+    concurrent_market.addSymbol(1, "000001", 2000, 0);
+    concurrent_market.sync();
+    EXPECT_EQ(concurrent_market.getBasePrice(1, OrderSide::Ask), 2000u);
+}
+
+TEST(ConcurrentMarketTest, packsSymbolsByLoad) {
+    SymbolLoads loads{{1, 100}, {2, 90}, {3, 10}, {4, 10}, {5, 5}};
+    auto placement = ConcurrentMarket::packSymbols(loads, 2);
+    ASSERT_EQ(placement.size(), 5u);
+    // 100 | 90 -> 100 | 100 -> 110 | 100 -> 110 | 105
+    EXPECT_EQ(placement[1], 0u);
+    EXPECT_EQ(placement[2], 1u);
+    EXPECT_EQ(placement[3], 1u);
+    EXPECT_EQ(placement[4], 0u);
+    EXPECT_EQ(placement[5], 1u);
+    EXPECT_TRUE(ConcurrentMarket::packSymbols(SymbolLoads(), 3).empty());
+}
+
+TEST(ConcurrentMarketTest, placedSymbolsKeepTheirOrder) {
+    ConcurrentMarket concurrent_market(2);
+    // Round robin would put the two busy symbols 1 and 3 on the same worker.
+    concurrent_market.placeSymbols({{1, 100}, {2, 1}, {3, 100}, {4, 1}});
+    Market market;
+    trade(market);
+    trade(concurrent_market);
+    EXPECT_NE(concurrent_market.getWorker(1), concurrent_market.getWorker(3));
+    concurrent_market.addSymbol(5, "000005", 100, 0);
+    concurrent_market.addSymbol(6, "000006", 100, 0);
+    // Unplanned symbols are dealt out round robin.
+    EXPECT_NE(concurrent_market.getWorker(5), concurrent_market.getWorker(6));
+    concurrent_market.sync();
+    for (uint32_t symbol = 1; symbol <= 4; ++symbol) {
+        EXPECT_EQ(concurrent_market.getBasePrice(symbol, OrderSide::Bid),
+                  market.getBasePrice(symbol, OrderSide::Bid));
+        EXPECT_EQ(concurrent_market.calculatePnl(symbol), market.calculatePnl(symbol));
+    }
+
+    // The loads measured in this session plan the next one.
+    SymbolLoads measured = concurrent_market.measuredLoads();
+    EXPECT_EQ(measured.size(), 6u);
+    std::vector<uint64_t> busy = concurrent_market.busyNanoseconds();
+    ASSERT_EQ(busy.size(), 2u);
+    uint64_t total = 0;
+    for (const auto &[symbol, load] : measured) total += load;
+    EXPECT_GT(total, 0u);
+    EXPECT_LE(total, busy[0] + busy[1]);
+    ConcurrentMarket next_market(2);
+    next_market.placeSymbols(measured);
+    trade(next_market);
+    next_market.sync();
+    EXPECT_EQ(next_market.calculatePnl(4), market.calculatePnl(4));
+}
+
+TEST(ConcurrentMarketTest, countsEventsOfOrderLog) {
+    std::vector<IO::order_log> rows(5);
+    const char *instruments[] = {"000002", "000001", "000002", "000002", "000003"};
+    for (size_t i = 0; i < rows.size(); ++i) {
+        std::memset(rows[i].instrument_id, 0, sizeof(rows[i].instrument_id));
+        std::strcpy(rows[i].instrument_id, instruments[i]);
+    }
+    // 000003 is not in prev_trade_info, the replay drops its rows.
+    std::vector<IO::prev_trade_info> prev_infos(2);
+    std::strcpy(prev_infos[0].instrument_id, "000001");
+    std::strcpy(prev_infos[1].instrument_id, "000002");
+    SymbolLoads loads = countSymbolEvents(rows, IO::SymbolTable(prev_infos));
+    ASSERT_EQ(loads.size(), 2u);
+    EXPECT_EQ(loads[0], 1u);
+    EXPECT_EQ(loads[1], 3u);
+}
+
+TEST(ConcurrentMarketTest, commandsArePlainBytes) {
+    MarketCommand command{};
+    command.setSymbolName("a symbol name longer than fifteen characters");
+    EXPECT_EQ(std::string(command.add_symbol.name), "a symbol name l");
+    Order order = Order::newOrder(OrderType::LIMIT, OrderSide::Bid, 7, 3, 100, 1234);
+    command.symbol_id = 3;
+    command.setOrder(order);
+    Order decoded = command.order();
+    EXPECT_EQ(decoded.getOrderID(), 7u);
+    EXPECT_EQ(decoded.getSymbolID(), 3u);
+    EXPECT_EQ(decoded.getQuantity(), 100u);
+    EXPECT_EQ(decoded.getPrice(), 1234u);
+    EXPECT_EQ(decoded.getSide(), OrderSide::Bid);
+    EXPECT_EQ(decoded.getType(), OrderType::LIMIT);
+    EXPECT_LE(sizeof(MarketCommand), 128u);
+}
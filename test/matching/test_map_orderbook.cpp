@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 #define private public
 #include "map_orderbook.h"
 #undef private
@@ -435,6 +437,48 @@ TEST(MapOrderBookTest, top5Match_exceed) {
     EXPECT_TRUE(mapOrderBook.getBidLevels().empty());
 }
 
+// Records what a book reports, as "L <side> <price> <volume>" and "T <price> <quantity>".
+struct RecordingListener : BookListener {
+    std::vector<std::string> events;
+
+    void onLevel(uint32_t, OrderSide side, uint64_t price, uint64_t volume) override {
+        events.push_back("L " + std::string(side == OrderSide::Ask ? "ask " : "bid ") +
+                         std::to_string(price) + " " + std::to_string(volume));
+    }
+
+    void onTrade(uint32_t, uint64_t price, uint64_t quantity) override {
+        events.push_back("T " + std::to_string(price) + " " + std::to_string(quantity));
+    }
+};
+
+TEST(MapOrderBookTest, listenerSeesLevelsAndTrades) {
+    uint32_t symbol = 1;
+    MapOrderBook mapOrderBook = MapOrderBook(symbol, 100, 0);
+    RecordingListener listener;
+    mapOrderBook.setListener(&listener);
+
+    mapOrderBook.addOrder(Order::newOrder(OrderType::LIMIT, OrderSide::Ask, 1, symbol, 300, 100));
+    mapOrderBook.addOrder(Order::newOrder(OrderType::LIMIT, OrderSide::Ask, 2, symbol, 100, 101));
+    // Partly executes the first ask and does not rest.
+    mapOrderBook.addOrder(Order::newOrder(OrderType::LIMIT, OrderSide::Bid, 3, symbol, 200, 100));
+    // Executes the rest of the first ask and half of the second one.
+    mapOrderBook.addOrder(Order::newOrder(OrderType::LIMIT, OrderSide::Bid, 4, symbol, 150, 101));
+    mapOrderBook.deleteOrder(2);
+
+    std::vector<std::string> expected = {
+        "L ask 100 300", "L ask 101 100",
+        "T 100 200", "L ask 100 100",
+        "T 100 100", "L ask 100 0", "T 101 50", "L ask 101 50",
+        "L ask 101 0",
+    };
+    EXPECT_EQ(listener.events, expected);
+
+    // Without a listener nothing is reported.
+    mapOrderBook.setListener(nullptr);
+    mapOrderBook.addOrder(Order::newOrder(OrderType::LIMIT, OrderSide::Bid, 5, symbol, 10, 99));
+    EXPECT_EQ(listener.events.size(), expected.size());
+}
+
 int main (int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
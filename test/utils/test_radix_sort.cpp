@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "utils/radix_sort.h"
+#include "utils/sort.h"
+
+using namespace UBIEngine;
+
+namespace {
+/* Orders in time order with ties, like the replay emits them; `late` of them are delayed. */
+std::vector<IO::twap_order> makeOrders(size_t count, size_t late, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<IO::twap_order> orders(count);
+    long timestamp = -5;  // A few negative timestamps as well.
+    for (size_t i = 0; i < count; ++i) {
+        if (rng() % 4 == 0) timestamp += rng() % 3000;
+        std::memset(orders[i].instrument_id, 0, 8);
+        std::snprintf(orders[i].instrument_id, 8, "%06u", static_cast<unsigned>(rng() % 300));
+        orders[i].timestamp = timestamp;
+        orders[i].volume = static_cast<int>(i);  // Tells equal keys apart.
+    }
+    for (size_t i = 0; i < late; ++i) {
+        orders[rng() % count].timestamp -= rng() % 100000;
+    }
+    return orders;
+}
+
+std::vector<IO::twap_order> stableReference(std::vector<IO::twap_order> orders) {
+    std::stable_sort(orders.begin(), orders.end(), Utils::my_compare_twap);
+    return orders;
+}
+
+void expectSame(const std::vector<IO::twap_order>& a, const std::vector<IO::twap_order>& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        ASSERT_EQ(a[i].timestamp, b[i].timestamp) << i;
+        ASSERT_EQ(std::strncmp(a[i].instrument_id, b[i].instrument_id, 8), 0) << i;
+        ASSERT_EQ(a[i].volume, b[i].volume) << i;
+    }
+}
+}  // namespace
+
+TEST(RadixSortTest, keyOrderMatchesStrncmp) {
+    const char* ids[] = {"", "0", "000001", "000002", "00001", "600000", "zzzzzzzz", "\xff"};
+    for (const char* a : ids) {
+        for (const char* b : ids) {
+            char x[8] = {}, y[8] = {};
+            std::memcpy(x, a, std::min<size_t>(std::strlen(a), 8));
+            std::memcpy(y, b, std::min<size_t>(std::strlen(b), 8));
+            EXPECT_EQ(Utils::instrumentSortKey(x) < Utils::instrumentSortKey(y),
+                      std::strncmp(x, y, 8) < 0)
+                << a << " " << b;
+        }
+    }
+}
+
+TEST(RadixSortTest, radixSortIsStable) {
+    for (unsigned threads : {1u, 4u}) {
+        for (size_t count : {0ul, 1ul, 100ul, 300000ul}) {
+            auto orders = makeOrders(count, count, 7);
+            std::shuffle(orders.begin(), orders.end(), std::mt19937(1));
+            auto expected = stableReference(orders);
+            Utils::radixSort(orders, Utils::twapSortKey, threads);
+            expectSame(orders, expected);
+        }
+    }
+}
+
+TEST(RadixSortTest, nearlySorted) {
+    // Sorted by time, a few late orders, and too many late orders for the fast path.
+    for (size_t late : {0ul, 50ul, 100000ul}) {
+        auto orders = makeOrders(200000, late, 11);
+        auto expected = stableReference(orders);
+        Utils::sortNearlySorted(orders, Utils::twapSortKey, 4);
+        expectSame(orders, expected);
+    }
+}
+
+TEST(RadixSortTest, pnls) {
+    constexpr size_t kCount = 500;  // A constant, so the ids provably fit in 8 bytes.
+    std::vector<IO::pnl_and_pos> pnls(kCount);
+    for (size_t i = 0; i < kCount; ++i) {
+        std::memset(pnls[i].instrument_id, 0, 8);
+        std::snprintf(pnls[i].instrument_id, 8, "%06zu", (i * 7919) % kCount);
+    }
+    Utils::sortPnls(pnls);
+    EXPECT_TRUE(std::is_sorted(pnls.begin(), pnls.end(), Utils::my_compare_pnl));
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "utils/seqlock.h"
+#include "utils/spsc_queue.h"
+#include "utils/thread_pool.h"
+
+using namespace UBIEngine;
+
+namespace {
+struct Snapshot {
+    uint64_t fields[5];
+    bool flag;
+};
+}  // namespace
+
+TEST(SeqLockTest, readsAreNeverTorn) {
+    Concurrent::SeqLock<Snapshot> lock(Snapshot{{0, 0, 0, 0, 0}, true});
+    constexpr uint64_t kWrites = 200000;
+    std::thread writer([&] {
+        for (uint64_t i = 1; i <= kWrites; ++i) lock.store(Snapshot{{i, i, i, i, i}, i % 2 == 0});
+    });
+    uint64_t last = 0;
+    while (last != kWrites) {
+        Snapshot snapshot = lock.load();
+        for (uint64_t field : snapshot.fields) ASSERT_EQ(field, snapshot.fields[0]);
+        ASSERT_EQ(snapshot.flag, snapshot.fields[0] % 2 == 0);
+        // The writer's stores are seen in order.
+        ASSERT_GE(snapshot.fields[0], last);
+        last = snapshot.fields[0];
+    }
+    writer.join();
+}
+
+TEST(SpscQueueTest, batchPop) {
+    Concurrent::SpscQueue<std::unique_ptr<int>> queue(8);
+    EXPECT_EQ(queue.capacity(), 8u);
+    for (int i = 0; i < 8; ++i) EXPECT_TRUE(queue.tryPush(std::make_unique<int>(i)));
+    EXPECT_FALSE(queue.tryPush(std::make_unique<int>(8)));
+
+    std::vector<int> popped;
+    auto collect = [&](std::unique_ptr<int>& value) { popped.push_back(*value); };
+    EXPECT_EQ(queue.tryPopBatch(collect, 5), 5u);
+    EXPECT_EQ(popped, (std::vector<int>{0, 1, 2, 3, 4}));
+    // The slots are free again and wrap around.
+    for (int i = 8; i < 13; ++i) EXPECT_TRUE(queue.tryPush(std::make_unique<int>(i)));
+    EXPECT_EQ(queue.tryPopBatch(collect, 100), 8u);
+    EXPECT_EQ(queue.tryPopBatch(collect, 100), 0u);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(popped.size(), 13u);
+    for (int i = 0; i < 13; ++i) EXPECT_EQ(popped[i], i);
+}
+
+TEST(SpscQueueTest, acrossThreads) {
+    constexpr uint64_t kCount = 200000;
+    Concurrent::SpscQueue<uint64_t> queue(64);  // Small, so the producer waits for room.
+    std::thread producer([&] {
+        for (uint64_t i = 1; i <= kCount; ++i) queue.push(i);
+    });
+    uint64_t expected = 1;
+    bool in_order = true;
+    while (expected <= kCount) {
+        if (queue.tryPopBatch([&](uint64_t& value) { in_order &= value == expected++; }, 16) == 0)
+            std::this_thread::yield();
+    }
+    producer.join();
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(queue.empty());
+}
+
+template <typename Pool>
+class ThreadPoolTest : public ::testing::Test {};
+
+using PoolTypes = ::testing::Types<Concurrent::ThreadPool, Concurrent::SpscThreadPool>;
+TYPED_TEST_SUITE(ThreadPoolTest, PoolTypes);
+
+TYPED_TEST(ThreadPoolTest, runsTasksOfAQueueInOrder) {
+    constexpr uint32_t kThreads = 3;
+    constexpr int kTasks = 20000;
+    std::vector<std::vector<int>> seen(kThreads);
+    {
+        TypeParam pool(kThreads, 256);
+        for (int i = 0; i < kTasks; ++i) {
+            uint32_t queue = i % kThreads;
+            pool.submitTask(queue, [&seen, queue, i] { seen[queue].push_back(i); });
+        }
+        auto answer = pool.submitWaitableTask(1, [](int x) { return x * 2; }, 21);
+        EXPECT_EQ(answer.get(), 42);
+        // The destructor lets the workers finish their queues.
+    }
+    for (uint32_t queue = 0; queue < kThreads; ++queue) {
+        ASSERT_EQ(seen[queue].size(), size_t(kTasks / kThreads + (queue < kTasks % kThreads)));
+        for (size_t j = 0; j < seen[queue].size(); ++j)
+            EXPECT_EQ(seen[queue][j], int(queue + j * kThreads));
+    }
+}
+
+TYPED_TEST(ThreadPoolTest, releasesTasksAfterRunning) {
+    auto owned = std::make_shared<int>(7);
+    TypeParam pool(1);
+    auto done = pool.submitWaitableTask(0, [owned] { return *owned; });
+    EXPECT_EQ(done.get(), 7);
+    // Wait until the worker dropped the task and its copy of `owned`.
+    while (owned.use_count() != 1) std::this_thread::yield();
+    SUCCEED();
+}